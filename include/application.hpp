@@ -35,5 +35,6 @@ private:
 
     SDL_Window* _window = nullptr;
     bool _exitRequested = false;
+    bool _editorCursorMode = false;
     float _frameTime {};
 };
@@ -1,5 +1,6 @@
 #pragma once
 #include <glm/mat4x4.hpp>
+#include <optional>
 #include "acceleration_structure.hpp"
 #include "resources/gpu_resources.hpp"
 #include "common.hpp"
@@ -20,12 +21,17 @@ struct BLASInput
 {
     BLASType type = BLASType::eMesh;
     glm::mat4 transform {};
-    GeometryNodeCreation node {};
-    vk::AccelerationStructureGeometryKHR geometry {};
-    vk::AccelerationStructureBuildRangeInfoKHR info {};
+
+    // Every geometry has its own node and build range, at the same index
+    std::vector<GeometryNodeCreation> nodes {};
+    std::vector<vk::AccelerationStructureGeometryKHR> geometries {};
+    std::vector<vk::AccelerationStructureBuildRangeInfoKHR> infos {};
 
     // Optional structure used to give lss data as it isn't considered geometry for AccelerationStructureBuildRangeInfoKHR, but as a next structure
     vk::AccelerationStructureGeometryLinearSweptSpheresDataNV lssInfo {};
+
+    // Optional transform applied to the vertices of all triangle geometries while building, used to dequantize positions
+    std::optional<glm::mat4> geometryTransform {};
 };
 
 class BottomLevelAccelerationStructure : public AccelerationStructure
@@ -40,11 +46,15 @@ public:
     [[nodiscard]] vk::AccelerationStructureKHR Structure() const { return _vkStructure; }
     [[nodiscard]] BLASType Type() const { return _type; }
     [[nodiscard]] const glm::mat4& Transform() const { return _transform; }
+    [[nodiscard]] uint32_t FirstGeometryIndex() const { return _firstGeometryIndex; }
+    [[nodiscard]] uint32_t GeometryCount() const { return _geometryCount; }
 
 private:
     void InitializeStructure(const BLASInput& input);
 
     BLASType _type = BLASType::eMesh;
     glm::mat4 _transform {};
+    uint32_t _firstGeometryIndex {};
+    uint32_t _geometryCount {};
     std::shared_ptr<VulkanContext> _vulkanContext;
 };
@@ -0,0 +1,18 @@
+#pragma once
+
+// Kernels written with intrinsics are compiled for their instruction set with the target macros and picked at runtime with the checks below,
+// so the rest of the build doesn't have to assume more than the base instruction set
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VKHRT_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define TARGET_SSE4
+#define TARGET_AVX2
+#else
+#define TARGET_SSE4 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+[[nodiscard]] bool IsAVX2Supported();
+[[nodiscard]] bool IsSSE4Supported();
+#endif
@@ -1,5 +1,6 @@
 #pragma once
 #include "common.hpp"
+#include "resources/model/geometry_processor.hpp"
 #include <memory>
 
 class Application;
@@ -16,6 +17,9 @@ public:
     void Update();
 
 private:
+    void UpdateSceneInformation();
+    void UpdateHairSettings();
+
     struct SceneInformation
     {
         uint32_t trianglePrimitivesCount;
@@ -25,6 +29,10 @@ private:
     } _sceneInformation {};
     bool _lssSupported = false;
 
+    // Hair settings being edited, only applied to the renderer on request
+    HairSettings _hairSettings {};
+    HairTechnique _hairTechnique {};
+
     const Application& _application;
     std::shared_ptr<VulkanContext> _vulkanContext;
     std::shared_ptr<Renderer> _renderer;
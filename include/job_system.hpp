@@ -0,0 +1,63 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common.hpp"
+
+struct JobCounter
+{
+    std::atomic<uint32_t> pendingJobs { 0 };
+};
+
+// Thread pool where every worker owns a job queue and steals from the other queues when it runs dry
+class JobSystem
+{
+public:
+    using Job = std::function<void()>;
+
+    explicit JobSystem(uint32_t workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1);
+    ~JobSystem();
+    NON_COPYABLE(JobSystem);
+    NON_MOVABLE(JobSystem);
+
+    void Submit(Job job, JobCounter& counter);
+
+    // Executes queued jobs on the calling thread until all jobs of the counter are finished
+    void Wait(const JobCounter& counter);
+
+    // Splits [0, count) into ranges of at most grainSize elements and blocks until all of them are processed
+    void ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t begin, uint32_t end)>& function);
+
+    [[nodiscard]] uint32_t WorkerCount() const { return _workers.size(); }
+
+    // Number of threads that can execute jobs at the same time, including the waiting thread
+    [[nodiscard]] uint32_t ThreadCount() const { return _workers.size() + 1; }
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex mutex {};
+        std::deque<Job> jobs {};
+    };
+
+    void WorkerLoop(uint32_t workerIndex);
+    bool TryExecuteJob();
+    bool TryPopJob(uint32_t queueIndex, Job& job);
+    bool TryStealJob(uint32_t queueIndex, Job& job);
+
+    std::vector<std::unique_ptr<WorkerQueue>> _queues {};
+    std::vector<std::thread> _workers {};
+
+    std::atomic<uint32_t> _queuedJobs { 0 };
+    std::atomic<uint32_t> _nextQueue { 0 };
+    std::atomic<bool> _stopRequested { false };
+
+    std::mutex _sleepMutex {};
+    std::condition_variable _sleepCondition {};
+};
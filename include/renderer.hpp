@@ -2,7 +2,12 @@
 #include "vk_common.hpp"
 #include "common.hpp"
 #include "bottom_level_acceleration_structure.hpp"
+#include "resources/model/geometry_processor.hpp"
+#include <future>
+#include <glm/vec3.hpp>
 #include <memory>
+#include <optional>
+#include <string>
 #include <vulkan/vulkan.hpp>
 
 struct VulkanInitInfo;
@@ -15,6 +20,7 @@ class ModelLoader;
 class BottomLevelAccelerationStructure;
 class TopLevelAccelerationStructure;
 class BindlessResources;
+class JobSystem;
 
 class Renderer
 {
@@ -28,14 +34,63 @@ public:
 
     [[nodiscard]] const SwapChain& GetSwapChain() const { return *_swapChain; }
     [[nodiscard]] vk::RenderPass GetImGuiRenderPass() const { return _imguiRenderPass; }
-    [[nodiscard]] const std::vector<std::shared_ptr<Model>>& GetModels() const { return _models; }
+    [[nodiscard]] const std::vector<std::shared_ptr<Model>>& GetModels() const { return _scene.models; }
+
+    // Reprocesses the hair of the scene on a worker thread, the current scene keeps rendering until the rebuilt one is swapped in
+    void RequestHairRebuild(const HairSettings& hairSettings, HairTechnique hairTechnique);
+    [[nodiscard]] bool IsRebuildingHair() const { return _sceneRebuild.valid() || _requestedHairRebuild.has_value(); }
+    [[nodiscard]] const HairSettings& GetHairSettings() const { return _hairSettings; }
+    [[nodiscard]] HairTechnique GetHairTechnique() const { return _hairTechnique; }
+
+    // Loaded hair is only kept in memory while it is being edited, so rebuilds don't have to read the files again
+    void SetHairEditing(bool hairEditing) { _hairEditing = hairEditing; }
 
 private:
+    // Every geometry of a node gets one BLAS per level of detail, stored next to each other.
+    // Only the BLAS of the current level is instanced in the TLAS.
+    struct BLASLODChain
+    {
+        uint32_t firstBLAS {};
+        uint32_t levelCount {};
+        uint32_t currentLevel {};
+        glm::vec3 boundsCenter {};
+        float boundsRadius {};
+    };
+
+    // Everything the TLAS refers to, rebuilt and swapped as a whole
+    struct Scene
+    {
+        std::vector<std::shared_ptr<Model>> models {};
+        // BLASes of models that weren't rebuilt are shared with the scene they were first built for
+        std::vector<std::shared_ptr<const BottomLevelAccelerationStructure>> blases {};
+        std::vector<BLASLODChain> blasLODChains {};
+        std::vector<uint32_t> firstModelLODChains {}; // The LOD chains of a model follow each other, starting at the model's index here
+        std::unique_ptr<TopLevelAccelerationStructure> tlas;
+    };
+
+    struct RetiredScene
+    {
+        Scene scene {};
+        uint32_t retiredFrame {};
+    };
+
+    struct HairRebuildRequest
+    {
+        HairSettings settings {};
+        HairTechnique technique {};
+    };
+
     void RecordCommands(const vk::CommandBuffer& commandBuffer, uint32_t swapChainImageIndex, uint32_t currentResourceFrame);
     void RecordRayTracingCommands(const vk::CommandBuffer& commandBuffer, uint32_t currentResourceFrame);
     void RecordImGuiCommands(const vk::CommandBuffer& commandBuffer);
 
     void UpdateCameraResource(uint32_t currentResourceFrame);
+    void UpdateLODs();
+    void UpdateTLASDescriptor(uint32_t currentResourceFrame);
+
+    void StartHairRebuild();
+    void SwapRebuiltScene();
+    void ReleaseRetiredScenes();
 
     void InitializeCommandBuffers();
     void InitializeSynchronizationObjects();
@@ -49,7 +104,11 @@ private:
     void InitializeImGuiRenderPass();
     void InitializeImGuiFrameBuffer();
 
-    void InitializeBLAS();
+    // Builds the BLASes and TLAS of the models, selecting the levels of detail for the given camera. Can be called from a worker thread.
+    // Models that are also in the previous scene at the same index keep its BLASes, the previous scene needs no TLAS.
+    [[nodiscard]] Scene BuildScene(std::vector<std::shared_ptr<Model>>&& models, const Scene& previousScene, const glm::vec3& cameraPosition, float projectionScale) const;
+    void InitializeBLAS(Scene& scene, const Scene& previousScene) const;
+    [[nodiscard]] static std::vector<uint32_t> SelectedBLASes(const Scene& scene);
 
     std::shared_ptr<VulkanContext> _vulkanContext;
     std::unique_ptr<SwapChain> _swapChain;
@@ -61,16 +120,28 @@ private:
 
     uint32_t _renderedFrames = 0;
 
+    std::shared_ptr<JobSystem> _jobSystem;
     std::unique_ptr<ModelLoader> _modelLoader;
     std::shared_ptr<BindlessResources> _bindlessResources;
 
-    std::vector<std::shared_ptr<Model>> _models {};
-    std::vector<BottomLevelAccelerationStructure> _blases {};
-    std::unique_ptr<TopLevelAccelerationStructure> _tlas;
+    std::vector<std::string> _modelPaths {};
+    Scene _scene {};
     ResourceHandle<Image> _environmentMap;
 
+    HairSettings _hairSettings {};
+    HairTechnique _hairTechnique {};
+    bool _hairEditing = false;
+    std::optional<HairRebuildRequest> _requestedHairRebuild {};
+    std::future<Scene> _sceneRebuild {};
+    std::vector<RetiredScene> _retiredScenes {};
+    // Ranges of released retired scenes, only handed back to the bindless resources while no rebuild creates ranges
+    std::vector<ResourceRange> _pendingGeometryNodeReleases {};
+    std::vector<ResourceRange> _pendingBLASInstanceReleases {};
+
     vk::DescriptorSetLayout _descriptorSetLayout;
-    vk::DescriptorSet _descriptorSet;
+    // Every frame in flight has its own set, so the TLAS of a swapped scene can be bound without touching sets in use
+    std::array<vk::DescriptorSet, MAX_FRAMES_IN_FLIGHT> _descriptorSets;
+    std::array<vk::AccelerationStructureKHR, MAX_FRAMES_IN_FLIGHT> _boundTLASes;
 
     std::shared_ptr<FlyCamera> _flyCamera;
     std::unique_ptr<CameraResource> _cameraResource;
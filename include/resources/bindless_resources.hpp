@@ -2,6 +2,7 @@
 
 #include "resource_manager.hpp"
 #include "gpu_resources.hpp"
+#include <functional>
 #include <vulkan/vulkan.hpp>
 
 class VulkanContext;
@@ -31,6 +32,7 @@ class GeometryNodeResources : public ResourceManager<GeometryNode>
 public:
     GeometryNodeResources() = default;
     ResourceHandle<GeometryNode> Create(const GeometryNodeCreation& creation);
+    ResourceHandle<GeometryNode> CreateRange(const std::vector<GeometryNodeCreation>& creations);
 };
 
 class BLASInstanceResources : public ResourceManager<BLASInstance>
@@ -38,6 +40,7 @@ class BLASInstanceResources : public ResourceManager<BLASInstance>
 public:
     BLASInstanceResources() = default;
     ResourceHandle<BLASInstance> Create(const BLASInstanceCreation& creation);
+    ResourceHandle<BLASInstance> CreateRange(const std::vector<BLASInstanceCreation>& creations);
 };
 
 class BindlessResources
@@ -72,6 +75,7 @@ private:
     BLASInstanceResources _blasInstanceResources {};
 
     std::unique_ptr<Buffer> _materialBuffer;
+    uint32_t _materialBindingCapacity = MAX_RESOURCES;
     std::unique_ptr<Buffer> _geometryNodeBuffer;
     std::unique_ptr<Buffer> _blasInstanceBuffer;
 
@@ -85,6 +89,10 @@ private:
     void UploadMaterials();
     void UploadGeometryNodes();
     void UploadBLASInstances();
+    template <typename T>
+    void UploadDirtyRanges(ResourceManager<T>& resources, const Buffer& buffer, std::string_view stagingBufferName);
+    void WriteImageDescriptors(const std::vector<uint32_t>& indices, const std::function<const Image&(uint32_t)>& getImage);
+    void WriteBufferDescriptor(BindlessBinding binding, vk::DescriptorType type, const Buffer& buffer, vk::DeviceSize range = vk::WholeSize);
     void InitializeSet();
     void InitializeMaterialBuffer();
     void InitializeGeometryNodeBuffer();
@@ -191,7 +191,15 @@ struct GeometryNodeCreation
 {
     vk::DeviceAddress primitiveBufferDeviceAddress = 0;
     vk::DeviceAddress indexBufferDeviceAddress = 0;
+    vk::DeviceAddress curveStrandBufferDeviceAddress = 0;
     ResourceHandle<Material> material = ResourceHandle<Material>::Null();
+    float curveRadius = 0.0f;
+
+    // Quantized vertices decode to positionOffset + position * positionScale
+    bool quantizedVertices = false;
+    bool signedQuantizedVertices = false;
+    glm::vec3 positionOffset {};
+    glm::vec3 positionScale {};
 };
 
 struct GeometryNode
@@ -200,8 +208,13 @@ struct GeometryNode
 
     uint64_t primitiveBufferDeviceAddress = 0;
     uint64_t indexBufferDeviceAddress = 0;
+    uint64_t curveStrandBufferDeviceAddress = 0;
     uint32_t materialIndex = NULL_RESOURCE_INDEX_VALUE;
-    glm::vec3 _PADDING_{};
+    float curveRadius = 0.0f;
+    glm::vec3 positionOffset {};
+    uint32_t quantizedVertices = false;
+    glm::vec3 positionScale {};
+    uint32_t signedQuantizedVertices = false;
 };
 
 struct BLASInstance
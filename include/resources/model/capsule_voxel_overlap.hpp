@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+// Kernels (AVX2, SSE4.1 or scalar) are picked once at runtime based on the CPU
+
+// Segment swept by a sphere, the shape a strand segment is voxelized as
+struct Capsule
+{
+    glm::vec3 start {};
+    glm::vec3 end {};
+    float radius {};
+};
+
+// Whether the box overlaps the capsule, using the exact distance between the box and the capsule segment
+[[nodiscard]] bool CapsuleOverlapsBox(const Capsule& capsule, const glm::vec3& boxMin, const glm::vec3& boxMax);
+
+// Tests up to 64 consecutive voxels of a row along x against the capsule, several voxels at a time.
+// Bit i of the result is set when the voxel with its minimum corner at firstVoxelMin + (i * voxelSize, 0, 0) overlaps the capsule.
+[[nodiscard]] uint64_t CapsuleOverlapRow(const Capsule& capsule, const glm::vec3& firstVoxelMin, float voxelSize, uint32_t voxelCount);
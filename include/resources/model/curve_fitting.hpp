@@ -0,0 +1,13 @@
+#pragma once
+#include "model.hpp"
+
+// Kernels (AVX2, SSE4.1 or scalar) are picked once at runtime based on the CPU
+
+// Converts every segment of a strand into a cubic bezier curve using Catmull-Rom tangents.
+// Points are read straight from the strand buffer and (point count - 1) curves are written to the output.
+void FitStrandCurves(const StrandBuffer& strands, uint32_t strandIndex, float tension, Curve* curves);
+void FitStrandCurves(const StrandPoints& strand, float tension, Curve* curves);
+
+// Writes tight bounds for every curve, using the extrema found at the roots of the curve's derivative
+// instead of the control points, expanded by the curve radius
+void BoundCurves(const Curve* curves, uint32_t curveCount, float curveRadius, AABB* aabbs);
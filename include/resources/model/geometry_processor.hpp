@@ -1,8 +1,105 @@
 #pragma once
+#include "common.hpp"
 #include "model.hpp"
+#include "voxel_occupancy_grid.hpp"
 
-ModelCreation ProcessHairCurves(const ModelCreation& modelCreation);
-ModelCreation ProcessHairDOTS(const ModelCreation& modelCreation);
-ModelCreation ProcessHairVoxels(const ModelCreation& modelCreation);
-ModelCreation ProcessHairLSS(const ModelCreation& modelCreation);
-ModelCreation ProcessHairDebugMesh(const ModelCreation& modelCreation);
+class JobSystem;
+
+// Maximum distance between the resampled hair strands and the spline through the loaded strand points
+constexpr float DEFAULT_MAX_STRAND_DEVIATION = 0.002f;
+
+// Radius of the strands at full detail, pruned levels of detail grow it
+constexpr float DEFAULT_HAIR_RADIUS = 0.02f;
+
+// Edge length of the voxels hair is voxelized into
+constexpr float DEFAULT_VOXEL_SIZE = 0.1f;
+
+enum class HairTechnique : uint8_t
+{
+    eDOTS,
+    eLSS,
+    eCurves,
+    eVoxels,
+    eTubes,
+};
+
+// Which voxels a strand segment fills
+enum class VoxelizationMode : uint8_t
+{
+    // Every voxel of the boxes around the projected capsule radius along the segment
+    eConservativeBox,
+    // Only the voxels of those boxes that the capsule actually overlaps
+    eExact,
+};
+
+struct HairSettings
+{
+    // Every segment of a loaded strand is flattened into at most 1024 pieces, tighter deviations than that allows for a segment
+    // are not met and get logged
+    float maxStrandDeviation = DEFAULT_MAX_STRAND_DEVIATION;
+    float radius = DEFAULT_HAIR_RADIUS;
+    float voxelSize = DEFAULT_VOXEL_SIZE;
+    VoxelizationMode voxelization = VoxelizationMode::eExact;
+    // Logs how many fewer voxels exact voxelization fills than conservative boxes, which voxelizes every mesh a second time
+    bool reportVoxelReduction = false;
+};
+
+// Intermediate stages of hair processing, kept per mesh so processing a model again with other settings only reruns the stages that depend on them.
+// Every stage is keyed by a hash of its input and the settings it uses, a stage with a different key is recomputed along with the stages after it.
+class HairStageCache
+{
+public:
+    HairStageCache() = default;
+    ~HairStageCache() = default;
+    NON_COPYABLE(HairStageCache);
+
+    HairStageCache(HairStageCache&&) = default;
+    HairStageCache& operator=(HairStageCache&&) = default;
+
+    // Keeps a copy of the loaded model, so it can be processed again without loading it from file. Its strands are hashed once here.
+    void StoreSource(const ModelCreation& modelCreation);
+    [[nodiscard]] bool HasSource() const { return _source.sceneGraph != nullptr; }
+    [[nodiscard]] ModelCreation Source() const;
+
+    // Resampled strands of a mesh, recomputed when the stored source or the maximum deviation changed.
+    // The source strands have to be the ones of the stored source, without a stored source they are always resampled.
+    const StrandBuffer& ResampledStrands(uint32_t meshIndex, const StrandBuffer& sourceStrands, float maxStrandDeviation, JobSystem& jobSystem);
+
+    // Ordered strands of every segment level of detail of a mesh, recomputed when the resampled strands changed
+    const std::vector<StrandBuffer>& StrandLODs(uint32_t meshIndex, JobSystem& jobSystem);
+
+    // Drops the resampled strands of a mesh when only its levels of detail are still needed
+    void ReleaseResampledStrands(uint32_t meshIndex);
+
+    void SetMeshCount(uint32_t meshCount) { _meshes.resize(meshCount); }
+
+private:
+    struct MeshStages
+    {
+        uint64_t resampledKey {};
+        StrandBuffer resampledStrands {};
+
+        uint64_t lodKey {};
+        std::vector<StrandBuffer> lodStrands {};
+    };
+
+    ModelCreation _source {};
+    std::vector<uint64_t> _sourceKeys {};
+    std::vector<MeshStages> _meshes {};
+};
+
+// Processors consume the loaded model, so its buffers can be released as soon as they are processed.
+// When a stage cache is given, its stages are reused where their inputs didn't change and the stages that did get computed are stored in it.
+ModelCreation ProcessHairCurves(ModelCreation&& modelCreation, JobSystem& jobSystem, const HairSettings& settings = {}, HairStageCache* stageCache = nullptr);
+ModelCreation ProcessHairDOTS(ModelCreation&& modelCreation, JobSystem& jobSystem, const HairSettings& settings = {}, HairStageCache* stageCache = nullptr);
+ModelCreation ProcessHairVoxels(ModelCreation&& modelCreation, JobSystem& jobSystem, const HairSettings& settings = {}, HairStageCache* stageCache = nullptr);
+ModelCreation ProcessHairLSS(ModelCreation&& modelCreation, JobSystem& jobSystem, const HairSettings& settings = {}, HairStageCache* stageCache = nullptr);
+ModelCreation ProcessHairDebugMesh(ModelCreation&& modelCreation, JobSystem& jobSystem, const HairSettings& settings = {}, HairStageCache* stageCache = nullptr);
+
+// Processes the hair with the processor of the given technique
+ModelCreation ProcessHair(ModelCreation&& modelCreation, JobSystem& jobSystem, HairTechnique technique, const HairSettings& settings = {}, HairStageCache* stageCache = nullptr);
+
+// Voxelizes the strands of a single mesh into the grid that ProcessHairVoxels creates around its bounds, sparse and spread over the job system.
+// The serial version fills a dense grid on the calling thread without atomics, the parallel version has to set the same voxels.
+VoxelBrickMap VoxelizeHairStrands(const StrandBuffer& strands, const AABB& meshBounds, const HairSettings& settings, JobSystem& jobSystem);
+VoxelOccupancyGrid VoxelizeHairStrandsSerial(const StrandBuffer& strands, const AABB& meshBounds, const HairSettings& settings);
@@ -1,7 +1,9 @@
 #pragma once
 #include "resources/gpu_resources.hpp"
+#include "resources/model/voxel_brick_map.hpp"
 #include <glm/vec3.hpp>
 #include <glm/matrix.hpp>
+#include <array>
 
 struct Node
 {
@@ -28,6 +30,47 @@ struct Line
     glm::vec3 end {};
 };
 
+// Points of a single strand, every axis is a contiguous array
+struct StrandPoints
+{
+    const float* x {};
+    const float* y {};
+    const float* z {};
+    uint32_t count {};
+
+    [[nodiscard]] glm::vec3 Point(uint32_t index) const { return glm::vec3(x[index], y[index], z[index]); }
+};
+
+// Hair strands stored as a structure of arrays, where every strand is a contiguous range of points
+struct StrandBuffer
+{
+    std::vector<float> pointsX {};
+    std::vector<float> pointsY {};
+    std::vector<float> pointsZ {};
+
+    std::vector<uint32_t> strandOffsets {};
+    std::vector<uint32_t> strandPointCounts {};
+
+    // Starts a new strand, points added afterwards belong to it
+    void AddStrand();
+    void AddPoint(const glm::vec3& point);
+
+    [[nodiscard]] glm::vec3 Point(uint32_t index) const { return glm::vec3(pointsX[index], pointsY[index], pointsZ[index]); }
+    [[nodiscard]] uint32_t StrandCount() const { return strandOffsets.size(); }
+    [[nodiscard]] uint32_t PointCount() const { return pointsX.size(); }
+    [[nodiscard]] uint32_t SegmentCount() const;
+
+    [[nodiscard]] uint32_t FirstPoint(uint32_t strandIndex) const { return strandOffsets[strandIndex]; }
+    [[nodiscard]] StrandPoints Strand(uint32_t strandIndex) const
+    {
+        const uint32_t firstPoint = strandOffsets[strandIndex];
+        return { pointsX.data() + firstPoint, pointsY.data() + firstPoint, pointsZ.data() + firstPoint, strandPointCounts[strandIndex] };
+    }
+
+    // Index of the first segment of a strand when walking all segments of the buffer in order
+    [[nodiscard]] uint32_t FirstSegment(uint32_t strandIndex) const { return strandOffsets[strandIndex] - strandIndex; }
+};
+
 struct alignas(16) Curve
 {
     glm::vec3 start {};
@@ -37,6 +80,37 @@ struct alignas(16) Curve
 
     [[nodiscard]] glm::vec3 Sample(float t) const;
     [[nodiscard]] glm::vec3 SampleDerivitive(float t) const;
+
+    // Control points of the part of the curve between tMin and tMax
+    [[nodiscard]] Curve Segment(float tMin, float tMax) const;
+};
+
+// Curve as stored on the gpu, control points are 16 bit offsets from the root of its strand in units of the strand's scale
+struct QuantizedCurve
+{
+    std::array<int16_t, 12> offsets {}; // Start, control point 1, control point 2 and end
+};
+
+struct CurveStrand
+{
+    glm::vec3 root {};
+    float scale {};
+};
+
+// Part of a curve that is bounded by its own aabb, stored at the same index as that aabb
+struct CurvePrimitive
+{
+    uint32_t curveIndex {}; // Relative to the hair's first curve
+    uint32_t strandIndex {}; // Relative to the hair's first strand
+    float tMin {};
+    float tMax {};
+};
+
+// Spatially compact part of a geometry, every cluster becomes a separate geometry of the same BLAS
+struct GeometryCluster
+{
+    uint32_t firstPrimitive {}; // Relative to the geometry's first primitive
+    uint32_t primitiveCount {};
 };
 
 struct Mesh
@@ -48,19 +122,36 @@ struct Mesh
         glm::vec2 texCoord {};
     };
 
+    // Position quantized to 16 bits within the mesh's bounding box, the last component holds an optional octahedral tangent of 2 x 8 bits
+    struct QuantizedVertex
+    {
+        uint16_t x {};
+        uint16_t y {};
+        uint16_t z {};
+        uint16_t tangent {};
+    };
+
     enum class PrimitiveType : uint8_t
     {
         eTriangles,
         eLines,
     };
 
+    enum class VertexFormat : uint8_t
+    {
+        eFull,
+        eQuantized, // Vertices and indices refer to the quantized vertex buffer
+    };
+
     PrimitiveType primitiveType = PrimitiveType::eTriangles;
+    VertexFormat vertexFormat = VertexFormat::eFull;
     uint32_t indexCount {};
     uint32_t firstIndex {};
     uint32_t firstVertex {};
 
     ResourceHandle<Material> material {};
     AABB boundingBox {};
+    std::vector<GeometryCluster> clusters {}; // Triangle ranges, when empty the whole mesh is a single geometry
 
     [[nodiscard]] uint32_t GetIndicesPerFaceNum() const;
 };
@@ -70,28 +161,48 @@ struct Hair
 {
     uint32_t curveCount {};
     uint32_t firstCurve {};
+    uint32_t strandCount {};
+    uint32_t firstStrand {};
     uint32_t aabbCount {};
-    uint32_t firstAabb {};
+    uint32_t firstAabb {}; // Also the first curve primitive, since every aabb has one
+    float curveRadius {};
+    AABB boundingBox {};
+    std::vector<GeometryCluster> clusters {}; // Aabb ranges, when empty the whole hair is a single geometry
     ResourceHandle<Material> material {};
 };
 
-struct VoxelMesh
+// Level of the occupancy pyramid of a voxel mesh, every level ORs together 2x2x2 voxels of the level below it
+struct VoxelLevel
 {
-    glm::ivec3 voxelGridResolution {};
-    uint32_t firstVoxel {};
+    glm::ivec3 resolution {};
+    float voxelSize {};
+    uint32_t firstBrickIndex {}; // Brick index grid laid out as described by VoxelBrickMap, indices are relative to the first brick
+    uint32_t firstBrick {};
+    uint32_t brickCount {};
     uint32_t filledVoxelCount {};
 
-    uint32_t aabbCount {};
+    uint32_t aabbCount {}; // One aabb for every filled voxel
     uint32_t firstAabb {};
+};
+
+struct VoxelMesh
+{
+    glm::ivec3 voxelGridResolution {};
+    std::vector<VoxelLevel> levels {}; // Full resolution first, down to a single voxel
 
     AABB boundingBox {};
 	ResourceHandle<Material> material {};
 };
 
+// Every strand point is stored once, segments refer to their first point through the index buffer (successive indexing)
 struct LSSMesh
 {
     uint32_t vertexCount {};
     uint32_t firstVertex {};
+    uint32_t firstRadius {}; // Levels of detail can share positions while using their own radii
+    uint32_t indexCount {}; // Also the segment count
+    uint32_t firstIndex {};
+    AABB boundingBox {};
     ResourceHandle<Material> material {};
 };
 
@@ -108,19 +219,35 @@ struct SceneGraph
     std::vector<LSSMesh> lssMeshes {};
     std::vector<ResourceHandle<Image>> textures {};
     std::vector<ResourceHandle<Material>> materials {};
+
+    // Hair geometry can be stored once per level of detail, with level 0 being full detail.
+    // Nodes refer to level 0, level l of geometry i is stored at i + l * (geometry count / lodLevelCount).
+    uint32_t lodLevelCount = 1;
+
+    [[nodiscard]] uint32_t GetLODIndex(uint32_t geometryIndex, uint32_t level, uint32_t geometryCount) const { return geometryIndex + level * (geometryCount / lodLevelCount); }
+
+    // Copy with the node parent pointers pointing into its own nodes
+    [[nodiscard]] std::shared_ptr<SceneGraph> Clone() const;
 };
 
 struct ModelCreation
 {
     std::vector<Mesh::Vertex> vertexBuffer {};
+    std::vector<Mesh::QuantizedVertex> quantizedVertexBuffer {};
     std::vector<uint32_t> indexBuffer {};
 
-    std::vector<Curve> curveBuffer {};
-    std::vector<bool> voxelGridBuffer {};
+    std::vector<QuantizedCurve> curveBuffer {};
+    std::vector<CurveStrand> curveStrandBuffer {};
+    std::vector<CurvePrimitive> curvePrimitiveBuffer {};
+    std::vector<uint32_t> voxelBrickIndexBuffer {}; // Brick index grids of all voxel meshes
+    std::vector<VoxelBrick> voxelBrickBuffer {};
     std::vector<AABB> aabbBuffer {};
 
     std::vector<glm::vec3> lssPositionBuffer {};
     std::vector<float> lssRadiusBuffer {};
+    std::vector<uint32_t> lssIndexBuffer {}; // Relative to the lss mesh's first vertex
+
+    std::vector<StrandBuffer> strandBuffers {}; // Same order as scene graph meshes, empty for non-line meshes
 
     std::shared_ptr<SceneGraph> sceneGraph {};
 };
@@ -130,19 +257,34 @@ struct Model
     Model(const ModelCreation& creation, const std::shared_ptr<VulkanContext>& vulkanContext);
 
     std::unique_ptr<Buffer> vertexBuffer {};
+    std::unique_ptr<Buffer> quantizedVertexBuffer {};
     std::unique_ptr<Buffer> indexBuffer {};
     uint32_t vertexCount {};
+    uint32_t quantizedVertexCount {};
     uint32_t indexCount {};
+    // Quantized positions are stored as snorm when the device can't build acceleration structures from unorm vertices
+    bool signedQuantizedVertices = false;
 
     std::unique_ptr<Buffer> curveBuffer {};
+    std::unique_ptr<Buffer> curveStrandBuffer {};
+    std::unique_ptr<Buffer> curvePrimitiveBuffer {};
     std::unique_ptr<Buffer> aabbBuffer {};
     uint32_t curveCount {};
+    uint32_t curveStrandCount {};
+    uint32_t curvePrimitiveCount {};
     uint32_t aabbCount {};
 
+    std::unique_ptr<Buffer> voxelBrickIndexBuffer {};
+    std::unique_ptr<Buffer> voxelBrickBuffer {};
+    uint32_t voxelBrickIndexCount {};
+    uint32_t voxelBrickCount {};
+
     std::unique_ptr<Buffer> lssPositionBuffer {};
     std::unique_ptr<Buffer> lssRadiusBuffer {};
+    std::unique_ptr<Buffer> lssIndexBuffer {};
     uint32_t lssPositionCount {};
     uint32_t lssRadiusCount {};
+    uint32_t lssIndexCount {};
 
     std::shared_ptr<SceneGraph> sceneGraph {};
 };
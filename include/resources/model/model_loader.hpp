@@ -2,29 +2,58 @@
 #include "common.hpp"
 #include "resources/resource_manager.hpp"
 #include "model.hpp"
+#include "geometry_processor.hpp"
 #include <assimp/Importer.hpp>
 #include <unordered_map>
 
 class VulkanContext;
 class BindlessResources;
+class JobSystem;
 struct aiScene;
 
 class ModelLoader
 {
 public:
-    ModelLoader(const std::shared_ptr<BindlessResources>& bindlessResources, const std::shared_ptr<VulkanContext>& vulkanContext);
+    ModelLoader(const std::shared_ptr<BindlessResources>& bindlessResources, const std::shared_ptr<VulkanContext>& vulkanContext, const std::shared_ptr<JobSystem>& jobSystem);
     ~ModelLoader() = default;
     NON_COPYABLE(ModelLoader);
     NON_MOVABLE(ModelLoader);
 
-    [[nodiscard]] std::shared_ptr<Model> LoadFromFile(std::string_view path);
+    // Hair models are processed with the given settings. While hair sources are retained, their loaded strands and processing stages
+    // are cached per path, so loading the same hair again skips reading the file and only reruns the stages that depend on changed settings.
+    // The loader isn't thread safe, but can be used from any thread as long as only one uses it at a time.
+    [[nodiscard]] std::shared_ptr<Model> LoadFromFile(std::string_view path, const HairSettings& hairSettings = {});
+
+    // Processes the hair of a loaded model file again, from the retained source or else from file.
+    // Returns nullptr when the file wasn't loaded as hair.
+    [[nodiscard]] std::shared_ptr<Model> ReprocessHair(std::string_view path, const HairSettings& hairSettings, HairTechnique hairTechnique);
+
+    // Whether the sources and processing stages of hair are kept after processing, which takes about as much memory as the loaded hair.
+    // Off by default, turning it off releases everything that was retained.
+    void SetRetainHairSources(bool retainHairSources);
+
+    // Technique hair is loaded with, linear swept spheres when the device supports them
+    [[nodiscard]] HairTechnique DefaultHairTechnique() const;
 
 private:
-    [[nodiscard]] ModelCreation LoadModel(const aiScene* scene, const std::string_view directory);
-    [[nodiscard]] std::shared_ptr<Model> ProcessModel(const ModelCreation& modelCreation);
+    struct LoadedMaterials
+    {
+        std::vector<ResourceHandle<Material>> materials {};
+        std::vector<ResourceHandle<Image>> textures {};
+    };
+
+    [[nodiscard]] std::shared_ptr<Model> LoadModelFile(std::string_view path, const HairSettings& hairSettings, HairTechnique hairTechnique);
+    // Creates the materials of the scene, unless those of an earlier load of the same file are given
+    [[nodiscard]] ModelCreation LoadModel(const aiScene* scene, const std::string_view directory, const LoadedMaterials* loadedMaterials);
+    [[nodiscard]] std::shared_ptr<Model> ProcessModel(ModelCreation&& modelCreation, std::string_view path, const HairSettings& hairSettings, HairTechnique hairTechnique);
 
     Assimp::Importer _importer {};
     std::unordered_map<std::string_view, ResourceHandle<Image>> _imageCache {};
+    // Materials of every file loaded as hair, reprocessing the hair reuses them instead of creating new ones
+    std::unordered_map<std::string, LoadedMaterials> _hairMaterials {};
+    std::unordered_map<std::string, HairStageCache> _hairStageCaches {};
+    bool _retainHairSources = false;
     std::shared_ptr<VulkanContext> _vulkanContext;
     std::shared_ptr<BindlessResources> _bindlessResources;
+    std::shared_ptr<JobSystem> _jobSystem;
 };
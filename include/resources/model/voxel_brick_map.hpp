@@ -0,0 +1,104 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include <span>
+#include <vector>
+
+class JobSystem;
+class VoxelOccupancyGrid;
+
+// Occupancy of 8x8x8 voxels in 512 bits. Word z holds the slice at that z, with voxel (x, y) of the slice at bit y * 8 + x.
+struct VoxelBrick
+{
+    static constexpr int32_t SIZE = 8;
+
+    std::array<uint64_t, SIZE> words {};
+
+    [[nodiscard]] bool IsEmpty() const { return words == std::array<uint64_t, SIZE> {}; }
+};
+
+// Sparse occupancy of a voxel grid, a two level map: a dense grid with a brick index for every 8x8x8 voxels of the grid,
+// and bricks only for the parts where voxels are set. Hair only fills a thin shell of its bounds, so most brick indices stay empty.
+// Bricks are allocated up front with AllocateBricks, after which voxels can be set from multiple threads without allocating.
+class VoxelBrickMap
+{
+public:
+    static constexpr uint32_t EMPTY_BRICK = UINT32_MAX;
+
+    VoxelBrickMap() = default;
+    explicit VoxelBrickMap(const glm::ivec3& resolution);
+
+    // Brick that holds the voxel, voxels outside the grid give bricks outside the brick grid
+    [[nodiscard]] static glm::ivec3 BrickOf(const glm::ivec3& voxel) { return { voxel.x >> 3, voxel.y >> 3, voxel.z >> 3 }; }
+
+    [[nodiscard]] const glm::ivec3& Resolution() const { return _resolution; }
+    [[nodiscard]] const glm::ivec3& BrickResolution() const { return _brickResolution; }
+    [[nodiscard]] std::span<const uint32_t> BrickIndices() const { return _brickIndices; }
+    [[nodiscard]] std::span<const VoxelBrick> Bricks() const { return _bricks; }
+
+    // Allocates a brick for every voxel set in a grid of brick resolution, in storage order
+    void AllocateBricks(const VoxelOccupancyGrid& brickOccupancy);
+    // Releases the bricks without any voxel set, keeping the remaining bricks in the same order
+    void RemoveEmptyBricks();
+
+    [[nodiscard]] bool Test(const glm::ivec3& voxel) const;
+
+    // ORs bits into the voxels wordInRow * 64 up to wordInRow * 64 + 63 of a row, bit b being voxel wordInRow * 64 + b.
+    // Voxels in bricks that aren't allocated are skipped. The atomic version can be called from multiple threads at once.
+    void SetRowWord(uint32_t wordInRow, int32_t y, int32_t z, uint64_t bits);
+    void SetRowWordAtomic(uint32_t wordInRow, int32_t y, int32_t z, uint64_t bits);
+    // Sets every voxel inside the inclusive box, parts outside the grid or allocated bricks are skipped
+    void SetBox(const glm::ivec3& min, const glm::ivec3& max);
+    void SetBoxAtomic(const glm::ivec3& min, const glm::ivec3& max);
+
+    [[nodiscard]] uint32_t FilledCount() const;
+    // Bytes taken by the brick indices and bricks
+    [[nodiscard]] size_t MemorySize() const { return _brickIndices.size() * sizeof(uint32_t) + _bricks.size() * sizeof(VoxelBrick); }
+
+    // Dense grid with the same voxels set, for debugging
+    [[nodiscard]] VoxelOccupancyGrid ToDense() const;
+
+    // Next level of an occupancy pyramid, at half the resolution. A voxel is set when any of the 2x2x2 voxels it covers is set.
+    // Bricks of the new level are reduced in parallel, every brick by a single job.
+    [[nodiscard]] VoxelBrickMap Downsample(JobSystem& jobSystem) const;
+
+    // Calls the function with the coordinates of every set voxel, brick by brick
+    template <typename Function>
+    void ForEachFilled(Function&& function) const
+    {
+        for (uint32_t brickIndex = 0; brickIndex < _brickIndices.size(); ++brickIndex)
+        {
+            if (_brickIndices[brickIndex] == EMPTY_BRICK)
+            {
+                continue;
+            }
+
+            const uint32_t brickRow = brickIndex / _brickResolution.x;
+            const glm::ivec3 brickOrigin = glm::ivec3(brickIndex % _brickResolution.x, brickRow % _brickResolution.y, brickRow / _brickResolution.y) * VoxelBrick::SIZE;
+            const VoxelBrick& brick = _bricks[_brickIndices[brickIndex]];
+            for (int32_t z = 0; z < VoxelBrick::SIZE; ++z)
+            {
+                for (uint64_t bits = brick.words[z]; bits != 0; bits &= bits - 1)
+                {
+                    const int32_t bit = std::countr_zero(bits);
+                    function(brickOrigin + glm::ivec3(bit % VoxelBrick::SIZE, bit / VoxelBrick::SIZE, z));
+                }
+            }
+        }
+    }
+
+private:
+    template <bool ATOMIC>
+    void SetRowWordBits(uint32_t wordInRow, int32_t y, int32_t z, uint64_t bits);
+    template <bool ATOMIC>
+    void SetBoxWords(const glm::ivec3& min, const glm::ivec3& max);
+
+    [[nodiscard]] uint32_t BrickIndex(const glm::ivec3& brick) const { return (brick.z * _brickResolution.y + brick.y) * _brickResolution.x + brick.x; }
+
+    glm::ivec3 _resolution {};
+    glm::ivec3 _brickResolution {};
+    std::vector<uint32_t> _brickIndices {};
+    std::vector<VoxelBrick> _bricks {};
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include <span>
+#include <vector>
+
+// Occupancy of a voxel grid with one bit per voxel, packed into 64 bit words.
+// Every row along x starts at a new word, so rows can be filled with whole word operations:
+// voxel (x, y, z) is bit x % 64 of word (z * resolution.y + y) * WordsPerRow() + x / 64.
+class VoxelOccupancyGrid
+{
+public:
+    static constexpr uint32_t BITS_PER_WORD = 64;
+
+    VoxelOccupancyGrid() = default;
+    explicit VoxelOccupancyGrid(const glm::ivec3& resolution);
+
+    // Bits from first up to and including last of a word
+    [[nodiscard]] static uint64_t BitRange(uint32_t first, uint32_t last) { return (~uint64_t { 0 } << first) & (~uint64_t { 0 } >> (BITS_PER_WORD - 1 - last)); }
+
+    // ORs bits into a word, atomically when the word can be written from multiple threads at once
+    template <bool ATOMIC>
+    static void OrWord(uint64_t& word, uint64_t bits)
+    {
+        if constexpr (ATOMIC)
+        {
+            // Joining the jobs that fill the grid orders these writes before any read, so they don't need to be ordered themselves
+            std::atomic_ref<uint64_t>(word).fetch_or(bits, std::memory_order_relaxed);
+        }
+        else
+        {
+            word |= bits;
+        }
+    }
+
+    [[nodiscard]] static uint32_t WordsPerRow(int32_t resolutionX) { return (resolutionX + BITS_PER_WORD - 1) / BITS_PER_WORD; }
+    [[nodiscard]] static uint32_t WordCount(const glm::ivec3& resolution) { return WordsPerRow(resolution.x) * resolution.y * resolution.z; }
+
+    [[nodiscard]] const glm::ivec3& Resolution() const { return _resolution; }
+    [[nodiscard]] uint32_t WordsPerRow() const { return _wordsPerRow; }
+    [[nodiscard]] std::span<const uint64_t> Words() const { return _words; }
+
+    [[nodiscard]] bool Test(const glm::ivec3& voxel) const;
+    void Set(const glm::ivec3& voxel);
+
+    // Sets the voxels from xMin up to and including xMax of a row, parts outside the grid are skipped
+    void SetRow(int32_t xMin, int32_t xMax, int32_t y, int32_t z);
+    // Sets every voxel inside the inclusive box, parts outside the grid are skipped
+    void SetBox(const glm::ivec3& min, const glm::ivec3& max);
+    // Same as SetBox, but can be called from multiple threads at once. Words are ORed atomically, so the result doesn't depend on the order.
+    void SetBoxAtomic(const glm::ivec3& min, const glm::ivec3& max);
+    // ORs bits into word wordInRow of a row, bit b of it being voxel wordInRow * 64 + b. The atomic version can be called from multiple threads at once.
+    void SetRowWord(uint32_t wordInRow, int32_t y, int32_t z, uint64_t bits);
+    void SetRowWordAtomic(uint32_t wordInRow, int32_t y, int32_t z, uint64_t bits);
+    // Whether any voxel from xMin up to and including xMax of a row is set
+    [[nodiscard]] bool TestRow(int32_t xMin, int32_t xMax, int32_t y, int32_t z) const;
+
+    // Sets every voxel that is set in a grid of the same resolution
+    void Union(const VoxelOccupancyGrid& other);
+    void Clear();
+
+    [[nodiscard]] uint32_t FilledCount() const;
+
+    // Calls the function with the coordinates of every set voxel, in storage order
+    template <typename Function>
+    void ForEachFilled(Function&& function) const
+    {
+        for (uint32_t word = 0; word < _words.size(); ++word)
+        {
+            const uint32_t row = word / _wordsPerRow;
+            const int32_t xBase = (word % _wordsPerRow) * BITS_PER_WORD;
+            for (uint64_t bits = _words[word]; bits != 0; bits &= bits - 1)
+            {
+                function(glm::ivec3(xBase + std::countr_zero(bits), row % _resolution.y, row / _resolution.y));
+            }
+        }
+    }
+
+private:
+    template <bool ATOMIC>
+    void SetBoxWords(const glm::ivec3& min, const glm::ivec3& max);
+
+    [[nodiscard]] uint32_t RowWord(int32_t y, int32_t z) const { return (z * _resolution.y + y) * _wordsPerRow; }
+    [[nodiscard]] bool IsInside(int32_t y, int32_t z) const { return y >= 0 && y < _resolution.y && z >= 0 && z < _resolution.z; }
+
+    glm::ivec3 _resolution {};
+    uint32_t _wordsPerRow {};
+    std::vector<uint64_t> _words {};
+};
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
+#include <utility>
 #include <vector>
 
 constexpr uint32_t NULL_RESOURCE_INDEX_VALUE = 0xFFFF;
@@ -15,6 +18,13 @@ struct ResourceHandle
     uint32_t handle = NULL_RESOURCE_INDEX_VALUE;
 };
 
+// Resources next to each other in a resource manager
+struct ResourceRange
+{
+    uint32_t first {};
+    uint32_t count {};
+};
+
 template<typename T>
 class ResourceManager
 {
@@ -23,14 +33,78 @@ public:
     const T& Get(ResourceHandle<T> handle) const { return _resources[handle.handle]; }
     const std::vector<T>& GetAll() const { return _resources; }
 
+    // Ranges of resources created since the last call, so only those have to be uploaded
+    [[nodiscard]] bool HasDirtyRanges() const { return !_dirtyRanges.empty(); }
+    [[nodiscard]] std::vector<ResourceRange> TakeDirtyRanges() { return std::exchange(_dirtyRanges, {}); }
+
+    // Makes a range of resources available for later ranges, nothing may refer to them anymore
+    void ReleaseRange(ResourceHandle<T> first, uint32_t count)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        _freeRanges.push_back({ first.handle, count });
+        std::sort(_freeRanges.begin(), _freeRanges.end(), [](const ResourceRange& a, const ResourceRange& b)
+            { return a.first < b.first; });
+
+        // Merge neighbouring ranges, so ranges of a different size can reuse them as well
+        std::vector<ResourceRange> merged {};
+        for (const ResourceRange& range : _freeRanges)
+        {
+            if (!merged.empty() && merged.back().first + merged.back().count == range.first)
+            {
+                merged.back().count += range.count;
+            }
+            else
+            {
+                merged.push_back(range);
+            }
+        }
+        _freeRanges = std::move(merged);
+    }
+
 protected:
     ResourceHandle<T> Create(T&& resource)
     {
         uint32_t index = _resources.size();
         _resources.push_back(std::move(resource));
+        _dirtyRanges.push_back({ index, 1 });
+        return ResourceHandle<T>{ index };
+    }
+
+    // Stores the resources next to each other, in the first released range that fits them or else at the end
+    ResourceHandle<T> CreateRange(std::vector<T>&& resources)
+    {
+        const uint32_t count = resources.size();
+        const auto freeRange = std::find_if(_freeRanges.begin(), _freeRanges.end(), [count](const ResourceRange& range)
+            { return range.count >= count; });
+
+        if (count == 0 || freeRange == _freeRanges.end())
+        {
+            const uint32_t index = _resources.size();
+            std::move(resources.begin(), resources.end(), std::back_inserter(_resources));
+            _dirtyRanges.push_back({ index, count });
+            return ResourceHandle<T>{ index };
+        }
+
+        const uint32_t index = freeRange->first;
+        std::move(resources.begin(), resources.end(), _resources.begin() + index);
+        _dirtyRanges.push_back({ index, count });
+
+        freeRange->first += count;
+        freeRange->count -= count;
+        if (freeRange->count == 0)
+        {
+            _freeRanges.erase(freeRange);
+        }
+
         return ResourceHandle<T>{ index };
     }
 
 private:
     std::vector<T> _resources {};
+    std::vector<ResourceRange> _freeRanges {};
+    std::vector<ResourceRange> _dirtyRanges {};
 };
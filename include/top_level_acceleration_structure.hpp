@@ -1,23 +1,58 @@
 #pragma once
-#include "acceleration_structure.hpp"
 #include "common.hpp"
+#include "vk_common.hpp"
+#include <array>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.hpp>
 
 class VulkanContext;
 class BottomLevelAccelerationStructure;
 class BindlessResources;
+struct Buffer;
 
-class TopLevelAccelerationStructure : public AccelerationStructure
+class TopLevelAccelerationStructure
 {
 public:
-    TopLevelAccelerationStructure(const std::vector<BottomLevelAccelerationStructure>& blases, const std::shared_ptr<BindlessResources>& resources, const std::shared_ptr<VulkanContext>& vulkanContext);
+    // Instances hold the index of the BLAS they instance, every BLAS can be instanced by updating the instances later on
+    TopLevelAccelerationStructure(const std::vector<std::shared_ptr<const BottomLevelAccelerationStructure>>& blases, const std::vector<uint32_t>& instances, const std::shared_ptr<BindlessResources>& resources, const std::shared_ptr<VulkanContext>& vulkanContext);
     ~TopLevelAccelerationStructure();
     NON_COPYABLE(TopLevelAccelerationStructure);
     NON_MOVABLE(TopLevelAccelerationStructure);
 
-    [[nodiscard]] vk::AccelerationStructureKHR Structure() const { return _vkStructure; }
+    // Changes the instanced BLASes, the instance count can't change. Only marks the structures of the frames in flight as outdated,
+    // each of them is rebuilt by RecordPendingBuild of its own frame, so structures still in use by the GPU are never touched.
+    void UpdateInstances(const std::vector<std::shared_ptr<const BottomLevelAccelerationStructure>>& blases, const std::vector<uint32_t>& instances);
+
+    // Records the rebuild of the frame's structure when it is outdated, followed by a barrier that makes it visible to ray tracing.
+    // The previous commands of the frame must have completed, as its instance and scratch buffers are reused.
+    void RecordPendingBuild(vk::CommandBuffer commandBuffer, uint32_t frameIndex);
+
+    [[nodiscard]] vk::AccelerationStructureKHR Structure(uint32_t frameIndex) const { return _frames.at(frameIndex).structure; }
+
+    // Instance data of the BLASes is stored next to each other, starting at this index
+    [[nodiscard]] uint32_t FirstBLASInstanceIndex() const { return _firstBLASInstanceIndex; }
 
 private:
-    void InitializeStructure(const std::vector<BottomLevelAccelerationStructure>& blases, const std::shared_ptr<BindlessResources>& resources);
+    // Every frame in flight has its own structure and the buffers to build it
+    struct FrameStructure
+    {
+        vk::AccelerationStructureKHR structure {};
+        std::unique_ptr<Buffer> structureBuffer {};
+        std::unique_ptr<Buffer> scratchBuffer {};
+        std::unique_ptr<Buffer> instancesBuffer {};
+        bool outdated = false;
+    };
+
+    void InitializeStructures();
+    void WriteInstances(const std::vector<std::shared_ptr<const BottomLevelAccelerationStructure>>& blases, const std::vector<uint32_t>& instances);
+    void RecordBuild(vk::CommandBuffer commandBuffer, FrameStructure& frame);
+
+    [[nodiscard]] vk::AccelerationStructureGeometryKHR InstancesGeometry(const FrameStructure& frame) const;
 
+    uint32_t _instanceCount = 0;
+    uint32_t _firstBLASInstanceIndex = 0;
+    std::vector<vk::AccelerationStructureInstanceKHR> _instances {};
+    std::array<FrameStructure, MAX_FRAMES_IN_FLIGHT> _frames {};
     std::shared_ptr<VulkanContext> _vulkanContext;
 };
@@ -1,6 +1,9 @@
 #pragma once
 #include <functional>
+#include <mutex>
 #include <optional>
+#include <thread>
+#include <unordered_map>
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan.hpp>
 #include "common.hpp"
@@ -39,7 +42,12 @@ public:
     [[nodiscard]] vk::Queue GraphicsQueue() const { return _graphicsQueue; }
     [[nodiscard]] vk::Queue PresentQueue() const { return _presentQueue; }
     [[nodiscard]] vk::SurfaceKHR Surface() const { return _surface; }
-    [[nodiscard]] vk::CommandPool CommandPool() const { return _commandPool; }
+    // Command pools can only be used by one thread at a time, so threads other than the one that created the context get their own
+    [[nodiscard]] vk::CommandPool CommandPool() const;
+    // Destroys the command pool of the calling thread, all its command buffers have to be freed
+    void ReleaseThreadCommandPool();
+    // Queues can only be submitted to by one thread at a time
+    [[nodiscard]] std::mutex& QueueMutex() const { return _queueMutex; }
     [[nodiscard]] VmaAllocator MemoryAllocator() const { return _vmaAllocator; }
     [[nodiscard]] const QueueFamilyIndices& QueueFamilies() const { return _queueFamilyIndices; }
     [[nodiscard]] vk::DescriptorPool DescriptorPool() const { return _descriptorPool; }
@@ -47,6 +55,8 @@ public:
     [[nodiscard]] vk::PhysicalDeviceRayTracingPipelinePropertiesKHR RayTracingPipelineProperties() const;
     [[nodiscard]] uint64_t GetBufferDeviceAddress(vk::Buffer buffer) const;
     [[nodiscard]] bool IsExtensionSupported(const std::string& extension) const;
+    // Whether acceleration structures can be built from R16G16B16A16_UNORM vertices, otherwise they have to be SNORM
+    [[nodiscard]] bool IsUnormVertexBuildSupported() const { return _unormVertexBuildSupported; }
 
 private:
     vk::Instance _instance;
@@ -56,9 +66,14 @@ private:
     vk::Queue _graphicsQueue;
     vk::Queue _presentQueue;
     vk::CommandPool _commandPool;
+    std::thread::id _mainThreadId;
+    mutable std::unordered_map<std::thread::id, vk::CommandPool> _threadCommandPools;
+    mutable std::mutex _threadCommandPoolsMutex;
+    mutable std::mutex _queueMutex;
     QueueFamilyIndices _queueFamilyIndices;
     VmaAllocator _vmaAllocator;
     vk::DescriptorPool _descriptorPool;
+    bool _unormVertexBuildSupported = false;
 
     vk::SurfaceKHR _surface;
 
@@ -94,6 +109,7 @@ private:
     void InitializePhysicalDevice();
     void InitializeDevice();
     void InitializeCommandPool();
+    [[nodiscard]] vk::CommandPool CreateCommandPool() const;
     void InitializeVMA();
     void InitializeDescriptorPool();
     [[nodiscard]] bool AreValidationLayersSupported() const;
@@ -39,7 +39,13 @@ struct GeometryNode
 {
     uint64_t primitiveBufferDeviceAddress;
     uint64_t indexBufferDeviceAddress;
+    uint64_t curveStrandBufferDeviceAddress;
     uint materialIndex;
+    float curveRadius;
+    vec3 positionOffset;
+    bool quantizedVertices;
+    vec3 positionScale;
+    bool signedQuantizedVertices;
 };
 layout (std140, set = 0, binding = 2) buffer GeometryNodes
 {
@@ -6,6 +6,45 @@ struct Curve
     vec3 end;
 };
 
+// Control points as 16 bit offsets from the root of the curve's strand, two per word, see QuantizedCurve
+struct QuantizedCurve
+{
+    uint words[6];
+};
+
+struct CurveStrand
+{
+    vec3 root;
+    float scale;
+};
+
+// Part of a curve bounded by a single aabb
+struct CurvePrimitive
+{
+    uint curveIndex;
+    uint strandIndex;
+    float tMin;
+    float tMax;
+};
+
+Curve DecodeCurve(QuantizedCurve quantizedCurve, CurveStrand strand)
+{
+    float offsets[12];
+    for (uint i = 0; i < 6; ++i)
+    {
+        offsets[i * 2] = float(bitfieldExtract(int(quantizedCurve.words[i]), 0, 16));
+        offsets[i * 2 + 1] = float(bitfieldExtract(int(quantizedCurve.words[i]), 16, 16));
+    }
+
+    Curve curve;
+    curve.start = strand.root + vec3(offsets[0], offsets[1], offsets[2]) * strand.scale;
+    curve.controlPoint1 = strand.root + vec3(offsets[3], offsets[4], offsets[5]) * strand.scale;
+    curve.controlPoint2 = strand.root + vec3(offsets[6], offsets[7], offsets[8]) * strand.scale;
+    curve.end = strand.root + vec3(offsets[9], offsets[10], offsets[11]) * strand.scale;
+
+    return curve;
+}
+
 vec3 SampleCurvePoint(Curve curve, float t)
 {
     float u = 1.0f - t;
@@ -120,7 +120,19 @@ void Application::MainLoopOnce()
         _imguiBackend->UpdateEvent(event);
     }
 
-    _flyCamera->Update(deltaTime);
+    // Tab frees the cursor to use the editor, the camera only moves while it is captured
+    if (_input->IsKeyPressed(KeyboardCode::eTAB))
+    {
+        _editorCursorMode = !_editorCursorMode;
+        SDL_SetWindowRelativeMouseMode(_window, !_editorCursorMode);
+        _editorCursorMode ? SDL_ShowCursor() : SDL_HideCursor();
+        _renderer->SetHairEditing(_editorCursorMode);
+    }
+
+    if (!_editorCursorMode)
+    {
+        _flyCamera->Update(deltaTime);
+    }
     _editor->Update();
     _renderer->Render();
 
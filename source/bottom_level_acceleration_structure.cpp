@@ -2,15 +2,21 @@
 #include "resources/bindless_resources.hpp"
 #include "resources/model/model.hpp"
 #include "single_time_commands.hpp"
+#include "vk_common.hpp"
 #include "vulkan_context.hpp"
 
+#include <algorithm>
+
 BottomLevelAccelerationStructure::BottomLevelAccelerationStructure(const BLASInput& input, const std::shared_ptr<BindlessResources>& resources, const std::shared_ptr<VulkanContext>& vulkanContext)
     : _type(input.type)
     , _transform(input.transform)
     , _vulkanContext(vulkanContext)
 {
     InitializeStructure(input);
-    resources->GeometryNodes().Create(input.node);
+
+    // Nodes of a BLAS are stored next to each other, so they can be found from the first one with the geometry index
+    _firstGeometryIndex = resources->GeometryNodes().CreateRange(input.nodes).handle;
+    _geometryCount = input.nodes.size();
 }
 
 BottomLevelAccelerationStructure::~BottomLevelAccelerationStructure()
@@ -21,6 +27,8 @@ BottomLevelAccelerationStructure::~BottomLevelAccelerationStructure()
 BottomLevelAccelerationStructure::BottomLevelAccelerationStructure(BottomLevelAccelerationStructure&& other) noexcept
     : _type(other._type)
     , _transform(other._transform)
+    , _firstGeometryIndex(other._firstGeometryIndex)
+    , _geometryCount(other._geometryCount)
     , _vulkanContext(other._vulkanContext)
 {
     _vkStructure = other._vkStructure;
@@ -33,15 +41,45 @@ BottomLevelAccelerationStructure::BottomLevelAccelerationStructure(BottomLevelAc
 
 void BottomLevelAccelerationStructure::InitializeStructure(const BLASInput& input)
 {
+    std::vector<vk::AccelerationStructureGeometryKHR> geometries = input.geometries;
+
+    // Only needed while building, the transform is baked into the structure
+    std::unique_ptr<Buffer> transformBuffer {};
+    if (input.geometryTransform.has_value())
+    {
+        const VkTransformMatrixKHR transform = VkGLMToTransformMatrixKHR(input.geometryTransform.value());
+
+        BufferCreation transformBufferCreation {};
+        transformBufferCreation.SetName("BLAS Transform Buffer")
+            .SetUsageFlags(vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
+            .SetIsMappable(true)
+            .SetSize(sizeof(VkTransformMatrixKHR));
+        transformBuffer = std::make_unique<Buffer>(transformBufferCreation, _vulkanContext);
+        memcpy(transformBuffer->mappedPtr, &transform, sizeof(VkTransformMatrixKHR));
+
+        for (vk::AccelerationStructureGeometryKHR& geometry : geometries)
+        {
+            if (geometry.geometryType == vk::GeometryTypeKHR::eTriangles)
+            {
+                geometry.geometry.triangles.transformData.deviceAddress = _vulkanContext->GetBufferDeviceAddress(transformBuffer->buffer);
+            }
+        }
+    }
+
     vk::AccelerationStructureBuildGeometryInfoKHR buildGeometryInfo {};
     buildGeometryInfo.type = vk::AccelerationStructureTypeKHR::eBottomLevel;
     buildGeometryInfo.flags = vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace;
     buildGeometryInfo.mode = vk::BuildAccelerationStructureModeKHR::eBuild;
-    buildGeometryInfo.geometryCount = 1;
-    buildGeometryInfo.pGeometries = &input.geometry;
+    buildGeometryInfo.geometryCount = geometries.size();
+    buildGeometryInfo.pGeometries = geometries.data();
+
+    std::vector<uint32_t> maxPrimitiveCounts(input.infos.size());
+    std::transform(input.infos.begin(), input.infos.end(), maxPrimitiveCounts.begin(), [](const vk::AccelerationStructureBuildRangeInfoKHR& info)
+        { return info.primitiveCount; });
 
     vk::AccelerationStructureBuildSizesInfoKHR buildSizesInfo = _vulkanContext->Device().getAccelerationStructureBuildSizesKHR(
-        vk::AccelerationStructureBuildTypeKHR::eDevice, buildGeometryInfo, input.info.primitiveCount, _vulkanContext->Dldi());
+        vk::AccelerationStructureBuildTypeKHR::eDevice, buildGeometryInfo, maxPrimitiveCounts, _vulkanContext->Dldi());
 
     BufferCreation structureBufferCreation {};
     structureBufferCreation.SetName("BLAS Structure Buffer")
@@ -69,7 +107,7 @@ void BottomLevelAccelerationStructure::InitializeStructure(const BLASInput& inpu
     buildGeometryInfo.dstAccelerationStructure = _vkStructure;
     buildGeometryInfo.scratchData.deviceAddress = _vulkanContext->GetBufferDeviceAddress(_scratchBuffer->buffer);
 
-    std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> pBuildRangeInfos = { &input.info };
+    std::array<const vk::AccelerationStructureBuildRangeInfoKHR*, 1> pBuildRangeInfos = { input.infos.data() };
 
     SingleTimeCommands singleTimeCommands { _vulkanContext };
     singleTimeCommands.Record([&](vk::CommandBuffer commandBuffer)
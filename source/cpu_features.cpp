@@ -0,0 +1,39 @@
+#include "cpu_features.hpp"
+
+#ifdef VKHRT_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+bool IsAVX2Supported()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int registers[4] {};
+    __cpuid(registers, 0);
+    if (registers[0] < 7)
+    {
+        return false;
+    }
+
+    // AVX2 also needs the OS to save the YMM registers
+    __cpuid(registers, 1);
+    const bool osSavesYmm = (registers[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+    __cpuidex(registers, 7, 0);
+    return osSavesYmm && (registers[1] & (1 << 5));
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+bool IsSSE4Supported()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int registers[4] {};
+    __cpuid(registers, 1);
+    return registers[2] & (1 << 19);
+#else
+    return __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+#endif
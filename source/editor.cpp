@@ -2,6 +2,7 @@
 #include "application.hpp"
 #include "renderer.hpp"
 #include "resources/model/model.hpp"
+#include <array>
 #include <imgui.h>
 
 Editor::Editor(const Application& application, const std::shared_ptr<VulkanContext>& vulkanContext, const std::shared_ptr<Renderer>& renderer)
@@ -9,27 +10,18 @@ Editor::Editor(const Application& application, const std::shared_ptr<VulkanConte
     , _vulkanContext(vulkanContext)
     , _renderer(renderer)
 {
-    for (const std::shared_ptr<Model>& model : _renderer->GetModels())
-    {
-        _sceneInformation.trianglePrimitivesCount += model->vertexCount;
-        _sceneInformation.curvePrimitivesCount += model->curveCount;
-        _sceneInformation.lssPrimitivesCount += model->lssPositionCount / 2;
-
-        for (const Node& node : model->sceneGraph->nodes)
-        {
-            for (const uint32_t voxelMeshIndex : node.voxelMeshes)
-            {
-                _sceneInformation.filledVoxelPrimitivesCount += model->sceneGraph->voxelMeshes[voxelMeshIndex].filledVoxelCount;
-            }
-        }
-    }
     _lssSupported = _vulkanContext->IsExtensionSupported(VK_NV_RAY_TRACING_LINEAR_SWEPT_SPHERES_EXTENSION_NAME);
+    _hairSettings = _renderer->GetHairSettings();
+    _hairTechnique = _renderer->GetHairTechnique();
 }
 
 void Editor::Update()
 {
     static constexpr float INDENT_SPACING = 20.0f;
 
+    // Models are swapped when hair was rebuilt
+    UpdateSceneInformation();
+
     ImGui::Begin("Debug Information", nullptr, ImGuiWindowFlags_NoDecoration);
     ImGui::SetWindowSize(ImVec2(250.0f, 325.0f));
 
@@ -49,4 +41,74 @@ void Editor::Update()
     ImGui::Indent(-INDENT_SPACING);
 
     ImGui::End();
+
+    UpdateHairSettings();
+}
+
+void Editor::UpdateSceneInformation()
+{
+    _sceneInformation = {};
+    for (const std::shared_ptr<Model>& model : _renderer->GetModels())
+    {
+        _sceneInformation.trianglePrimitivesCount += model->vertexCount + model->quantizedVertexCount;
+        _sceneInformation.curvePrimitivesCount += model->curveCount;
+        _sceneInformation.lssPrimitivesCount += model->lssIndexCount;
+
+        for (const Node& node : model->sceneGraph->nodes)
+        {
+            for (const uint32_t voxelMeshIndex : node.voxelMeshes)
+            {
+                _sceneInformation.filledVoxelPrimitivesCount += model->sceneGraph->voxelMeshes[voxelMeshIndex].levels.front().filledVoxelCount;
+            }
+        }
+    }
+}
+
+void Editor::UpdateHairSettings()
+{
+    static constexpr std::array<const char*, 5> TECHNIQUE_NAMES = { "DOTS", "LSS", "Curves", "Voxels", "Tubes" };
+
+    ImGui::Begin("Hair Settings");
+    ImGui::TextDisabled("Press Tab to toggle the cursor");
+
+    if (ImGui::BeginCombo("Technique", TECHNIQUE_NAMES.at(static_cast<uint32_t>(_hairTechnique))))
+    {
+        for (uint32_t i = 0; i < TECHNIQUE_NAMES.size(); ++i)
+        {
+            const HairTechnique technique = static_cast<HairTechnique>(i);
+            ImGui::BeginDisabled(technique == HairTechnique::eLSS && !_lssSupported);
+            if (ImGui::Selectable(TECHNIQUE_NAMES.at(i), technique == _hairTechnique))
+            {
+                _hairTechnique = technique;
+            }
+            ImGui::EndDisabled();
+        }
+        ImGui::EndCombo();
+    }
+
+    ImGui::DragFloat("Radius", &_hairSettings.radius, 0.0005f, 0.001f, 1.0f, "%.4f", ImGuiSliderFlags_AlwaysClamp);
+    ImGui::DragFloat("Voxel Size", &_hairSettings.voxelSize, 0.005f, 0.01f, 1.0f, "%.3f", ImGuiSliderFlags_AlwaysClamp);
+    bool exactVoxelization = _hairSettings.voxelization == VoxelizationMode::eExact;
+    if (ImGui::Checkbox("Exact Voxelization", &exactVoxelization))
+    {
+        _hairSettings.voxelization = exactVoxelization ? VoxelizationMode::eExact : VoxelizationMode::eConservativeBox;
+    }
+    ImGui::BeginDisabled(!exactVoxelization);
+    ImGui::Checkbox("Report Voxel Reduction", &_hairSettings.reportVoxelReduction);
+    ImGui::EndDisabled();
+    ImGui::DragFloat("Resampling Tolerance", &_hairSettings.maxStrandDeviation, 0.0001f, 0.0001f, 0.1f, "%.4f", ImGuiSliderFlags_AlwaysClamp);
+
+    if (ImGui::Button("Apply"))
+    {
+        _renderer->RequestHairRebuild(_hairSettings, _hairTechnique);
+    }
+
+    if (_renderer->IsRebuildingHair())
+    {
+        ImGui::SameLine();
+        ImGui::Text("Rebuilding...");
+    }
+
+    ImGui::End();
 }
+
@@ -0,0 +1,186 @@
+#include "job_system.hpp"
+
+// Identifies the queue owned by the current thread, threads outside of the job system share the last queue
+static thread_local const JobSystem* currentJobSystem = nullptr;
+static thread_local uint32_t currentQueueIndex = 0;
+
+JobSystem::JobSystem(uint32_t workerCount)
+{
+    _queues.resize(workerCount + 1);
+    for (std::unique_ptr<WorkerQueue>& queue : _queues)
+    {
+        queue = std::make_unique<WorkerQueue>();
+    }
+
+    _workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        _workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard lock(_sleepMutex);
+        _stopRequested = true;
+    }
+    _sleepCondition.notify_all();
+
+    for (std::thread& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+void JobSystem::Submit(Job job, JobCounter& counter)
+{
+    counter.pendingJobs.fetch_add(1, std::memory_order_relaxed);
+
+    Job countedJob = [job = std::move(job), &counter]()
+    {
+        job();
+        counter.pendingJobs.fetch_sub(1, std::memory_order_release);
+    };
+
+    // Count the job before it becomes visible, so a thief can never decrement the counter below zero.
+    // Take the sleep lock so a worker can't miss the notification between checking for jobs and going to sleep
+    {
+        std::lock_guard lock(_sleepMutex);
+        _queuedJobs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const uint32_t queueIndex = currentJobSystem == this ? currentQueueIndex : _workers.size();
+    {
+        std::lock_guard lock(_queues[queueIndex]->mutex);
+        _queues[queueIndex]->jobs.push_back(std::move(countedJob));
+    }
+    _sleepCondition.notify_one();
+}
+
+void JobSystem::Wait(const JobCounter& counter)
+{
+    if (currentJobSystem != this)
+    {
+        currentJobSystem = this;
+        currentQueueIndex = _workers.size();
+    }
+
+    while (counter.pendingJobs.load(std::memory_order_acquire) > 0)
+    {
+        if (!TryExecuteJob())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t begin, uint32_t end)>& function)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    grainSize = std::max(grainSize, 1u);
+
+    // Nothing to split, so avoid the queue round trip
+    if (count <= grainSize)
+    {
+        function(0, count);
+        return;
+    }
+
+    JobCounter counter {};
+    for (uint32_t begin = 0; begin < count; begin += grainSize)
+    {
+        const uint32_t end = std::min(begin + grainSize, count);
+        Submit([&function, begin, end]()
+            { function(begin, end); },
+            counter);
+    }
+
+    Wait(counter);
+}
+
+void JobSystem::WorkerLoop(uint32_t workerIndex)
+{
+    currentJobSystem = this;
+    currentQueueIndex = workerIndex;
+
+    while (true)
+    {
+        if (TryExecuteJob())
+        {
+            continue;
+        }
+
+        std::unique_lock lock(_sleepMutex);
+        _sleepCondition.wait(lock, [this]()
+            { return _stopRequested || _queuedJobs.load(std::memory_order_relaxed) > 0; });
+
+        if (_stopRequested)
+        {
+            return;
+        }
+    }
+}
+
+bool JobSystem::TryExecuteJob()
+{
+    Job job {};
+    if (!TryPopJob(currentQueueIndex, job) && !TryStealJob(currentQueueIndex, job))
+    {
+        return false;
+    }
+
+    _queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    job();
+    return true;
+}
+
+bool JobSystem::TryPopJob(uint32_t queueIndex, Job& job)
+{
+    // Owners take their newest job, which keeps nested work (and its data) hot in the cache
+    WorkerQueue& queue = *_queues[queueIndex];
+    std::lock_guard lock(queue.mutex);
+
+    if (queue.jobs.empty())
+    {
+        return false;
+    }
+
+    job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    return true;
+}
+
+bool JobSystem::TryStealJob(uint32_t queueIndex, Job& job)
+{
+    // Thieves take the oldest job, which usually represents the largest chunk of remaining work
+    const uint32_t queueCount = _queues.size();
+    const uint32_t startIndex = _nextQueue.fetch_add(1, std::memory_order_relaxed);
+
+    for (uint32_t i = 0; i < queueCount; ++i)
+    {
+        const uint32_t victimIndex = (startIndex + i) % queueCount;
+        if (victimIndex == queueIndex)
+        {
+            continue;
+        }
+
+        WorkerQueue& queue = *_queues[victimIndex];
+        std::lock_guard lock(queue.mutex);
+
+        if (queue.jobs.empty())
+        {
+            continue;
+        }
+
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        return true;
+    }
+
+    return false;
+}
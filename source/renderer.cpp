@@ -1,5 +1,6 @@
 #include "renderer.hpp"
 #include "fly_camera.hpp"
+#include "job_system.hpp"
 #include "resources/bindless_resources.hpp"
 #include "resources/camera_resource.hpp"
 #include "resources/file_io.hpp"
@@ -9,10 +10,18 @@
 #include "top_level_acceleration_structure.hpp"
 #include "vulkan_context.hpp"
 
+#include <algorithm>
 #include <backends/imgui_impl_vulkan.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
+#include <spdlog/spdlog.h>
+#include <unordered_set>
+
+// Projected size (relative to the screen height) below which the first reduced level of detail is used,
+// every following level is used after the projected size halves again
+constexpr float LOD_FULL_DETAIL_SCREEN_SIZE = 0.5f;
+constexpr float LOD_HYSTERESIS = 0.1f;
 
 Renderer::Renderer(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, const std::shared_ptr<FlyCamera>& flyCamera)
     : _vulkanContext(vulkanContext)
@@ -26,21 +35,24 @@ Renderer::Renderer(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanC
     InitializeRenderTarget();
 
     _bindlessResources = std::make_shared<BindlessResources>(_vulkanContext);
-    _modelLoader = std::make_unique<ModelLoader>(_bindlessResources, _vulkanContext);
+    _jobSystem = std::make_shared<JobSystem>();
+    _modelLoader = std::make_unique<ModelLoader>(_bindlessResources, _vulkanContext, _jobSystem);
     _cameraResource = std::make_unique<CameraResource>(_vulkanContext);
 
     // Initialize scene models
-    const std::vector<std::string> scene = {
+    _modelPaths = {
         "assets/claire/Claire_HairMain_less_strands.gltf",
         "assets/claire/Claire_PonyTail.gltf",
         "assets/claire/hairtie/hairtie.gltf",
     };
-    for (const auto& modelPath : scene)
+    _hairTechnique = _modelLoader->DefaultHairTechnique();
+
+    std::vector<std::shared_ptr<Model>> models {};
+    for (const auto& modelPath : _modelPaths)
     {
-        _models.emplace_back(_modelLoader->LoadFromFile(modelPath));
+        models.emplace_back(_modelLoader->LoadFromFile(modelPath, _hairSettings));
     }
-    InitializeBLAS();
-    _tlas = std::make_unique<TopLevelAccelerationStructure>(_blases, _bindlessResources, _vulkanContext);
+    _scene = BuildScene(std::move(models), Scene {}, glm::vec3(glm::inverse(_flyCamera->ViewMatrix())[3]), std::abs(_flyCamera->ProjectionMatrix()[1][1]));
 
     // Initialize scene environment map
     int32_t width {}, height {}, nrChannels {};
@@ -64,6 +76,14 @@ Renderer::Renderer(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanC
 
 Renderer::~Renderer()
 {
+    if (_sceneRebuild.valid())
+    {
+        _sceneRebuild.wait();
+    }
+
+    // Retired scenes can still be in use by frames in flight
+    _vulkanContext->Device().waitIdle();
+
     _vulkanContext->Device().destroyRenderPass(_imguiRenderPass);
     _vulkanContext->Device().destroyFramebuffer(_imguiFramebuffer);
 
@@ -83,12 +103,18 @@ Renderer::~Renderer()
 void Renderer::Render()
 {
     uint32_t currentResourcesFrame = _renderedFrames % MAX_FRAMES_IN_FLIGHT;
+    SwapRebuiltScene();
     UpdateCameraResource(currentResourcesFrame);
+    UpdateLODs();
 
     VkCheckResult(_vulkanContext->Device().waitForFences(1, &_inFlightFences.at(currentResourcesFrame), vk::True,
                       std::numeric_limits<uint64_t>::max()),
         "Failed waiting on in flight fence!");
 
+    ReleaseRetiredScenes();
+    StartHairRebuild();
+    UpdateTLASDescriptor(currentResourcesFrame);
+
     uint32_t swapChainImageIndex {};
     VkCheckResult(_vulkanContext->Device().acquireNextImageKHR(_swapChain->GetSwapChain(), std::numeric_limits<uint64_t>::max(),
                       _imageAvailableSemaphores.at(currentResourcesFrame), nullptr, &swapChainImageIndex),
@@ -116,6 +142,7 @@ void Renderer::Render()
     submitInfo.pCommandBuffers = &commandBuffer;
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = &signalSemaphore;
+    std::lock_guard queueLock { _vulkanContext->QueueMutex() };
     VkCheckResult(_vulkanContext->GraphicsQueue().submit(1, &submitInfo, _inFlightFences.at(currentResourcesFrame)), "Failed submitting to graphics queue!");
 
     vk::SwapchainKHR swapchain = _swapChain->GetSwapChain();
@@ -155,9 +182,12 @@ void Renderer::RecordCommands(const vk::CommandBuffer& commandBuffer, uint32_t s
 
 void Renderer::RecordRayTracingCommands(const vk::CommandBuffer& commandBuffer, uint32_t currentResourceFrame)
 {
+    // The fence of the frame was waited on, so its TLAS can be rebuilt before tracing
+    _scene.tlas->RecordPendingBuild(commandBuffer, currentResourceFrame);
+
     commandBuffer.bindPipeline(vk::PipelineBindPoint::eRayTracingKHR, _pipeline);
     commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, _pipelineLayout, 0, _bindlessResources->DescriptorSet(), nullptr);
-    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, _pipelineLayout, 1, _descriptorSet, nullptr);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, _pipelineLayout, 1, _descriptorSets.at(currentResourceFrame), nullptr);
     commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, _pipelineLayout, 2, _cameraResource->DescriptorSet(currentResourceFrame), nullptr);
     commandBuffer.pushConstants(_pipelineLayout, vk::ShaderStageFlagBits::eMissKHR, 0, sizeof(PushConstantData), &_pushConstantData);
 
@@ -194,6 +224,191 @@ void Renderer::UpdateCameraResource(uint32_t currentResourceFrame)
     _cameraResource->Update(currentResourceFrame, inverseView, inverseProjection);
 }
 
+// Selects the level of detail of the chain for its projected size, returns whether it changed
+bool SelectLODLevel(uint32_t& currentLevel, uint32_t levelCount, const glm::vec3& boundsCenter, float boundsRadius, const glm::vec3& cameraPosition, float projectionScale)
+{
+    if (levelCount <= 1)
+    {
+        return false;
+    }
+
+    const float distance = std::max(glm::length(boundsCenter - cameraPosition) - boundsRadius, std::numeric_limits<float>::epsilon());
+    const float projectedSize = boundsRadius * projectionScale / distance;
+    const float lodValue = std::log2(LOD_FULL_DETAIL_SCREEN_SIZE / projectedSize);
+
+    // Only switch when the value moved past the current level by some margin, to avoid flickering between two levels
+    const float level = static_cast<float>(currentLevel);
+    if (lodValue > level - LOD_HYSTERESIS && lodValue < level + 1.0f + LOD_HYSTERESIS)
+    {
+        return false;
+    }
+
+    const uint32_t newLevel = std::clamp(static_cast<int32_t>(std::floor(lodValue)), 0, static_cast<int32_t>(levelCount) - 1);
+    if (newLevel == currentLevel)
+    {
+        return false;
+    }
+
+    currentLevel = newLevel;
+    return true;
+}
+
+void Renderer::UpdateLODs()
+{
+    const glm::vec3 cameraPosition = glm::vec3(glm::inverse(_flyCamera->ViewMatrix())[3]);
+    const float projectionScale = std::abs(_flyCamera->ProjectionMatrix()[1][1]);
+
+    bool levelsChanged = false;
+    for (BLASLODChain& chain : _scene.blasLODChains)
+    {
+        levelsChanged |= SelectLODLevel(chain.currentLevel, chain.levelCount, chain.boundsCenter, chain.boundsRadius, cameraPosition, projectionScale);
+    }
+
+    if (levelsChanged)
+    {
+        // Only marks the TLAS of every frame in flight as outdated, each is rebuilt in the command buffer of its own frame
+        _scene.tlas->UpdateInstances(_scene.blases, SelectedBLASes(_scene));
+    }
+}
+
+void Renderer::UpdateTLASDescriptor(uint32_t currentResourceFrame)
+{
+    const vk::AccelerationStructureKHR tlas = _scene.tlas->Structure(currentResourceFrame);
+    if (_boundTLASes.at(currentResourceFrame) == tlas)
+    {
+        return;
+    }
+
+    vk::WriteDescriptorSetAccelerationStructureKHR descriptorAccelerationStructureInfo {};
+    descriptorAccelerationStructureInfo.accelerationStructureCount = 1;
+    descriptorAccelerationStructureInfo.pAccelerationStructures = &tlas;
+
+    vk::WriteDescriptorSet accelerationStructureWrite {};
+    accelerationStructureWrite.pNext = &descriptorAccelerationStructureInfo;
+    accelerationStructureWrite.dstSet = _descriptorSets.at(currentResourceFrame);
+    accelerationStructureWrite.dstBinding = 1;
+    accelerationStructureWrite.dstArrayElement = 0;
+    accelerationStructureWrite.descriptorCount = 1;
+    accelerationStructureWrite.descriptorType = vk::DescriptorType::eAccelerationStructureKHR;
+
+    _vulkanContext->Device().updateDescriptorSets(1, &accelerationStructureWrite, 0, nullptr);
+    _boundTLASes.at(currentResourceFrame) = tlas;
+}
+
+void Renderer::RequestHairRebuild(const HairSettings& hairSettings, HairTechnique hairTechnique)
+{
+    // Only the latest request matters, it is started once the running rebuild is swapped in
+    _requestedHairRebuild = HairRebuildRequest { hairSettings, hairTechnique };
+}
+
+void Renderer::StartHairRebuild()
+{
+    // The model loader is used by the rebuild, so it is only changed while none is running
+    if (_sceneRebuild.valid())
+    {
+        return;
+    }
+
+    _modelLoader->SetRetainHairSources(_hairEditing);
+    if (!_requestedHairRebuild.has_value())
+    {
+        return;
+    }
+
+    _hairSettings = _requestedHairRebuild->settings;
+    _hairTechnique = _requestedHairRebuild->technique;
+    _requestedHairRebuild.reset();
+
+    // The worker only gets copies of the current state, the scene keeps being used for rendering in the meantime
+    const glm::vec3 cameraPosition = glm::vec3(glm::inverse(_flyCamera->ViewMatrix())[3]);
+    const float projectionScale = std::abs(_flyCamera->ProjectionMatrix()[1][1]);
+    Scene previousScene { _scene.models, _scene.blases, _scene.blasLODChains, _scene.firstModelLODChains, nullptr };
+    _sceneRebuild = std::async(std::launch::async, [this, previousScene = std::move(previousScene), hairSettings = _hairSettings, hairTechnique = _hairTechnique, cameraPosition, projectionScale]()
+        {
+            std::vector<std::shared_ptr<Model>> rebuiltModels {};
+            for (uint32_t i = 0; i < _modelPaths.size(); ++i)
+            {
+                // Models without hair are kept as they are, together with their BLASes
+                std::shared_ptr<Model> model = _modelLoader->ReprocessHair(_modelPaths[i], hairSettings, hairTechnique);
+                rebuiltModels.emplace_back(model ? std::move(model) : previousScene.models[i]);
+            }
+
+            Scene scene = BuildScene(std::move(rebuiltModels), previousScene, cameraPosition, projectionScale);
+            _vulkanContext->ReleaseThreadCommandPool();
+            return scene; });
+}
+
+void Renderer::SwapRebuiltScene()
+{
+    if (!_sceneRebuild.valid() || _sceneRebuild.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        return;
+    }
+
+    // Frames in flight still use the old scene, so it is kept until their fences signaled
+    _retiredScenes.push_back(RetiredScene { std::exchange(_scene, _sceneRebuild.get()), _renderedFrames });
+    spdlog::info("[RENDERER] Swapped in rebuilt hair");
+}
+
+void Renderer::ReleaseRetiredScenes()
+{
+    // The last frame using a retired scene is the one before it was retired, it is done once its fence was waited on
+    const auto isDone = [this](const RetiredScene& retired)
+    { return _renderedFrames + 1 >= retired.retiredFrame + MAX_FRAMES_IN_FLIGHT; };
+
+    // BLASes shared with scenes that are still in use keep their geometry nodes
+    std::unordered_set<const BottomLevelAccelerationStructure*> keptBLASes {};
+    for (const auto& blas : _scene.blases)
+    {
+        keptBLASes.insert(blas.get());
+    }
+    for (const RetiredScene& retired : _retiredScenes)
+    {
+        if (isDone(retired))
+        {
+            continue;
+        }
+
+        for (const auto& blas : retired.scene.blases)
+        {
+            keptBLASes.insert(blas.get());
+        }
+    }
+
+    // The GPU objects of done scenes are destroyed right away, BLASes shared by several of them only release their nodes once
+    std::erase_if(_retiredScenes, [&](const RetiredScene& retired)
+        {
+            if (!isDone(retired))
+            {
+                return false;
+            }
+
+            for (const auto& blas : retired.scene.blases)
+            {
+                if (keptBLASes.insert(blas.get()).second)
+                {
+                    _pendingGeometryNodeReleases.push_back({ blas->FirstGeometryIndex(), blas->GeometryCount() });
+                }
+            }
+            _pendingBLASInstanceReleases.push_back({ retired.scene.tlas->FirstBLASInstanceIndex(), static_cast<uint32_t>(retired.scene.blases.size()) });
+            return true; });
+
+    // The rebuild creates ranges on its worker, so released ranges are only handed back while none is running
+    if (_sceneRebuild.valid())
+    {
+        return;
+    }
+
+    for (const ResourceRange& range : std::exchange(_pendingGeometryNodeReleases, {}))
+    {
+        _bindlessResources->GeometryNodes().ReleaseRange({ range.first }, range.count);
+    }
+    for (const ResourceRange& range : std::exchange(_pendingBLASInstanceReleases, {}))
+    {
+        _bindlessResources->BLASInstances().ReleaseRange({ range.first }, range.count);
+    }
+}
+
 void Renderer::InitializeCommandBuffers()
 {
     vk::CommandBufferAllocateInfo commandBufferAllocateInfo {};
@@ -251,40 +466,32 @@ void Renderer::InitializeDescriptorSets()
     descriptorSetLayoutCreateInfo.pBindings = bindingLayouts.data();
     _descriptorSetLayout = _vulkanContext->Device().createDescriptorSetLayout(descriptorSetLayoutCreateInfo);
 
+    std::array<vk::DescriptorSetLayout, MAX_FRAMES_IN_FLIGHT> setLayouts {};
+    setLayouts.fill(_descriptorSetLayout);
+
     vk::DescriptorSetAllocateInfo descriptorSetAllocateInfo {};
     descriptorSetAllocateInfo.descriptorPool = _vulkanContext->DescriptorPool();
-    descriptorSetAllocateInfo.descriptorSetCount = 1;
-    descriptorSetAllocateInfo.pSetLayouts = &_descriptorSetLayout;
-    _descriptorSet = _vulkanContext->Device().allocateDescriptorSets(descriptorSetAllocateInfo).front();
+    descriptorSetAllocateInfo.descriptorSetCount = setLayouts.size();
+    descriptorSetAllocateInfo.pSetLayouts = setLayouts.data();
+    VkCheckResult(_vulkanContext->Device().allocateDescriptorSets(&descriptorSetAllocateInfo, _descriptorSets.data()), "Failed allocating descriptor sets!");
 
     vk::DescriptorImageInfo descriptorImageInfo {};
     descriptorImageInfo.imageView = _renderTarget->view;
     descriptorImageInfo.imageLayout = vk::ImageLayout::eGeneral;
 
-    vk::WriteDescriptorSetAccelerationStructureKHR descriptorAccelerationStructureInfo {};
-    descriptorAccelerationStructureInfo.accelerationStructureCount = 1;
-    const vk::AccelerationStructureKHR tlas = _tlas->Structure();
-    descriptorAccelerationStructureInfo.pAccelerationStructures = &tlas;
-
-    std::array<vk::WriteDescriptorSet, 2> descriptorWrites {};
-
-    vk::WriteDescriptorSet& imageWrite = descriptorWrites.at(0);
-    imageWrite.dstSet = _descriptorSet;
-    imageWrite.dstBinding = 0;
-    imageWrite.dstArrayElement = 0;
-    imageWrite.descriptorCount = 1;
-    imageWrite.descriptorType = vk::DescriptorType::eStorageImage;
-    imageWrite.pImageInfo = &descriptorImageInfo;
-
-    vk::WriteDescriptorSet& accelerationStructureWrite = descriptorWrites.at(1);
-    accelerationStructureWrite.pNext = &descriptorAccelerationStructureInfo;
-    accelerationStructureWrite.dstSet = _descriptorSet;
-    accelerationStructureWrite.dstBinding = 1;
-    accelerationStructureWrite.dstArrayElement = 0;
-    accelerationStructureWrite.descriptorCount = 1;
-    accelerationStructureWrite.descriptorType = vk::DescriptorType::eAccelerationStructureKHR;
-
-    _vulkanContext->Device().updateDescriptorSets(static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; ++frame)
+    {
+        vk::WriteDescriptorSet imageWrite {};
+        imageWrite.dstSet = _descriptorSets.at(frame);
+        imageWrite.dstBinding = 0;
+        imageWrite.dstArrayElement = 0;
+        imageWrite.descriptorCount = 1;
+        imageWrite.descriptorType = vk::DescriptorType::eStorageImage;
+        imageWrite.pImageInfo = &descriptorImageInfo;
+
+        _vulkanContext->Device().updateDescriptorSets(1, &imageWrite, 0, nullptr);
+        UpdateTLASDescriptor(frame);
+    }
 }
 
 void Renderer::InitializeRayTracingPipeline()
@@ -546,37 +753,61 @@ BLASInput InitializeBLASInput(const std::shared_ptr<Model>& model, const Node& n
     output.type = BLASType::eMesh;
     output.transform = node.GetWorldMatrix();
 
-    vk::DeviceOrHostAddressConstKHR vertexBufferDeviceAddress {};
-    vk::DeviceOrHostAddressConstKHR indexBufferDeviceAddress {};
-    vertexBufferDeviceAddress.deviceAddress = vulkanContext->GetBufferDeviceAddress(model->vertexBuffer->buffer);
-    indexBufferDeviceAddress.deviceAddress = vulkanContext->GetBufferDeviceAddress(model->indexBuffer->buffer) + mesh.firstIndex * sizeof(uint32_t);
-
-    vk::AccelerationStructureGeometryTrianglesDataKHR trianglesData {};
-    trianglesData.vertexFormat = vk::Format::eR32G32B32Sfloat;
-    trianglesData.vertexData = vertexBufferDeviceAddress;
-    trianglesData.maxVertex = model->vertexCount - 1;
-    trianglesData.vertexStride = sizeof(Mesh::Vertex);
-    trianglesData.indexType = vk::IndexType::eUint32;
-    trianglesData.indexData = indexBufferDeviceAddress;
-    trianglesData.transformData = {}; // Identity transform
-
-    vk::AccelerationStructureGeometryKHR& accelerationStructureGeometry = output.geometry;
-    accelerationStructureGeometry.flags = vk::GeometryFlagBitsKHR::eOpaque;
-    accelerationStructureGeometry.geometryType = vk::GeometryTypeKHR::eTriangles;
-    accelerationStructureGeometry.geometry.triangles = trianglesData;
-
-    const uint32_t primitiveCount = mesh.indexCount / 3;
+    // Quantized vertices are stored in their own buffer, and get mapped back onto the bounding box by the build transform
+    const bool quantized = mesh.vertexFormat == Mesh::VertexFormat::eQuantized;
+    const bool signedQuantized = quantized && model->signedQuantizedVertices;
+    glm::vec3 positionOffset = mesh.boundingBox.min;
+    glm::vec3 positionScale = mesh.boundingBox.max - mesh.boundingBox.min;
+    if (signedQuantized)
+    {
+        // Snorm decodes the stored q - 32768 to (q - 32768) / 32767, which has to land on the same position as unorm q / 65535
+        positionOffset += positionScale * (32768.0f / 65535.0f);
+        positionScale *= 32767.0f / 65535.0f;
+    }
+    if (quantized)
+    {
+        output.geometryTransform = glm::scale(glm::translate(glm::mat4 { 1.0f }, positionOffset), positionScale);
+    }
 
-    vk::AccelerationStructureBuildRangeInfoKHR& buildRangeInfo = output.info;
-    buildRangeInfo.primitiveCount = primitiveCount;
-    buildRangeInfo.primitiveOffset = 0;
-    buildRangeInfo.firstVertex = 0;
-    buildRangeInfo.transformOffset = 0;
+    vk::DeviceOrHostAddressConstKHR vertexBufferDeviceAddress {};
+    vertexBufferDeviceAddress.deviceAddress = vulkanContext->GetBufferDeviceAddress(quantized ? model->quantizedVertexBuffer->buffer : model->vertexBuffer->buffer);
 
-    GeometryNodeCreation& nodeCreation = output.node;
-    nodeCreation.primitiveBufferDeviceAddress = vertexBufferDeviceAddress.deviceAddress;
-    nodeCreation.indexBufferDeviceAddress = indexBufferDeviceAddress.deviceAddress;
-    nodeCreation.material = mesh.material;
+    // Every cluster of the mesh becomes a separate geometry
+    const std::vector<GeometryCluster> clusters = mesh.clusters.empty() ? std::vector<GeometryCluster> { { 0, mesh.indexCount / 3 } } : mesh.clusters;
+    for (const GeometryCluster& cluster : clusters)
+    {
+        vk::DeviceOrHostAddressConstKHR indexBufferDeviceAddress {};
+        indexBufferDeviceAddress.deviceAddress = vulkanContext->GetBufferDeviceAddress(model->indexBuffer->buffer) + (mesh.firstIndex + cluster.firstPrimitive * 3) * sizeof(uint32_t);
+
+        vk::AccelerationStructureGeometryTrianglesDataKHR trianglesData {};
+        trianglesData.vertexFormat = quantized ? (signedQuantized ? vk::Format::eR16G16B16A16Snorm : vk::Format::eR16G16B16A16Unorm) : vk::Format::eR32G32B32Sfloat;
+        trianglesData.vertexData = vertexBufferDeviceAddress;
+        trianglesData.maxVertex = (quantized ? model->quantizedVertexCount : model->vertexCount) - 1;
+        trianglesData.vertexStride = quantized ? sizeof(Mesh::QuantizedVertex) : sizeof(Mesh::Vertex);
+        trianglesData.indexType = vk::IndexType::eUint32;
+        trianglesData.indexData = indexBufferDeviceAddress;
+        trianglesData.transformData = {}; // Identity transform, or the dequantization transform filled in by the BLAS
+
+        vk::AccelerationStructureGeometryKHR& accelerationStructureGeometry = output.geometries.emplace_back();
+        accelerationStructureGeometry.flags = vk::GeometryFlagBitsKHR::eOpaque;
+        accelerationStructureGeometry.geometryType = vk::GeometryTypeKHR::eTriangles;
+        accelerationStructureGeometry.geometry.triangles = trianglesData;
+
+        vk::AccelerationStructureBuildRangeInfoKHR& buildRangeInfo = output.infos.emplace_back();
+        buildRangeInfo.primitiveCount = cluster.primitiveCount;
+        buildRangeInfo.primitiveOffset = 0;
+        buildRangeInfo.firstVertex = 0;
+        buildRangeInfo.transformOffset = 0;
+
+        GeometryNodeCreation& nodeCreation = output.nodes.emplace_back();
+        nodeCreation.primitiveBufferDeviceAddress = vertexBufferDeviceAddress.deviceAddress;
+        nodeCreation.indexBufferDeviceAddress = indexBufferDeviceAddress.deviceAddress;
+        nodeCreation.material = mesh.material;
+        nodeCreation.quantizedVertices = quantized;
+        nodeCreation.signedQuantizedVertices = signedQuantized;
+        nodeCreation.positionOffset = positionOffset;
+        nodeCreation.positionScale = positionScale;
+    }
 
     return output;
 }
@@ -587,64 +818,83 @@ BLASInput InitializeBLASInput(const std::shared_ptr<Model>& model, const Node& n
     output.type = BLASType::eHair;
     output.transform = node.GetWorldMatrix();
 
-    vk::DeviceOrHostAddressConstKHR aabbBufferDeviceAddress {};
-    aabbBufferDeviceAddress.deviceAddress = vulkanContext->GetBufferDeviceAddress(model->aabbBuffer->buffer) + hair.firstAabb * sizeof(AABB);
+    vk::DeviceOrHostAddressConstKHR curveBufferDeviceAddress {};
+    curveBufferDeviceAddress.deviceAddress = vulkanContext->GetBufferDeviceAddress(model->curveBuffer->buffer) + hair.firstCurve * sizeof(QuantizedCurve);
 
-    vk::AccelerationStructureGeometryAabbsDataKHR aabbData {};
-    aabbData.data = aabbBufferDeviceAddress;
-    aabbData.stride = sizeof(AABB);
-
-    vk::AccelerationStructureGeometryKHR& accelerationStructureGeometry = output.geometry;
-    accelerationStructureGeometry.flags = vk::GeometryFlagBitsKHR::eOpaque;
-    accelerationStructureGeometry.geometryType = vk::GeometryTypeKHR::eAabbs;
-    accelerationStructureGeometry.geometry.aabbs = aabbData;
+    vk::DeviceOrHostAddressConstKHR curveStrandBufferDeviceAddress {};
+    curveStrandBufferDeviceAddress.deviceAddress = vulkanContext->GetBufferDeviceAddress(model->curveStrandBuffer->buffer) + hair.firstStrand * sizeof(CurveStrand);
 
-    const uint32_t primitiveCount = hair.aabbCount;
-
-    vk::AccelerationStructureBuildRangeInfoKHR& buildRangeInfo = output.info;
-    buildRangeInfo.primitiveCount = primitiveCount;
-    buildRangeInfo.primitiveOffset = 0;
-    buildRangeInfo.firstVertex = 0;
-    buildRangeInfo.transformOffset = 0;
-
-    vk::DeviceOrHostAddressConstKHR curvePrimitiveBufferDeviceAddress {};
-    curvePrimitiveBufferDeviceAddress.deviceAddress = vulkanContext->GetBufferDeviceAddress(model->curveBuffer->buffer);
-
-    GeometryNodeCreation& nodeCreation = output.node;
-    nodeCreation.primitiveBufferDeviceAddress = curvePrimitiveBufferDeviceAddress.deviceAddress;
-    nodeCreation.material = hair.material;
+    // Every cluster of the hair becomes a separate geometry, curve primitives still index the curves of the whole hair
+    const std::vector<GeometryCluster> clusters = hair.clusters.empty() ? std::vector<GeometryCluster> { { 0, hair.aabbCount } } : hair.clusters;
+    for (const GeometryCluster& cluster : clusters)
+    {
+        const uint32_t firstAabb = hair.firstAabb + cluster.firstPrimitive;
+
+        vk::DeviceOrHostAddressConstKHR aabbBufferDeviceAddress {};
+        aabbBufferDeviceAddress.deviceAddress = vulkanContext->GetBufferDeviceAddress(model->aabbBuffer->buffer) + firstAabb * sizeof(AABB);
+
+        vk::AccelerationStructureGeometryAabbsDataKHR aabbData {};
+        aabbData.data = aabbBufferDeviceAddress;
+        aabbData.stride = sizeof(AABB);
+
+        vk::AccelerationStructureGeometryKHR& accelerationStructureGeometry = output.geometries.emplace_back();
+        accelerationStructureGeometry.flags = vk::GeometryFlagBitsKHR::eOpaque;
+        accelerationStructureGeometry.geometryType = vk::GeometryTypeKHR::eAabbs;
+        accelerationStructureGeometry.geometry.aabbs = aabbData;
+
+        vk::AccelerationStructureBuildRangeInfoKHR& buildRangeInfo = output.infos.emplace_back();
+        buildRangeInfo.primitiveCount = cluster.primitiveCount;
+        buildRangeInfo.primitiveOffset = 0;
+        buildRangeInfo.firstVertex = 0;
+        buildRangeInfo.transformOffset = 0;
+
+        // Maps every aabb (gl_PrimitiveID) to the curve and parameter range it bounds
+        vk::DeviceOrHostAddressConstKHR curvePrimitiveBufferDeviceAddress {};
+        curvePrimitiveBufferDeviceAddress.deviceAddress = vulkanContext->GetBufferDeviceAddress(model->curvePrimitiveBuffer->buffer) + firstAabb * sizeof(CurvePrimitive);
+
+        GeometryNodeCreation& nodeCreation = output.nodes.emplace_back();
+        nodeCreation.primitiveBufferDeviceAddress = curveBufferDeviceAddress.deviceAddress;
+        nodeCreation.indexBufferDeviceAddress = curvePrimitiveBufferDeviceAddress.deviceAddress;
+        nodeCreation.curveStrandBufferDeviceAddress = curveStrandBufferDeviceAddress.deviceAddress;
+        nodeCreation.material = hair.material;
+        nodeCreation.curveRadius = hair.curveRadius;
+    }
 
     return output;
 }
 
-BLASInput InitializeBLASInput(const std::shared_ptr<Model>& model, const Node& node, const VoxelMesh& voxelMesh, const std::shared_ptr<VulkanContext>& vulkanContext)
+BLASInput InitializeBLASInput(const std::shared_ptr<Model>& model, const Node& node, const VoxelMesh& voxelMesh, uint32_t level, const std::shared_ptr<VulkanContext>& vulkanContext)
 {
     BLASInput output {};
     output.type = BLASType::eVoxels;
     output.transform = node.GetWorldMatrix();
 
+    const VoxelLevel& voxelLevel = voxelMesh.levels[level];
+
     vk::DeviceOrHostAddressConstKHR aabbBufferDeviceAddress {};
-    aabbBufferDeviceAddress.deviceAddress = vulkanContext->GetBufferDeviceAddress(model->aabbBuffer->buffer) + voxelMesh.firstAabb * sizeof(AABB);
+    aabbBufferDeviceAddress.deviceAddress = vulkanContext->GetBufferDeviceAddress(model->aabbBuffer->buffer) + voxelLevel.firstAabb * sizeof(AABB);
 
     vk::AccelerationStructureGeometryAabbsDataKHR aabbData {};
     aabbData.data = aabbBufferDeviceAddress;
     aabbData.stride = sizeof(AABB);
 
-    vk::AccelerationStructureGeometryKHR& accelerationStructureGeometry = output.geometry;
+    vk::AccelerationStructureGeometryKHR& accelerationStructureGeometry = output.geometries.emplace_back();
     accelerationStructureGeometry.flags = vk::GeometryFlagBitsKHR::eOpaque;
     accelerationStructureGeometry.geometryType = vk::GeometryTypeKHR::eAabbs;
     accelerationStructureGeometry.geometry.aabbs = aabbData;
 
-    const uint32_t primitiveCount = voxelMesh.aabbCount;
+    const uint32_t primitiveCount = voxelLevel.aabbCount;
 
-    vk::AccelerationStructureBuildRangeInfoKHR& buildRangeInfo = output.info;
+    vk::AccelerationStructureBuildRangeInfoKHR& buildRangeInfo = output.infos.emplace_back();
     buildRangeInfo.primitiveCount = primitiveCount;
     buildRangeInfo.primitiveOffset = 0;
     buildRangeInfo.firstVertex = 0;
     buildRangeInfo.transformOffset = 0;
 
-    GeometryNodeCreation& nodeCreation = output.node;
-    nodeCreation.primitiveBufferDeviceAddress = vk::DeviceAddress {}; // TODO: Accel structure
+    // The level's bricks and its brick index grid, whose indices are relative to the first brick of the level
+    GeometryNodeCreation& nodeCreation = output.nodes.emplace_back();
+    nodeCreation.primitiveBufferDeviceAddress = vulkanContext->GetBufferDeviceAddress(model->voxelBrickBuffer->buffer) + voxelLevel.firstBrick * sizeof(VoxelBrick);
+    nodeCreation.indexBufferDeviceAddress = vulkanContext->GetBufferDeviceAddress(model->voxelBrickIndexBuffer->buffer) + voxelLevel.firstBrickIndex * sizeof(uint32_t);
     nodeCreation.material = voxelMesh.material;
 
     return output;
@@ -658,8 +908,10 @@ BLASInput InitializeBLASInput(const std::shared_ptr<Model>& model, const Node& n
 
     vk::DeviceOrHostAddressConstKHR positionBufferDeviceAddress {};
     vk::DeviceOrHostAddressConstKHR radiusBufferDeviceAddress {};
+    vk::DeviceOrHostAddressConstKHR indexBufferDeviceAddress {};
     positionBufferDeviceAddress.deviceAddress = vulkanContext->GetBufferDeviceAddress(model->lssPositionBuffer->buffer) + lssMesh.firstVertex * sizeof(glm::vec3);
-    radiusBufferDeviceAddress.deviceAddress = vulkanContext->GetBufferDeviceAddress(model->lssRadiusBuffer->buffer) + lssMesh.firstVertex * sizeof(float);
+    radiusBufferDeviceAddress.deviceAddress = vulkanContext->GetBufferDeviceAddress(model->lssRadiusBuffer->buffer) + lssMesh.firstRadius * sizeof(float);
+    indexBufferDeviceAddress.deviceAddress = vulkanContext->GetBufferDeviceAddress(model->lssIndexBuffer->buffer) + lssMesh.firstIndex * sizeof(uint32_t);
 
     vk::AccelerationStructureGeometryLinearSweptSpheresDataNV& lssData = output.lssInfo;
     lssData.vertexFormat = vk::Format::eR32G32B32Sfloat;
@@ -668,60 +920,135 @@ BLASInput InitializeBLASInput(const std::shared_ptr<Model>& model, const Node& n
     lssData.radiusFormat = vk::Format::eR32Sfloat;
     lssData.radiusData = radiusBufferDeviceAddress;
     lssData.radiusStride = sizeof(float);
-    lssData.indexType = vk::IndexType::eNoneNV;
-    lssData.indexingMode = vk::RayTracingLssIndexingModeNV::eList;
+    lssData.indexType = vk::IndexType::eUint32;
+    lssData.indexData = indexBufferDeviceAddress;
+    lssData.indexStride = sizeof(uint32_t);
+    lssData.indexingMode = vk::RayTracingLssIndexingModeNV::eSuccessive; // Every index is the first vertex of a segment, strands are separated by not having an index for their last vertex
     lssData.endCapsMode = vk::RayTracingLssPrimitiveEndCapsModeNV::eChained;
 
-    vk::AccelerationStructureGeometryKHR& accelerationStructureGeometry = output.geometry;
+    vk::AccelerationStructureGeometryKHR& accelerationStructureGeometry = output.geometries.emplace_back();
     accelerationStructureGeometry.flags = vk::GeometryFlagBitsKHR::eOpaque;
     accelerationStructureGeometry.geometryType = vk::GeometryTypeKHR::eLinearSweptSpheresNV;
     accelerationStructureGeometry.pNext = &output.lssInfo;
 
-    const uint32_t primitiveCount = lssMesh.vertexCount / 2;
+    const uint32_t primitiveCount = lssMesh.indexCount;
 
-    vk::AccelerationStructureBuildRangeInfoKHR& buildRangeInfo = output.info;
+    vk::AccelerationStructureBuildRangeInfoKHR& buildRangeInfo = output.infos.emplace_back();
     buildRangeInfo.primitiveCount = primitiveCount;
     buildRangeInfo.primitiveOffset = 0;
     buildRangeInfo.firstVertex = 0;
     buildRangeInfo.transformOffset = 0;
 
-    GeometryNodeCreation& nodeCreation = output.node;
+    GeometryNodeCreation& nodeCreation = output.nodes.emplace_back();
     nodeCreation.material = lssMesh.material;
 
     return output;
 }
 
-void Renderer::InitializeBLAS()
+Renderer::Scene Renderer::BuildScene(std::vector<std::shared_ptr<Model>>&& models, const Scene& previousScene, const glm::vec3& cameraPosition, float projectionScale) const
+{
+    Scene scene {};
+    scene.models = std::move(models);
+    InitializeBLAS(scene, previousScene);
+
+    for (BLASLODChain& chain : scene.blasLODChains)
+    {
+        SelectLODLevel(chain.currentLevel, chain.levelCount, chain.boundsCenter, chain.boundsRadius, cameraPosition, projectionScale);
+    }
+
+    scene.tlas = std::make_unique<TopLevelAccelerationStructure>(scene.blases, SelectedBLASes(scene), _bindlessResources, _vulkanContext);
+    _bindlessResources->UpdateDescriptorSet();
+    return scene;
+}
+
+void Renderer::InitializeBLAS(Scene& scene, const Scene& previousScene) const
 {
-    for (const auto& model : _models)
+    for (uint32_t modelIndex = 0; modelIndex < scene.models.size(); ++modelIndex)
     {
+        const std::shared_ptr<Model>& model = scene.models[modelIndex];
+        scene.firstModelLODChains.push_back(scene.blasLODChains.size());
+
+        // Unchanged models take over their LOD chains from the previous scene, the shared BLASes are appended to this scene's
+        if (modelIndex < previousScene.models.size() && previousScene.models[modelIndex] == model)
+        {
+            const uint32_t firstChain = previousScene.firstModelLODChains[modelIndex];
+            const uint32_t endChain = modelIndex + 1 < previousScene.firstModelLODChains.size() ? previousScene.firstModelLODChains[modelIndex + 1] : previousScene.blasLODChains.size();
+            for (uint32_t chainIndex = firstChain; chainIndex < endChain; ++chainIndex)
+            {
+                BLASLODChain& chain = scene.blasLODChains.emplace_back(previousScene.blasLODChains[chainIndex]);
+                const auto previousBLASes = previousScene.blases.begin() + chain.firstBLAS;
+                chain.firstBLAS = scene.blases.size();
+                scene.blases.insert(scene.blases.end(), previousBLASes, previousBLASes + chain.levelCount);
+            }
+            continue;
+        }
+
         std::shared_ptr<SceneGraph> sceneGraph = model->sceneGraph;
 
         for (const auto& node : sceneGraph->nodes)
         {
+            const glm::mat4 worldMatrix = node.GetWorldMatrix();
+
+            // Creates a BLAS for every level of detail of a geometry, with the input of each level given by the function
+            const auto addLODChain = [&](const AABB& boundingBox, uint32_t levelCount, const auto& levelInput)
+            {
+                const float maxScale = std::max({ glm::length(glm::vec3(worldMatrix[0])), glm::length(glm::vec3(worldMatrix[1])), glm::length(glm::vec3(worldMatrix[2])) });
+
+                BLASLODChain& chain = scene.blasLODChains.emplace_back();
+                chain.firstBLAS = scene.blases.size();
+                chain.levelCount = levelCount;
+                chain.boundsCenter = glm::vec3(worldMatrix * glm::vec4((boundingBox.min + boundingBox.max) * 0.5f, 1.0f));
+                chain.boundsRadius = glm::length(boundingBox.max - boundingBox.min) * 0.5f * maxScale;
+
+                for (uint32_t level = 0; level < chain.levelCount; ++level)
+                {
+                    BLASInput input = levelInput(level);
+                    scene.blases.emplace_back(std::make_shared<const BottomLevelAccelerationStructure>(input, _bindlessResources, _vulkanContext));
+                }
+            };
+
+            // Levels of detail stored as separate geometries of the scene graph, the node always refers to the full detail level
+            const auto initializeLODChain = [&](const auto& geometries, uint32_t geometryIndex)
+            {
+                addLODChain(geometries[geometryIndex].boundingBox, sceneGraph->lodLevelCount, [&](uint32_t level)
+                    { return InitializeBLASInput(model, node, geometries[sceneGraph->GetLODIndex(geometryIndex, level, geometries.size())], _vulkanContext); });
+            };
+
             for (const auto mesh : node.meshes)
             {
-                BLASInput input = InitializeBLASInput(model, node, sceneGraph->meshes[mesh], _vulkanContext);
-                _blases.emplace_back(input, _bindlessResources, _vulkanContext);
+                initializeLODChain(sceneGraph->meshes, mesh);
             }
 
             for (const auto hair : node.hairs)
             {
-                BLASInput input = InitializeBLASInput(model, node, sceneGraph->hairs[hair], _vulkanContext);
-                _blases.emplace_back(input, _bindlessResources, _vulkanContext);
+                initializeLODChain(sceneGraph->hairs, hair);
             }
 
-            for (const auto voxelMesh : node.voxelMeshes)
+            // Voxel meshes carry their levels of detail in their occupancy pyramid, where every level halves the resolution
+            for (const auto voxelMeshIndex : node.voxelMeshes)
             {
-                BLASInput input = InitializeBLASInput(model, node, sceneGraph->voxelMeshes[voxelMesh], _vulkanContext);
-                _blases.emplace_back(input, _bindlessResources, _vulkanContext);
+                const VoxelMesh& voxelMesh = sceneGraph->voxelMeshes[voxelMeshIndex];
+                addLODChain(voxelMesh.boundingBox, voxelMesh.levels.size(), [&](uint32_t level)
+                    { return InitializeBLASInput(model, node, voxelMesh, level, _vulkanContext); });
             }
 
             for (const auto lssMesh : node.lssMeshes)
             {
-                BLASInput input = InitializeBLASInput(model, node, sceneGraph->lssMeshes[lssMesh], _vulkanContext);
-                _blases.emplace_back(input, _bindlessResources, _vulkanContext);
+                initializeLODChain(sceneGraph->lssMeshes, lssMesh);
             }
         }
     }
 }
+
+std::vector<uint32_t> Renderer::SelectedBLASes(const Scene& scene)
+{
+    std::vector<uint32_t> instances {};
+    instances.reserve(scene.blasLODChains.size());
+
+    for (const BLASLODChain& chain : scene.blasLODChains)
+    {
+        instances.emplace_back(chain.firstBLAS + chain.currentLevel);
+    }
+
+    return instances;
+}
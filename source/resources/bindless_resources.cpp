@@ -2,6 +2,8 @@
 #include "single_time_commands.hpp"
 #include "vk_common.hpp"
 #include "vulkan_context.hpp"
+#include <algorithm>
+#include <numeric>
 #include <spdlog/spdlog.h>
 
 ImageResources::ImageResources(const std::shared_ptr<VulkanContext>& vulkanContext)
@@ -30,11 +32,28 @@ ResourceHandle<GeometryNode> GeometryNodeResources::Create(const GeometryNodeCre
     return ResourceManager::Create(GeometryNode(creation));
 }
 
+ResourceHandle<GeometryNode> GeometryNodeResources::CreateRange(const std::vector<GeometryNodeCreation>& creations)
+{
+    std::vector<GeometryNode> nodes {};
+    nodes.reserve(creations.size());
+    for (const GeometryNodeCreation& creation : creations)
+    {
+        nodes.emplace_back(creation);
+    }
+
+    return ResourceManager::CreateRange(std::move(nodes));
+}
+
 ResourceHandle<BLASInstance> BLASInstanceResources::Create(const BLASInstanceCreation& creation)
 {
     return ResourceManager::Create(BLASInstance(creation));
 }
 
+ResourceHandle<BLASInstance> BLASInstanceResources::CreateRange(const std::vector<BLASInstanceCreation>& creations)
+{
+    return ResourceManager::CreateRange(std::vector<BLASInstance>(creations.begin(), creations.end()));
+}
+
 BindlessResources::BindlessResources(const std::shared_ptr<VulkanContext>& vulkanContext)
     : _vulkanContext(vulkanContext)
     , _imageResources(vulkanContext)
@@ -59,6 +78,11 @@ BindlessResources::BindlessResources(const std::shared_ptr<VulkanContext>& vulka
         .SetFormat(vk::Format::eR8G8B8A8Unorm)
         .SetData(data);
     _fallbackImage = _imageResources.Create(fallbackImageCreation);
+
+    // Every slot starts out with the fallback image, later uploads only write the slots of new images
+    std::vector<uint32_t> imageIndices(MAX_RESOURCES);
+    std::iota(imageIndices.begin(), imageIndices.end(), 0);
+    WriteImageDescriptors(imageIndices, [this](uint32_t) -> const Image& { return _imageResources.Get(_fallbackImage); });
 }
 
 BindlessResources::~BindlessResources()
@@ -76,7 +100,7 @@ void BindlessResources::UpdateDescriptorSet()
 
 void BindlessResources::UploadImages()
 {
-    if (_imageResources.GetAll().empty())
+    if (!_imageResources.HasDirtyRanges())
     {
         return;
     }
@@ -87,144 +111,145 @@ void BindlessResources::UploadImages()
         return;
     }
 
-    std::array<vk::DescriptorImageInfo, MAX_RESOURCES> imageInfos {};
-    std::array<vk::WriteDescriptorSet, MAX_RESOURCES> descriptorWrites {};
+    // Only the new images are written, descriptors of images in use by frames in flight can't be updated
+    std::vector<uint32_t> imageIndices {};
+    for (const ResourceRange& range : _imageResources.TakeDirtyRanges())
+    {
+        for (uint32_t i = range.first; i < range.first + range.count; ++i)
+        {
+            imageIndices.push_back(i);
+        }
+    }
+
+    WriteImageDescriptors(imageIndices, [this](uint32_t i) -> const Image& { return _imageResources.GetAll()[i]; });
+}
 
-    for (uint32_t i = 0; i < MAX_RESOURCES; ++i)
+void BindlessResources::WriteImageDescriptors(const std::vector<uint32_t>& indices, const std::function<const Image&(uint32_t)>& getImage)
+{
+    std::vector<vk::DescriptorImageInfo> imageInfos(indices.size());
+    std::vector<vk::WriteDescriptorSet> descriptorWrites(indices.size());
+
+    for (uint32_t i = 0; i < indices.size(); ++i)
     {
-        const Image& image = _imageResources.GetAll().size() > i ? _imageResources.GetAll()[i] : _imageResources.Get(_fallbackImage);
+        const Image& image = getImage(indices[i]);
 
-        vk::DescriptorImageInfo& imageInfo = imageInfos.at(i);
+        vk::DescriptorImageInfo& imageInfo = imageInfos[i];
         imageInfo.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
         imageInfo.imageView = image.view;
         imageInfo.sampler = _fallbackSampler->sampler;
 
-        vk::WriteDescriptorSet& descriptorWrite = descriptorWrites.at(i);
+        vk::WriteDescriptorSet& descriptorWrite = descriptorWrites[i];
         descriptorWrite.dstSet = _bindlessSet;
         descriptorWrite.dstBinding = static_cast<uint32_t>(BindlessBinding::eImages);
-        descriptorWrite.dstArrayElement = i;
+        descriptorWrite.dstArrayElement = indices[i];
         descriptorWrite.descriptorType = vk::DescriptorType::eCombinedImageSampler;
         descriptorWrite.descriptorCount = 1;
         descriptorWrite.pImageInfo = &imageInfo;
     }
 
-    _vulkanContext->Device().updateDescriptorSets(MAX_RESOURCES, descriptorWrites.data(), 0, nullptr);
+    _vulkanContext->Device().updateDescriptorSets(descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
 }
 
 void BindlessResources::UploadMaterials()
 {
-    if (_materialResources.GetAll().empty())
+    if (!_materialResources.HasDirtyRanges())
     {
         return;
     }
 
-    if (_materialResources.GetAll().size() > MAX_RESOURCES)
+    if (_materialResources.GetAll().size() > _materialBindingCapacity)
     {
         spdlog::error("[RESOURCES] Material buffer is too small to fit all of the available materials");
         return;
     }
 
     // TODO: Transfer to host memory
-    std::memcpy(_materialBuffer->mappedPtr, _materialResources.GetAll().data(), _materialResources.GetAll().size() * sizeof(Material));
-
-    vk::DescriptorBufferInfo bufferInfo {};
-    bufferInfo.buffer = _materialBuffer->buffer;
-    bufferInfo.offset = 0;
-    bufferInfo.range = sizeof(Material) * _materialResources.GetAll().size();
-
-    vk::WriteDescriptorSet descriptorWrite {};
-    descriptorWrite.dstSet = _bindlessSet;
-    descriptorWrite.dstBinding = static_cast<uint32_t>(BindlessBinding::eMaterials);
-    descriptorWrite.dstArrayElement = 0;
-    descriptorWrite.descriptorType = vk::DescriptorType::eUniformBuffer;
-    descriptorWrite.descriptorCount = 1;
-    descriptorWrite.pBufferInfo = &bufferInfo;
-
-    _vulkanContext->Device().updateDescriptorSets(1, &descriptorWrite, 0, nullptr);
+    for (const ResourceRange& range : _materialResources.TakeDirtyRanges())
+    {
+        std::memcpy(static_cast<Material*>(_materialBuffer->mappedPtr) + range.first, _materialResources.GetAll().data() + range.first, range.count * sizeof(Material));
+    }
 }
 
 void BindlessResources::UploadGeometryNodes()
 {
-    if (_geometryNodeResources.GetAll().empty())
-    {
-        return;
-    }
-
     if (_geometryNodeResources.GetAll().size() > MAX_RESOURCES)
     {
         spdlog::error("[RESOURCES] Geometry node buffer is too small to fit all of the available nodes");
         return;
     }
 
-    vk::DeviceSize bufferSize = _geometryNodeResources.GetAll().size() * sizeof(GeometryNode);
-    BufferCreation stagingBufferCreation {};
-    stagingBufferCreation.SetSize(bufferSize)
-        .SetUsageFlags(vk::BufferUsageFlagBits::eTransferSrc)
-        .SetMemoryUsage(VMA_MEMORY_USAGE_CPU_ONLY)
-        .SetIsMappable(true)
-        .SetName("GeometryNode staging buffer");
-    Buffer stagingBuffer(stagingBufferCreation, _vulkanContext);
-    std::memcpy(stagingBuffer.mappedPtr, _geometryNodeResources.GetAll().data(), bufferSize);
-
-    SingleTimeCommands commands(_vulkanContext);
-    commands.Record([&](vk::CommandBuffer commandBuffer)
-        { VkCopyBufferToBuffer(commandBuffer, stagingBuffer.buffer, _geometryNodeBuffer->buffer, bufferSize); });
-    commands.SubmitAndWait();
-
-    vk::DescriptorBufferInfo bufferInfo {};
-    bufferInfo.buffer = _geometryNodeBuffer->buffer;
-    bufferInfo.offset = 0;
-    bufferInfo.range = bufferSize;
+    UploadDirtyRanges(_geometryNodeResources, *_geometryNodeBuffer, "GeometryNode staging buffer");
+}
 
-    vk::WriteDescriptorSet descriptorWrite {};
-    descriptorWrite.dstSet = _bindlessSet;
-    descriptorWrite.dstBinding = static_cast<uint32_t>(BindlessBinding::eGeometryNodes);
-    descriptorWrite.dstArrayElement = 0;
-    descriptorWrite.descriptorType = vk::DescriptorType::eStorageBuffer;
-    descriptorWrite.descriptorCount = 1;
-    descriptorWrite.pBufferInfo = &bufferInfo;
+void BindlessResources::UploadBLASInstances()
+{
+    if (_blasInstanceResources.GetAll().size() > MAX_RESOURCES)
+    {
+        spdlog::error("[RESOURCES] BLAS instance buffer is too small to fit all of the available BLASes");
+        return;
+    }
 
-    _vulkanContext->Device().updateDescriptorSets(1, &descriptorWrite, 0, nullptr);
+    UploadDirtyRanges(_blasInstanceResources, *_blasInstanceBuffer, "BLASInstance staging buffer");
 }
 
-void BindlessResources::UploadBLASInstances()
+template <typename T>
+void BindlessResources::UploadDirtyRanges(ResourceManager<T>& resources, const Buffer& buffer, std::string_view stagingBufferName)
 {
-    if (_blasInstanceResources.GetAll().empty())
+    if (!resources.HasDirtyRanges())
     {
         return;
     }
 
-    if (_blasInstanceResources.GetAll().size() > MAX_RESOURCES)
+    // Ranges are copied one after another into the staging buffer, the ranges in use by frames in flight are left untouched
+    const std::vector<ResourceRange> ranges = resources.TakeDirtyRanges();
+    std::vector<vk::BufferCopy> copyRegions {};
+    vk::DeviceSize stagingSize = 0;
+    for (const ResourceRange& range : ranges)
+    {
+        vk::BufferCopy& copyRegion = copyRegions.emplace_back();
+        copyRegion.srcOffset = stagingSize;
+        copyRegion.dstOffset = range.first * sizeof(T);
+        copyRegion.size = range.count * sizeof(T);
+        stagingSize += copyRegion.size;
+    }
+
+    if (stagingSize == 0)
     {
-        spdlog::error("[RESOURCES] BLAS instance buffer is too small to fit all of the available BLASes");
         return;
     }
 
-    vk::DeviceSize bufferSize = _blasInstanceResources.GetAll().size() * sizeof(BLASInstance);
     BufferCreation stagingBufferCreation {};
-    stagingBufferCreation.SetSize(bufferSize)
+    stagingBufferCreation.SetSize(stagingSize)
         .SetUsageFlags(vk::BufferUsageFlagBits::eTransferSrc)
         .SetMemoryUsage(VMA_MEMORY_USAGE_CPU_ONLY)
         .SetIsMappable(true)
-        .SetName("BLASInstance staging buffer");
+        .SetName(stagingBufferName);
     Buffer stagingBuffer(stagingBufferCreation, _vulkanContext);
-    std::memcpy(stagingBuffer.mappedPtr, _blasInstanceResources.GetAll().data(), bufferSize);
+
+    for (uint32_t i = 0; i < ranges.size(); ++i)
+    {
+        std::memcpy(static_cast<std::byte*>(stagingBuffer.mappedPtr) + copyRegions[i].srcOffset, resources.GetAll().data() + ranges[i].first, copyRegions[i].size);
+    }
 
     SingleTimeCommands commands(_vulkanContext);
     commands.Record([&](vk::CommandBuffer commandBuffer)
-        { VkCopyBufferToBuffer(commandBuffer, stagingBuffer.buffer, _blasInstanceBuffer->buffer, bufferSize); });
+        { commandBuffer.copyBuffer(stagingBuffer.buffer, buffer.buffer, copyRegions.size(), copyRegions.data()); });
     commands.SubmitAndWait();
+}
 
+void BindlessResources::WriteBufferDescriptor(BindlessBinding binding, vk::DescriptorType type, const Buffer& buffer, vk::DeviceSize range)
+{
+    // The buffer is bound once, so uploading resources never updates a descriptor in use by frames in flight
     vk::DescriptorBufferInfo bufferInfo {};
-    bufferInfo.buffer = _blasInstanceBuffer->buffer;
+    bufferInfo.buffer = buffer.buffer;
     bufferInfo.offset = 0;
-    bufferInfo.range = bufferSize;
+    bufferInfo.range = range;
 
     vk::WriteDescriptorSet descriptorWrite {};
     descriptorWrite.dstSet = _bindlessSet;
-    descriptorWrite.dstBinding = static_cast<uint32_t>(BindlessBinding::eBLASInstances);
+    descriptorWrite.dstBinding = static_cast<uint32_t>(binding);
     descriptorWrite.dstArrayElement = 0;
-    descriptorWrite.descriptorType = vk::DescriptorType::eStorageBuffer;
+    descriptorWrite.descriptorType = type;
     descriptorWrite.descriptorCount = 1;
     descriptorWrite.pBufferInfo = &bufferInfo;
 
@@ -267,7 +292,7 @@ void BindlessResources::InitializeSet()
     layoutCreateInfo.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
 
     std::array<vk::DescriptorBindingFlagsEXT, 4> bindingFlags = {
-        vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind,
+        vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending,
         vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind,
         vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind,
         vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind,
@@ -297,6 +322,11 @@ void BindlessResources::InitializeMaterialBuffer()
         .SetName("Material buffer");
 
     _materialBuffer = std::make_unique<Buffer>(creation, _vulkanContext);
+
+    // Uniform buffer bindings are limited in size, only the materials that fit are bound
+    const uint32_t maxUniformBufferRange = _vulkanContext->PhysicalDevice().getProperties().limits.maxUniformBufferRange;
+    _materialBindingCapacity = std::min(MAX_RESOURCES, maxUniformBufferRange / static_cast<uint32_t>(sizeof(Material)));
+    WriteBufferDescriptor(BindlessBinding::eMaterials, vk::DescriptorType::eUniformBuffer, *_materialBuffer, _materialBindingCapacity * sizeof(Material));
 }
 
 void BindlessResources::InitializeGeometryNodeBuffer()
@@ -309,6 +339,7 @@ void BindlessResources::InitializeGeometryNodeBuffer()
         .SetName("GeometryNode buffer");
 
     _geometryNodeBuffer = std::make_unique<Buffer>(creation, _vulkanContext);
+    WriteBufferDescriptor(BindlessBinding::eGeometryNodes, vk::DescriptorType::eStorageBuffer, *_geometryNodeBuffer);
 }
 
 void BindlessResources::InitializeBLASInstanceBuffer()
@@ -321,4 +352,5 @@ void BindlessResources::InitializeBLASInstanceBuffer()
         .SetName("BLASInstance buffer");
 
     _blasInstanceBuffer = std::make_unique<Buffer>(creation, _vulkanContext);
+    WriteBufferDescriptor(BindlessBinding::eBLASInstances, vk::DescriptorType::eStorageBuffer, *_blasInstanceBuffer);
 }
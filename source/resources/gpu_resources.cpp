@@ -445,5 +445,11 @@ GeometryNode::GeometryNode(const GeometryNodeCreation& creation)
 {
     primitiveBufferDeviceAddress = creation.primitiveBufferDeviceAddress;
     indexBufferDeviceAddress = creation.indexBufferDeviceAddress;
+    curveStrandBufferDeviceAddress = creation.curveStrandBufferDeviceAddress;
     materialIndex = creation.material.handle;
+    curveRadius = creation.curveRadius;
+    quantizedVertices = creation.quantizedVertices;
+    signedQuantizedVertices = creation.signedQuantizedVertices;
+    positionOffset = creation.positionOffset;
+    positionScale = creation.positionScale;
 }
@@ -0,0 +1,273 @@
+#include "resources/model/capsule_voxel_overlap.hpp"
+#include "cpu_features.hpp"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+// The squared distance between the point at t on the capsule segment and a box is convex in t and its derivative is piecewise linear,
+// with breaks only where the point enters or leaves the slab of the box on an axis. The closest point is found by evaluating the
+// derivative at t = 0, t = 1 and at those breaks, and interpolating it to zero between the last break where it is negative and the first
+// break where it is positive. No break lies between those two, so the derivative is linear in between and the interpolation is exact.
+// Kernels below evaluate the same operations in the same order, so they agree with the scalar kernel voxel for voxel.
+
+using CapsuleRowKernel = uint64_t (*)(const Capsule& capsule, const glm::vec3& firstVoxelMin, float voxelSize, uint32_t voxelCount);
+
+// Half the derivative of the squared distance between the point at t and the box, the squared distance itself is written to distanceSquared
+inline float DistanceSlopeScalar(const glm::vec3& start, const glm::vec3& direction, const glm::vec3& boxMin, const glm::vec3& boxMax, float t, float& distanceSquared)
+{
+    float slope = 0.0f;
+    distanceSquared = 0.0f;
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        const float point = start[axis] + t * direction[axis];
+        const float outside = point - std::min(std::max(point, boxMin[axis]), boxMax[axis]);
+        slope = slope + direction[axis] * outside;
+        distanceSquared = distanceSquared + outside * outside;
+    }
+
+    return slope;
+}
+
+bool CapsuleOverlapsBox(const Capsule& capsule, const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+    const glm::vec3 direction = capsule.end - capsule.start;
+
+    // Breaks of every axis the segment moves along, axes it doesn't move along add t = 0 again
+    float breaks[8] { 0.0f, 1.0f };
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        if (direction[axis] != 0.0f)
+        {
+            breaks[2 + axis * 2] = std::min(std::max((boxMin[axis] - capsule.start[axis]) / direction[axis], 0.0f), 1.0f);
+            breaks[3 + axis * 2] = std::min(std::max((boxMax[axis] - capsule.start[axis]) / direction[axis], 0.0f), 1.0f);
+        }
+    }
+
+    float tLow = 0.0f, slopeLow = 0.0f;
+    float tHigh = 1.0f, slopeHigh = 0.0f;
+    float distanceSquared;
+    for (const float t : breaks)
+    {
+        const float slope = DistanceSlopeScalar(capsule.start, direction, boxMin, boxMax, t, distanceSquared);
+        if (slope <= 0.0f && t >= tLow)
+        {
+            tLow = t;
+            slopeLow = slope;
+        }
+        if (slope > 0.0f && t <= tHigh)
+        {
+            tHigh = t;
+            slopeHigh = slope;
+        }
+    }
+
+    const float ratio = slopeHigh > slopeLow ? std::min(std::max(-slopeLow / (slopeHigh - slopeLow), 0.0f), 1.0f) : 0.0f;
+    DistanceSlopeScalar(capsule.start, direction, boxMin, boxMax, tLow + (tHigh - tLow) * ratio, distanceSquared);
+    return distanceSquared <= capsule.radius * capsule.radius;
+}
+
+uint64_t CapsuleOverlapRowScalar(const Capsule& capsule, const glm::vec3& firstVoxelMin, float voxelSize, uint32_t voxelCount)
+{
+    uint64_t overlaps = 0;
+    for (uint32_t i = 0; i < voxelCount; ++i)
+    {
+        glm::vec3 boxMin = firstVoxelMin;
+        boxMin.x = firstVoxelMin.x + static_cast<float>(i) * voxelSize;
+        const glm::vec3 boxMax = boxMin + voxelSize;
+
+        if (CapsuleOverlapsBox(capsule, boxMin, boxMax))
+        {
+            overlaps |= uint64_t { 1 } << i;
+        }
+    }
+
+    return overlaps;
+}
+
+// Lanes past the voxel count test voxels further along the row, which only costs time since nothing is read from memory,
+// so rows are processed in whole vectors and the extra bits are masked off at the end
+uint64_t RowMask(uint32_t voxelCount)
+{
+    return voxelCount >= 64 ? ~uint64_t { 0 } : (uint64_t { 1 } << voxelCount) - 1;
+}
+
+#ifdef VKHRT_X86
+
+TARGET_SSE4 inline __m128 DistanceSlopeSSE4(const __m128 start[3], const __m128 direction[3], const __m128 boxMin[3], const __m128 boxMax[3], __m128 t, __m128& distanceSquared)
+{
+    __m128 slope = _mm_setzero_ps();
+    distanceSquared = _mm_setzero_ps();
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        const __m128 point = _mm_add_ps(start[axis], _mm_mul_ps(t, direction[axis]));
+        const __m128 outside = _mm_sub_ps(point, _mm_min_ps(_mm_max_ps(point, boxMin[axis]), boxMax[axis]));
+        slope = _mm_add_ps(slope, _mm_mul_ps(direction[axis], outside));
+        distanceSquared = _mm_add_ps(distanceSquared, _mm_mul_ps(outside, outside));
+    }
+
+    return slope;
+}
+
+TARGET_SSE4 uint64_t CapsuleOverlapRowSSE4(const Capsule& capsule, const glm::vec3& firstVoxelMin, float voxelSize, uint32_t voxelCount)
+{
+    constexpr uint32_t lanes = 4;
+    const glm::vec3 capsuleDirection = capsule.end - capsule.start;
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 size = _mm_set1_ps(voxelSize);
+    const __m128 radiusSquared = _mm_set1_ps(capsule.radius * capsule.radius);
+
+    __m128 start[3], direction[3], boxMin[3], boxMax[3];
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        start[axis] = _mm_set1_ps(capsule.start[axis]);
+        direction[axis] = _mm_set1_ps(capsuleDirection[axis]);
+        boxMin[axis] = _mm_set1_ps(firstVoxelMin[axis]);
+        boxMax[axis] = _mm_add_ps(boxMin[axis], size);
+    }
+
+    uint64_t overlaps = 0;
+    for (uint32_t i = 0; i < voxelCount; i += lanes)
+    {
+        const __m128 index = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(static_cast<int32_t>(i)), _mm_setr_epi32(0, 1, 2, 3)));
+        boxMin[0] = _mm_add_ps(_mm_set1_ps(firstVoxelMin.x), _mm_mul_ps(index, size));
+        boxMax[0] = _mm_add_ps(boxMin[0], size);
+
+        __m128 breaks[8] { zero, one, zero, zero, zero, zero, zero, zero };
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            if (capsuleDirection[axis] != 0.0f)
+            {
+                breaks[2 + axis * 2] = _mm_min_ps(_mm_max_ps(_mm_div_ps(_mm_sub_ps(boxMin[axis], start[axis]), direction[axis]), zero), one);
+                breaks[3 + axis * 2] = _mm_min_ps(_mm_max_ps(_mm_div_ps(_mm_sub_ps(boxMax[axis], start[axis]), direction[axis]), zero), one);
+            }
+        }
+
+        __m128 tLow = zero, slopeLow = zero;
+        __m128 tHigh = one, slopeHigh = zero;
+        __m128 distanceSquared;
+        for (const __m128 t : breaks)
+        {
+            const __m128 slope = DistanceSlopeSSE4(start, direction, boxMin, boxMax, t, distanceSquared);
+            const __m128 negative = _mm_cmple_ps(slope, zero);
+            const __m128 lower = _mm_and_ps(negative, _mm_cmpge_ps(t, tLow));
+            const __m128 higher = _mm_andnot_ps(negative, _mm_cmple_ps(t, tHigh));
+            tLow = _mm_blendv_ps(tLow, t, lower);
+            slopeLow = _mm_blendv_ps(slopeLow, slope, lower);
+            tHigh = _mm_blendv_ps(tHigh, t, higher);
+            slopeHigh = _mm_blendv_ps(slopeHigh, slope, higher);
+        }
+
+        const __m128 slopeRange = _mm_sub_ps(slopeHigh, slopeLow);
+        const __m128 ratio = _mm_min_ps(_mm_max_ps(_mm_div_ps(_mm_sub_ps(zero, slopeLow), slopeRange), zero), one);
+        const __m128 t = _mm_add_ps(tLow, _mm_mul_ps(_mm_sub_ps(tHigh, tLow), _mm_blendv_ps(zero, ratio, _mm_cmpgt_ps(slopeHigh, slopeLow))));
+        DistanceSlopeSSE4(start, direction, boxMin, boxMax, t, distanceSquared);
+
+        overlaps |= static_cast<uint64_t>(_mm_movemask_ps(_mm_cmple_ps(distanceSquared, radiusSquared))) << i;
+    }
+
+    return overlaps & RowMask(voxelCount);
+}
+
+TARGET_AVX2 inline __m256 DistanceSlopeAVX2(const __m256 start[3], const __m256 direction[3], const __m256 boxMin[3], const __m256 boxMax[3], __m256 t, __m256& distanceSquared)
+{
+    __m256 slope = _mm256_setzero_ps();
+    distanceSquared = _mm256_setzero_ps();
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        const __m256 point = _mm256_add_ps(start[axis], _mm256_mul_ps(t, direction[axis]));
+        const __m256 outside = _mm256_sub_ps(point, _mm256_min_ps(_mm256_max_ps(point, boxMin[axis]), boxMax[axis]));
+        slope = _mm256_add_ps(slope, _mm256_mul_ps(direction[axis], outside));
+        distanceSquared = _mm256_add_ps(distanceSquared, _mm256_mul_ps(outside, outside));
+    }
+
+    return slope;
+}
+
+TARGET_AVX2 uint64_t CapsuleOverlapRowAVX2(const Capsule& capsule, const glm::vec3& firstVoxelMin, float voxelSize, uint32_t voxelCount)
+{
+    constexpr uint32_t lanes = 8;
+    const glm::vec3 capsuleDirection = capsule.end - capsule.start;
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 size = _mm256_set1_ps(voxelSize);
+    const __m256 radiusSquared = _mm256_set1_ps(capsule.radius * capsule.radius);
+
+    __m256 start[3], direction[3], boxMin[3], boxMax[3];
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        start[axis] = _mm256_set1_ps(capsule.start[axis]);
+        direction[axis] = _mm256_set1_ps(capsuleDirection[axis]);
+        boxMin[axis] = _mm256_set1_ps(firstVoxelMin[axis]);
+        boxMax[axis] = _mm256_add_ps(boxMin[axis], size);
+    }
+
+    uint64_t overlaps = 0;
+    for (uint32_t i = 0; i < voxelCount; i += lanes)
+    {
+        const __m256 index = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(i)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+        boxMin[0] = _mm256_add_ps(_mm256_set1_ps(firstVoxelMin.x), _mm256_mul_ps(index, size));
+        boxMax[0] = _mm256_add_ps(boxMin[0], size);
+
+        __m256 breaks[8] { zero, one, zero, zero, zero, zero, zero, zero };
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            if (capsuleDirection[axis] != 0.0f)
+            {
+                breaks[2 + axis * 2] = _mm256_min_ps(_mm256_max_ps(_mm256_div_ps(_mm256_sub_ps(boxMin[axis], start[axis]), direction[axis]), zero), one);
+                breaks[3 + axis * 2] = _mm256_min_ps(_mm256_max_ps(_mm256_div_ps(_mm256_sub_ps(boxMax[axis], start[axis]), direction[axis]), zero), one);
+            }
+        }
+
+        __m256 tLow = zero, slopeLow = zero;
+        __m256 tHigh = one, slopeHigh = zero;
+        __m256 distanceSquared;
+        for (const __m256 t : breaks)
+        {
+            const __m256 slope = DistanceSlopeAVX2(start, direction, boxMin, boxMax, t, distanceSquared);
+            const __m256 negative = _mm256_cmp_ps(slope, zero, _CMP_LE_OQ);
+            const __m256 lower = _mm256_and_ps(negative, _mm256_cmp_ps(t, tLow, _CMP_GE_OQ));
+            const __m256 higher = _mm256_andnot_ps(negative, _mm256_cmp_ps(t, tHigh, _CMP_LE_OQ));
+            tLow = _mm256_blendv_ps(tLow, t, lower);
+            slopeLow = _mm256_blendv_ps(slopeLow, slope, lower);
+            tHigh = _mm256_blendv_ps(tHigh, t, higher);
+            slopeHigh = _mm256_blendv_ps(slopeHigh, slope, higher);
+        }
+
+        const __m256 slopeRange = _mm256_sub_ps(slopeHigh, slopeLow);
+        const __m256 ratio = _mm256_min_ps(_mm256_max_ps(_mm256_div_ps(_mm256_sub_ps(zero, slopeLow), slopeRange), zero), one);
+        const __m256 t = _mm256_add_ps(tLow, _mm256_mul_ps(_mm256_sub_ps(tHigh, tLow), _mm256_blendv_ps(zero, ratio, _mm256_cmp_ps(slopeHigh, slopeLow, _CMP_GT_OQ))));
+        DistanceSlopeAVX2(start, direction, boxMin, boxMax, t, distanceSquared);
+
+        overlaps |= static_cast<uint64_t>(_mm256_movemask_ps(_mm256_cmp_ps(distanceSquared, radiusSquared, _CMP_LE_OQ))) << i;
+    }
+
+    return overlaps & RowMask(voxelCount);
+}
+
+#endif
+
+CapsuleRowKernel SelectCapsuleRowKernel()
+{
+#ifdef VKHRT_X86
+    if (IsAVX2Supported())
+    {
+        spdlog::info("[GEOMETRY PROCESSOR] Using AVX2 voxel overlap kernels");
+        return CapsuleOverlapRowAVX2;
+    }
+
+    if (IsSSE4Supported())
+    {
+        spdlog::info("[GEOMETRY PROCESSOR] Using SSE4.1 voxel overlap kernels");
+        return CapsuleOverlapRowSSE4;
+    }
+#endif
+
+    spdlog::info("[GEOMETRY PROCESSOR] Using scalar voxel overlap kernels");
+    return CapsuleOverlapRowScalar;
+}
+
+uint64_t CapsuleOverlapRow(const Capsule& capsule, const glm::vec3& firstVoxelMin, float voxelSize, uint32_t voxelCount)
+{
+    static const CapsuleRowKernel kernel = SelectCapsuleRowKernel();
+    return kernel(capsule, firstVoxelMin, voxelSize, voxelCount);
+}
@@ -0,0 +1,394 @@
+#include "resources/model/curve_fitting.hpp"
+#include "cpu_features.hpp"
+#include <spdlog/spdlog.h>
+#include <cmath>
+
+using CurveFittingKernel = void (*)(const float* x, const float* y, const float* z, uint32_t pointCount, float tension, Curve* curves);
+using CurveBoundingKernel = void (*)(const Curve* curves, uint32_t curveCount, float curveRadius, AABB* aabbs);
+
+struct CurveKernels
+{
+    CurveFittingKernel fit = nullptr;
+    CurveBoundingKernel bound = nullptr;
+};
+
+// Curves are stored as 4 tightly packed vec3's, which lets kernels write them as 12 floats
+static_assert(sizeof(Curve) == sizeof(float) * 12);
+
+inline void FitCurveScalar(const float* x, const float* y, const float* z, uint32_t pointCount, uint32_t segment, float tension, Curve& curve)
+{
+    // Clamp neighbouring points to the strand, so Catmull–Rom works at the ends
+    const uint32_t i0 = segment > 0 ? segment - 1 : segment;
+    const uint32_t i3 = segment + 2 < pointCount ? segment + 2 : segment + 1;
+
+    const glm::vec3 p0(x[i0], y[i0], z[i0]);
+    const glm::vec3 p1(x[segment], y[segment], z[segment]);
+    const glm::vec3 p2(x[segment + 1], y[segment + 1], z[segment + 1]);
+    const glm::vec3 p3(x[i3], y[i3], z[i3]);
+
+    curve.start = p1;
+    curve.controlPoint1 = p1 + (p2 - p0) * (tension / 6.0f);
+    curve.controlPoint2 = p2 - (p3 - p1) * (tension / 6.0f);
+    curve.end = p2;
+}
+
+void FitStrandCurvesScalar(const float* x, const float* y, const float* z, uint32_t pointCount, float tension, Curve* curves)
+{
+    for (uint32_t segment = 0; segment + 1 < pointCount; ++segment)
+    {
+        FitCurveScalar(x, y, z, pointCount, segment, tension, curves[segment]);
+    }
+}
+
+inline float SampleCurveAxis(float p0, float p1, float p2, float p3, float t)
+{
+    const float u = 1.0f - t;
+    return u * u * u * p0 + 3.0f * u * u * t * p1 + 3.0f * u * t * t * p2 + t * t * t * p3;
+}
+
+// Bounds a single axis of a bezier curve by its end points and the roots of its derivative
+inline void CurveExtentsScalar(float p0, float p1, float p2, float p3, float& min, float& max)
+{
+    min = std::min(p0, p3);
+    max = std::max(p0, p3);
+
+    // Derivative divided by 3, as a t^2 + b t + c
+    const float a = p3 - p0 + 3.0f * (p1 - p2);
+    const float b = 2.0f * (p0 - 2.0f * p1 + p2);
+    const float c = p1 - p0;
+
+    const float discriminant = b * b - 4.0f * a * c;
+    if (discriminant < 0.0f)
+    {
+        return;
+    }
+
+    // Numerically stable form, which also finds the single root when a is zero (the other root becomes infinite)
+    const float q = -0.5f * (b + std::copysign(std::sqrt(discriminant), b));
+    const float roots[2] = { q / a, c / q };
+
+    for (const float t : roots)
+    {
+        if (t >= 0.0f && t <= 1.0f)
+        {
+            const float value = SampleCurveAxis(p0, p1, p2, p3, t);
+            min = std::min(min, value);
+            max = std::max(max, value);
+        }
+    }
+}
+
+inline void BoundCurveScalar(const Curve& curve, float curveRadius, AABB& aabb)
+{
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        CurveExtentsScalar(curve.start[axis], curve.controlPoint1[axis], curve.controlPoint2[axis], curve.end[axis], aabb.min[axis], aabb.max[axis]);
+    }
+
+    aabb.min -= curveRadius;
+    aabb.max += curveRadius;
+}
+
+void BoundCurvesScalar(const Curve* curves, uint32_t curveCount, float curveRadius, AABB* aabbs)
+{
+    for (uint32_t i = 0; i < curveCount; ++i)
+    {
+        BoundCurveScalar(curves[i], curveRadius, aabbs[i]);
+    }
+}
+
+#ifdef VKHRT_X86
+
+// Interleaves the SoA lanes of a batch of curves into their AoS layout
+template <uint32_t Lanes>
+inline void StoreCurves(const float (&lanes)[12][Lanes], Curve* curves)
+{
+    for (uint32_t lane = 0; lane < Lanes; ++lane)
+    {
+        float* curve = reinterpret_cast<float*>(&curves[lane]);
+        for (uint32_t component = 0; component < 12; ++component)
+        {
+            curve[component] = lanes[component][lane];
+        }
+    }
+}
+
+// Deinterleaves a batch of curves into SoA lanes, the inverse of StoreCurves
+template <uint32_t Lanes>
+inline void LoadCurves(const Curve* curves, float (&lanes)[12][Lanes])
+{
+    for (uint32_t lane = 0; lane < Lanes; ++lane)
+    {
+        const float* curve = reinterpret_cast<const float*>(&curves[lane]);
+        for (uint32_t component = 0; component < 12; ++component)
+        {
+            lanes[component][lane] = curve[component];
+        }
+    }
+}
+
+template <uint32_t Lanes>
+inline void StoreBounds(const float (&min)[3][Lanes], const float (&max)[3][Lanes], AABB* aabbs)
+{
+    for (uint32_t lane = 0; lane < Lanes; ++lane)
+    {
+        aabbs[lane].min = glm::vec3(min[0][lane], min[1][lane], min[2][lane]);
+        aabbs[lane].max = glm::vec3(max[0][lane], max[1][lane], max[2][lane]);
+    }
+}
+
+TARGET_SSE4 void FitStrandCurvesSSE4(const float* x, const float* y, const float* z, uint32_t pointCount, float tension, Curve* curves)
+{
+    constexpr uint32_t lanes = 4;
+    const uint32_t segmentCount = pointCount - 1;
+    const __m128 scale = _mm_set1_ps(tension / 6.0f);
+    const float* axes[3] = { x, y, z };
+
+    // The first and last segments clamp their neighbours, everything in between has both neighbours on the strand
+    FitCurveScalar(x, y, z, pointCount, 0, tension, curves[0]);
+
+    uint32_t segment = 1;
+    for (; segment + lanes + 1 <= segmentCount; segment += lanes)
+    {
+        alignas(16) float output[12][lanes];
+
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            const __m128 p0 = _mm_loadu_ps(axes[axis] + segment - 1);
+            const __m128 p1 = _mm_loadu_ps(axes[axis] + segment);
+            const __m128 p2 = _mm_loadu_ps(axes[axis] + segment + 1);
+            const __m128 p3 = _mm_loadu_ps(axes[axis] + segment + 2);
+
+            _mm_store_ps(output[axis], p1);
+            _mm_store_ps(output[3 + axis], _mm_add_ps(p1, _mm_mul_ps(_mm_sub_ps(p2, p0), scale)));
+            _mm_store_ps(output[6 + axis], _mm_sub_ps(p2, _mm_mul_ps(_mm_sub_ps(p3, p1), scale)));
+            _mm_store_ps(output[9 + axis], p2);
+        }
+
+        StoreCurves(output, curves + segment);
+    }
+
+    for (; segment < segmentCount; ++segment)
+    {
+        FitCurveScalar(x, y, z, pointCount, segment, tension, curves[segment]);
+    }
+}
+
+TARGET_SSE4 inline __m128 SampleCurveAxisSSE4(__m128 p0, __m128 p1, __m128 p2, __m128 p3, __m128 t)
+{
+    const __m128 three = _mm_set1_ps(3.0f);
+    const __m128 u = _mm_sub_ps(_mm_set1_ps(1.0f), t);
+    const __m128 uu = _mm_mul_ps(u, u);
+    const __m128 tt = _mm_mul_ps(t, t);
+
+    __m128 value = _mm_mul_ps(_mm_mul_ps(uu, u), p0);
+    value = _mm_add_ps(value, _mm_mul_ps(_mm_mul_ps(three, _mm_mul_ps(uu, t)), p1));
+    value = _mm_add_ps(value, _mm_mul_ps(_mm_mul_ps(three, _mm_mul_ps(u, tt)), p2));
+    return _mm_add_ps(value, _mm_mul_ps(_mm_mul_ps(tt, t), p3));
+}
+
+TARGET_SSE4 void BoundCurvesSSE4(const Curve* curves, uint32_t curveCount, float curveRadius, AABB* aabbs)
+{
+    constexpr uint32_t lanes = 4;
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 radius = _mm_set1_ps(curveRadius);
+
+    uint32_t i = 0;
+    for (; i + lanes <= curveCount; i += lanes)
+    {
+        alignas(16) float input[12][lanes];
+        alignas(16) float min[3][lanes];
+        alignas(16) float max[3][lanes];
+        LoadCurves(curves + i, input);
+
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            const __m128 p0 = _mm_load_ps(input[axis]);
+            const __m128 p1 = _mm_load_ps(input[3 + axis]);
+            const __m128 p2 = _mm_load_ps(input[6 + axis]);
+            const __m128 p3 = _mm_load_ps(input[9 + axis]);
+
+            __m128 axisMin = _mm_min_ps(p0, p3);
+            __m128 axisMax = _mm_max_ps(p0, p3);
+
+            // Same root finding as the scalar path, invalid roots are replaced by t = 0, which is already bounded
+            const __m128 a = _mm_add_ps(_mm_sub_ps(p3, p0), _mm_mul_ps(_mm_set1_ps(3.0f), _mm_sub_ps(p1, p2)));
+            const __m128 b = _mm_mul_ps(_mm_set1_ps(2.0f), _mm_add_ps(_mm_sub_ps(p0, _mm_mul_ps(_mm_set1_ps(2.0f), p1)), p2));
+            const __m128 c = _mm_sub_ps(p1, p0);
+
+            const __m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(_mm_set1_ps(4.0f), _mm_mul_ps(a, c)));
+            const __m128 hasRoots = _mm_cmpge_ps(discriminant, zero);
+            const __m128 root = _mm_or_ps(_mm_sqrt_ps(_mm_max_ps(discriminant, zero)), _mm_and_ps(b, signMask));
+            const __m128 q = _mm_mul_ps(_mm_set1_ps(-0.5f), _mm_add_ps(b, root));
+
+            for (const __m128 t : { _mm_div_ps(q, a), _mm_div_ps(c, q) })
+            {
+                const __m128 valid = _mm_and_ps(hasRoots, _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmple_ps(t, one)));
+                const __m128 value = SampleCurveAxisSSE4(p0, p1, p2, p3, _mm_blendv_ps(zero, t, valid));
+                axisMin = _mm_min_ps(axisMin, value);
+                axisMax = _mm_max_ps(axisMax, value);
+            }
+
+            _mm_store_ps(min[axis], _mm_sub_ps(axisMin, radius));
+            _mm_store_ps(max[axis], _mm_add_ps(axisMax, radius));
+        }
+
+        StoreBounds(min, max, aabbs + i);
+    }
+
+    BoundCurvesScalar(curves + i, curveCount - i, curveRadius, aabbs + i);
+}
+
+TARGET_AVX2 void FitStrandCurvesAVX2(const float* x, const float* y, const float* z, uint32_t pointCount, float tension, Curve* curves)
+{
+    constexpr uint32_t lanes = 8;
+    const uint32_t segmentCount = pointCount - 1;
+    const __m256 scale = _mm256_set1_ps(tension / 6.0f);
+    const float* axes[3] = { x, y, z };
+
+    // The first and last segments clamp their neighbours, everything in between has both neighbours on the strand
+    FitCurveScalar(x, y, z, pointCount, 0, tension, curves[0]);
+
+    uint32_t segment = 1;
+    for (; segment + lanes + 1 <= segmentCount; segment += lanes)
+    {
+        alignas(32) float output[12][lanes];
+
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            const __m256 p0 = _mm256_loadu_ps(axes[axis] + segment - 1);
+            const __m256 p1 = _mm256_loadu_ps(axes[axis] + segment);
+            const __m256 p2 = _mm256_loadu_ps(axes[axis] + segment + 1);
+            const __m256 p3 = _mm256_loadu_ps(axes[axis] + segment + 2);
+
+            _mm256_store_ps(output[axis], p1);
+            _mm256_store_ps(output[3 + axis], _mm256_add_ps(p1, _mm256_mul_ps(_mm256_sub_ps(p2, p0), scale)));
+            _mm256_store_ps(output[6 + axis], _mm256_sub_ps(p2, _mm256_mul_ps(_mm256_sub_ps(p3, p1), scale)));
+            _mm256_store_ps(output[9 + axis], p2);
+        }
+
+        StoreCurves(output, curves + segment);
+    }
+
+    for (; segment < segmentCount; ++segment)
+    {
+        FitCurveScalar(x, y, z, pointCount, segment, tension, curves[segment]);
+    }
+}
+
+TARGET_AVX2 inline __m256 SampleCurveAxisAVX2(__m256 p0, __m256 p1, __m256 p2, __m256 p3, __m256 t)
+{
+    const __m256 three = _mm256_set1_ps(3.0f);
+    const __m256 u = _mm256_sub_ps(_mm256_set1_ps(1.0f), t);
+    const __m256 uu = _mm256_mul_ps(u, u);
+    const __m256 tt = _mm256_mul_ps(t, t);
+
+    __m256 value = _mm256_mul_ps(_mm256_mul_ps(uu, u), p0);
+    value = _mm256_add_ps(value, _mm256_mul_ps(_mm256_mul_ps(three, _mm256_mul_ps(uu, t)), p1));
+    value = _mm256_add_ps(value, _mm256_mul_ps(_mm256_mul_ps(three, _mm256_mul_ps(u, tt)), p2));
+    return _mm256_add_ps(value, _mm256_mul_ps(_mm256_mul_ps(tt, t), p3));
+}
+
+TARGET_AVX2 void BoundCurvesAVX2(const Curve* curves, uint32_t curveCount, float curveRadius, AABB* aabbs)
+{
+    constexpr uint32_t lanes = 8;
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 radius = _mm256_set1_ps(curveRadius);
+
+    uint32_t i = 0;
+    for (; i + lanes <= curveCount; i += lanes)
+    {
+        alignas(32) float input[12][lanes];
+        alignas(32) float min[3][lanes];
+        alignas(32) float max[3][lanes];
+        LoadCurves(curves + i, input);
+
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            const __m256 p0 = _mm256_load_ps(input[axis]);
+            const __m256 p1 = _mm256_load_ps(input[3 + axis]);
+            const __m256 p2 = _mm256_load_ps(input[6 + axis]);
+            const __m256 p3 = _mm256_load_ps(input[9 + axis]);
+
+            __m256 axisMin = _mm256_min_ps(p0, p3);
+            __m256 axisMax = _mm256_max_ps(p0, p3);
+
+            // Same root finding as the scalar path, invalid roots are replaced by t = 0, which is already bounded
+            const __m256 a = _mm256_add_ps(_mm256_sub_ps(p3, p0), _mm256_mul_ps(_mm256_set1_ps(3.0f), _mm256_sub_ps(p1, p2)));
+            const __m256 b = _mm256_mul_ps(_mm256_set1_ps(2.0f), _mm256_add_ps(_mm256_sub_ps(p0, _mm256_mul_ps(_mm256_set1_ps(2.0f), p1)), p2));
+            const __m256 c = _mm256_sub_ps(p1, p0);
+
+            const __m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(_mm256_set1_ps(4.0f), _mm256_mul_ps(a, c)));
+            const __m256 hasRoots = _mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ);
+            const __m256 root = _mm256_or_ps(_mm256_sqrt_ps(_mm256_max_ps(discriminant, zero)), _mm256_and_ps(b, signMask));
+            const __m256 q = _mm256_mul_ps(_mm256_set1_ps(-0.5f), _mm256_add_ps(b, root));
+
+            for (const __m256 t : { _mm256_div_ps(q, a), _mm256_div_ps(c, q) })
+            {
+                const __m256 valid = _mm256_and_ps(hasRoots, _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GE_OQ), _mm256_cmp_ps(t, one, _CMP_LE_OQ)));
+                const __m256 value = SampleCurveAxisAVX2(p0, p1, p2, p3, _mm256_blendv_ps(zero, t, valid));
+                axisMin = _mm256_min_ps(axisMin, value);
+                axisMax = _mm256_max_ps(axisMax, value);
+            }
+
+            _mm256_store_ps(min[axis], _mm256_sub_ps(axisMin, radius));
+            _mm256_store_ps(max[axis], _mm256_add_ps(axisMax, radius));
+        }
+
+        StoreBounds(min, max, aabbs + i);
+    }
+
+    BoundCurvesScalar(curves + i, curveCount - i, curveRadius, aabbs + i);
+}
+
+#endif
+
+CurveKernels SelectCurveKernels()
+{
+#ifdef VKHRT_X86
+    if (IsAVX2Supported())
+    {
+        spdlog::info("[GEOMETRY PROCESSOR] Using AVX2 curve kernels");
+        return { FitStrandCurvesAVX2, BoundCurvesAVX2 };
+    }
+
+    if (IsSSE4Supported())
+    {
+        spdlog::info("[GEOMETRY PROCESSOR] Using SSE4.1 curve kernels");
+        return { FitStrandCurvesSSE4, BoundCurvesSSE4 };
+    }
+#endif
+
+    spdlog::info("[GEOMETRY PROCESSOR] Using scalar curve kernels");
+    return { FitStrandCurvesScalar, BoundCurvesScalar };
+}
+
+const CurveKernels& GetCurveKernels()
+{
+    static const CurveKernels kernels = SelectCurveKernels();
+    return kernels;
+}
+
+void FitStrandCurves(const StrandBuffer& strands, uint32_t strandIndex, float tension, Curve* curves)
+{
+    FitStrandCurves(strands.Strand(strandIndex), tension, curves);
+}
+
+void FitStrandCurves(const StrandPoints& strand, float tension, Curve* curves)
+{
+    if (strand.count < 2)
+    {
+        return;
+    }
+
+    GetCurveKernels().fit(strand.x, strand.y, strand.z, strand.count, tension, curves);
+}
+
+void BoundCurves(const Curve* curves, uint32_t curveCount, float curveRadius, AABB* aabbs)
+{
+    GetCurveKernels().bound(curves, curveCount, curveRadius, aabbs);
+}
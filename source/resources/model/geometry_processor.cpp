@@ -1,816 +1,2547 @@
 #include "resources/model/geometry_processor.hpp"
-
+#include "resources/model/capsule_voxel_overlap.hpp"
+#include "resources/model/curve_fitting.hpp"
+#include "resources/model/voxel_brick_map.hpp"
+#include "resources/model/voxel_occupancy_grid.hpp"
+#include "job_system.hpp"
+#include "timer.hpp"
+
+#include <bit>
+#include <concepts>
 #include <glm/ext/scalar_constants.hpp>
 #include <glm/ext/vector_ulp.hpp>
 #include <glm/gtx/optimum_pow.hpp>
+#include <numeric>
+#include <optional>
+#include <span>
 #include <spdlog/spdlog.h>
+#include <string_view>
 
-static const std::vector<uint32_t> CUBE_INDICES {
-    // Top
-    2, 6, 7,
-    2, 3, 7,
-
-    // Bottom
-    0, 4, 5,
-    0, 1, 5,
-
-    // Left
-    0, 2, 6,
-    0, 4, 6,
-
-    // Right
-    1, 3, 7,
-    1, 5, 7,
+// Number of primitives handled by a single job when emitting geometry in parallel
+static constexpr uint32_t EMIT_CHUNK_SIZE = 4096;
 
-    // Front
-    0, 2, 3,
-    0, 1, 3,
+// Number of strands handled by a single job of a fused strand kernel
+static constexpr uint32_t STRAND_CHUNK_SIZE = 256;
 
-    // Back
-    4, 6, 7,
-    4, 5, 7
-};
+// Calls the function for every chunk of [0, count) in parallel, with the index of the chunk and its range
+template <typename Function>
+void ForEachChunk(uint32_t count, uint32_t chunkSize, JobSystem& jobSystem, const Function& function)
+{
+    const uint32_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    jobSystem.ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t chunk = begin; chunk < end; ++chunk)
+            {
+                const uint32_t first = chunk * chunkSize;
+                function(chunk, first, std::min(first + chunkSize, count));
+            }
+        });
+}
 
-static const std::vector<glm::vec3> CUBE_VERTICES {
-    glm::vec3(-1.0f, -1.0f, 1.0f),
-    glm::vec3(1.0f, -1.0f, 1.0f),
-    glm::vec3(-1.0f, 1.0f, 1.0f),
-    glm::vec3(1.0f, 1.0f, 1.0f),
-    glm::vec3(-1.0f, -1.0f, -1.0f),
-    glm::vec3(1.0f, -1.0f, -1.0f),
-    glm::vec3(-1.0f, 1.0f, -1.0f),
-    glm::vec3(1.0f, 1.0f, -1.0f)
+// Output layout of primitives split into chunks, filled by the count pass of an emitter
+struct EmitChunks
+{
+    uint32_t primitiveCount {};
+    uint32_t chunkSize {};
+    std::vector<uint32_t> firstOutputs {}; // Exclusive prefix sum of the chunk output counts
+    uint32_t outputCount {};
 };
 
-std::vector<Line> GenerateLines(const Mesh& mesh, const std::vector<Mesh::Vertex>& vertexBuffer, const std::vector<uint32_t>& indexBuffer)
+// Count pass of a two-pass emitter: counts the outputs of every chunk in parallel and assigns each chunk its output slot
+template <typename CountOutputs>
+EmitChunks CountChunkOutputs(uint32_t primitiveCount, uint32_t chunkSize, JobSystem& jobSystem, const CountOutputs& countOutputs)
 {
-    if (mesh.primitiveType != Mesh::PrimitiveType::eLines)
-    {
-        spdlog::error("[MODEL LOADING] Trying to generate line segments while mesh primitive type is not lines");
-        return {};
-    }
+    EmitChunks chunks {};
+    chunks.primitiveCount = primitiveCount;
+    chunks.chunkSize = chunkSize;
+    chunks.firstOutputs.resize((primitiveCount + chunkSize - 1) / chunkSize);
 
-    std::vector<Line> lineSegments(mesh.indexCount / 2);
-    uint32_t indexOffset = 0;
+    ForEachChunk(primitiveCount, chunkSize, jobSystem, [&](uint32_t chunk, uint32_t begin, uint32_t end)
+        { chunks.firstOutputs[chunk] = countOutputs(begin, end); });
 
-    for (Line& segment : lineSegments)
+    for (uint32_t& firstOutput : chunks.firstOutputs)
     {
-        uint32_t startIndex = indexBuffer[mesh.firstIndex + indexOffset];
-        uint32_t endIndex = indexBuffer[mesh.firstIndex + indexOffset + 1];
-
-        segment.start = vertexBuffer[mesh.firstVertex + startIndex].position;
-        segment.end = vertexBuffer[mesh.firstVertex + endIndex].position;
-        indexOffset += 2;
+        const uint32_t chunkOutputCount = firstOutput;
+        firstOutput = chunks.outputCount;
+        chunks.outputCount += chunkOutputCount;
     }
 
-    return lineSegments;
+    return chunks;
+}
+
+// Fill pass of a two-pass emitter: every chunk writes its primitives straight into its preallocated output slot
+template <typename FillOutputs>
+void FillChunkOutputs(const EmitChunks& chunks, JobSystem& jobSystem, const FillOutputs& fillOutputs)
+{
+    ForEachChunk(chunks.primitiveCount, chunks.chunkSize, jobSystem, [&](uint32_t chunk, uint32_t begin, uint32_t end)
+        { fillOutputs(chunk, begin, end, chunks.firstOutputs[chunk]); });
 }
 
-std::vector<Line> MergeLines(const std::vector<Line>& lines)
+// Number of keys handled by a single job in every pass of the radix sort
+static constexpr uint32_t RADIX_SORT_CHUNK_SIZE = 16384;
+
+// Stable least significant digit radix sort of keys up to keyBits wide, which reorders the values along with them.
+// Every pass counts the digits of all chunks in parallel, scans the counts digit by digit and chunk by chunk, and then scatters all chunks in parallel.
+void RadixSort(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, JobSystem& jobSystem, uint32_t keyBits = 32)
 {
-    std::vector<Line> newLines {};
+    constexpr uint32_t radixBits = 8;
+    constexpr uint32_t radixSize = 1 << radixBits;
 
-    uint32_t wantedLinesCount = lines.size() / 2;
-    newLines.reserve(wantedLinesCount);
+    const uint32_t count = keys.size();
+    const uint32_t chunkCount = (count + RADIX_SORT_CHUNK_SIZE - 1) / RADIX_SORT_CHUNK_SIZE;
 
-    for (uint32_t i = 0; i < wantedLinesCount; ++i)
+    std::vector<uint32_t> sortedKeys(count);
+    std::vector<uint32_t> sortedValues(count);
+    std::vector<uint32_t> digitOffsets(chunkCount * radixSize);
+
+    for (uint32_t shift = 0; shift < keyBits; shift += radixBits)
     {
-        uint32_t oldLineIndex = i * 2;
-        const Line& oldLine1 = lines[oldLineIndex];
+        std::fill(digitOffsets.begin(), digitOffsets.end(), 0);
+
+        jobSystem.ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end)
+            {
+                for (uint32_t chunk = begin; chunk < end; ++chunk)
+                {
+                    uint32_t* chunkCounts = digitOffsets.data() + chunk * radixSize;
+                    for (uint32_t i = chunk * RADIX_SORT_CHUNK_SIZE; i < std::min((chunk + 1) * RADIX_SORT_CHUNK_SIZE, count); ++i)
+                    {
+                        chunkCounts[(keys[i] >> shift) & (radixSize - 1)]++;
+                    }
+                }
+            });
 
-        // If only 1 line remaining, put it back into list
-        if (oldLineIndex + 1 == lines.size())
+        // Scanning every digit over all chunks before the next digit keeps equal digits in their original order
+        uint32_t digitOffset = 0;
+        for (uint32_t digit = 0; digit < radixSize; ++digit)
         {
-            newLines.push_back(oldLine1);
-            break;
+            for (uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+            {
+                const uint32_t digitCount = digitOffsets[chunk * radixSize + digit];
+                digitOffsets[chunk * radixSize + digit] = digitOffset;
+                digitOffset += digitCount;
+            }
         }
 
-        const Line& oldLine2 = lines[oldLineIndex + 1];
+        jobSystem.ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end)
+            {
+                for (uint32_t chunk = begin; chunk < end; ++chunk)
+                {
+                    uint32_t* chunkOffsets = digitOffsets.data() + chunk * radixSize;
+                    for (uint32_t i = chunk * RADIX_SORT_CHUNK_SIZE; i < std::min((chunk + 1) * RADIX_SORT_CHUNK_SIZE, count); ++i)
+                    {
+                        const uint32_t destination = chunkOffsets[(keys[i] >> shift) & (radixSize - 1)]++;
+                        sortedKeys[destination] = keys[i];
+                        sortedValues[destination] = values[i];
+                    }
+                }
+            });
 
-        // If lines are not connected, we can't merge them so put them back and continue
-        if (oldLine1.end != oldLine2.start)
-        {
-            newLines.push_back(oldLine1);
-            newLines.push_back(oldLine2);
-            continue;
-        }
+        keys.swap(sortedKeys);
+        values.swap(sortedValues);
+    }
+}
+
+// Stages read strands through this interface, so they work on owned strand buffers as well as on views into them
+template <typename T>
+concept StrandSource = requires(const T& strands, uint32_t index) {
+    { strands.StrandCount() } -> std::convertible_to<uint32_t>;
+    { strands.PointCount() } -> std::convertible_to<uint32_t>;
+    { strands.SegmentCount() } -> std::convertible_to<uint32_t>;
+    { strands.FirstPoint(index) } -> std::convertible_to<uint32_t>;
+    { strands.FirstSegment(index) } -> std::convertible_to<uint32_t>;
+    { strands.Strand(index) } -> std::same_as<StrandPoints>;
+    { strands.Point(index) } -> std::same_as<glm::vec3>;
+};
 
-        Line& newLine = newLines.emplace_back();
-        newLine.start = oldLine1.start;
-        newLine.end = oldLine2.end;
+// The first strands of a strand buffer, pruned levels of detail keep these of the coarsest segment level without copying them
+class StrandPrefix
+{
+public:
+    StrandPrefix() = default;
+    StrandPrefix(const StrandBuffer& strands, uint32_t strandCount)
+        : _strands(&strands)
+        , _strandCount(std::min(strandCount, strands.StrandCount()))
+    {
+    }
+    explicit StrandPrefix(const StrandBuffer& strands)
+        : StrandPrefix(strands, strands.StrandCount())
+    {
     }
 
-    return newLines;
+    [[nodiscard]] uint32_t StrandCount() const { return _strandCount; }
+    [[nodiscard]] uint32_t PointCount() const { return _strandCount < _strands->StrandCount() ? _strands->FirstPoint(_strandCount) : _strands->PointCount(); }
+    [[nodiscard]] uint32_t SegmentCount() const { return _strandCount < _strands->StrandCount() ? _strands->FirstSegment(_strandCount) : _strands->SegmentCount(); }
+    [[nodiscard]] uint32_t FirstPoint(uint32_t strandIndex) const { return _strands->FirstPoint(strandIndex); }
+    [[nodiscard]] uint32_t FirstSegment(uint32_t strandIndex) const { return _strands->FirstSegment(strandIndex); }
+    [[nodiscard]] StrandPoints Strand(uint32_t strandIndex) const { return _strands->Strand(strandIndex); }
+    [[nodiscard]] glm::vec3 Point(uint32_t index) const { return _strands->Point(index); }
+
+private:
+    const StrandBuffer* _strands = nullptr;
+    uint32_t _strandCount {};
+};
+
+static_assert(StrandSource<StrandBuffer> && StrandSource<StrandPrefix>);
+
+// Distance from a point to the line segment between start and end
+float DistanceToSegment(const glm::vec3& point, const glm::vec3& start, const glm::vec3& end)
+{
+    const glm::vec3 segment = end - start;
+    const float lengthSquared = glm::dot(segment, segment);
+    const float t = lengthSquared > 0.0f ? glm::clamp(glm::dot(point - start, segment) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+    return glm::distance(point, start + segment * t);
 }
 
-std::vector<Line> SplitLines(const std::vector<Line>& lines)
+// Curves are flattened into at most 2^MAX_FLATTEN_DEPTH pieces, which bounds the points a single curve can produce
+static constexpr uint32_t MAX_FLATTEN_DEPTH = 10;
+
+// Appends points along the curve (excluding its start), splitting it into as few uniform pieces as keep it within maxDeviation
+// of the polyline. Returns false when that takes more than 2^MAX_FLATTEN_DEPTH pieces, in which case the curve is left above it.
+bool FlattenCurve(const Curve& curve, float maxDeviation, std::vector<glm::vec3>& points)
 {
-    std::vector<Line> newLines {};
+    // Wang's formula, n uniform pieces of a cubic are within 3/4 of its largest second difference over n^2 of the curve.
+    // Every halving of the pieces divides the deviation by 4, so the depth follows from log4 of deviation over tolerance.
+    const float secondDifference = std::max(glm::length(curve.start - 2.0f * curve.controlPoint1 + curve.controlPoint2),
+        glm::length(curve.controlPoint1 - 2.0f * curve.controlPoint2 + curve.end));
+    const float deviation = 0.75f * secondDifference;
 
-    uint32_t wantedLinesCount = lines.size() * 2;
-    newLines.reserve(wantedLinesCount);
+    const float depth = deviation > maxDeviation ? std::ceil(std::log2(deviation / maxDeviation) * 0.5f) : 0.0f;
+    const uint32_t pieceCount = 1 << static_cast<uint32_t>(std::min(depth, static_cast<float>(MAX_FLATTEN_DEPTH)));
 
-    for (const Line& oldLine : lines)
+    for (uint32_t i = 1; i < pieceCount; ++i)
     {
-        glm::vec3 middlePoint = (oldLine.start + oldLine.end) * 0.5f;
-        newLines.push_back({ oldLine.start, middlePoint });
-        newLines.push_back({ middlePoint, oldLine.end });
+        points.push_back(curve.Sample(static_cast<float>(i) / static_cast<float>(pieceCount)));
     }
+    points.push_back(curve.end);
 
-    return newLines;
+    return depth <= static_cast<float>(MAX_FLATTEN_DEPTH);
 }
 
-std::vector<Curve> GenerateCurves(const std::vector<Line>& lines, float tension = 1.0f)
+// Douglas-Peucker, marks the points needed to stay within maxDeviation of the polyline. End points are always kept.
+void SimplifyPolyline(const std::vector<glm::vec3>& points, float maxDeviation, std::vector<uint8_t>& keep, std::vector<std::pair<uint32_t, uint32_t>>& ranges)
 {
-    std::vector<Curve> curves {};
-    curves.reserve(lines.size());
+    keep.assign(points.size(), 0);
+    keep.front() = 1;
+    keep.back() = 1;
 
-    // Duplicate end-lines so Catmull–Rom works at the ends
-    std::vector<Line> linesToProcess {};
-    linesToProcess.reserve(lines.size() + 2);
-    linesToProcess.push_back(lines.front()); // duplicate first
-    linesToProcess.insert(linesToProcess.end(), lines.begin(), lines.end());
-    linesToProcess.push_back(lines.back()); // duplicate last
+    ranges.clear();
+    ranges.emplace_back(0, points.size() - 1);
 
-    for (uint32_t i = 1; i < linesToProcess.size() - 1; ++i)
+    while (!ranges.empty())
     {
-        // Detect if the next and previous curve segments are on the same hair strand.
-        // If they are, use them, if they aren't reuse the current line to generate
-        // the curve to avoid generation based on unrelated hair strands
-        uint32_t prevIndex = linesToProcess[i - 1].end == linesToProcess[i].start ? i - 1 : i;
-        uint32_t nextIndex = linesToProcess[i].end == linesToProcess[i + 1].start ? i + 1 : i;
+        const auto [first, last] = ranges.back();
+        ranges.pop_back();
 
-        glm::vec3 p0 = linesToProcess[prevIndex].start;
-        glm::vec3 p1 = linesToProcess[i].start;
-        glm::vec3 p2 = linesToProcess[i].end;
-        glm::vec3 p3 = linesToProcess[nextIndex].end;
+        float maxDistance = 0.0f;
+        uint32_t farthest = first;
+        for (uint32_t i = first + 1; i < last; ++i)
+        {
+            const float distance = DistanceToSegment(points[i], points[first], points[last]);
+            if (distance > maxDistance)
+            {
+                maxDistance = distance;
+                farthest = i;
+            }
+        }
 
-        Curve& curve = curves.emplace_back();
-        curve.start = p1;
-        curve.controlPoint1 = p1 + (p2 - p0) * (tension / 6.0f);
-        curve.controlPoint2 = p2 - (p3 - p1) * (tension / 6.0f);
-        curve.end = p2;
+        if (maxDistance > maxDeviation)
+        {
+            keep[farthest] = 1;
+            ranges.emplace_back(first, farthest);
+            ranges.emplace_back(farthest, last);
+        }
     }
-
-    return curves;
 }
 
-std::vector<Curve> MergeCurvesFast(const std::vector<Curve>& curves)
+// Resamples every strand along the Catmull-Rom spline through its points, so points are dense where the strand bends and
+// sparse where it is straight. The result stays within maxDeviation of the spline, half of which is spent on flattening the
+// spline and the other half on removing points that aren't needed. Curves that would need more than 2^MAX_FLATTEN_DEPTH
+// pieces to get there are capped and logged.
+StrandBuffer ResampleStrands(const StrandBuffer& strands, float maxDeviation, JobSystem& jobSystem)
 {
-    std::vector<Curve> newCurves {};
-
-    uint32_t wantedCurvesCount = curves.size() / 2;
-    newCurves.reserve(wantedCurvesCount);
-
-    for (uint32_t i = 0; i < wantedCurvesCount; ++i)
-    {
-        uint32_t oldCurveIndex = i * 2;
-        const Curve& oldCurve1 = curves[oldCurveIndex];
+    constexpr uint32_t strandsPerJob = 256;
+    const uint32_t chunkCount = (strands.StrandCount() + strandsPerJob - 1) / strandsPerJob;
+    std::vector<StrandBuffer> chunkStrands(chunkCount);
+    std::vector<uint32_t> chunkCappedCurves(chunkCount, 0);
 
-        // If only 1 curve remaining, put it back into list
-        if (oldCurveIndex + 1 == curves.size())
+    jobSystem.ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end)
         {
-            newCurves.push_back(oldCurve1);
-            break;
-        }
+            std::vector<Curve> curves {};
+            std::vector<glm::vec3> points {};
+            std::vector<uint8_t> keep {};
+            std::vector<std::pair<uint32_t, uint32_t>> ranges {};
+
+            for (uint32_t chunk = begin; chunk < end; ++chunk)
+            {
+                StrandBuffer& output = chunkStrands[chunk];
+                const uint32_t firstStrand = chunk * strandsPerJob;
+                const uint32_t lastStrand = std::min(firstStrand + strandsPerJob, strands.StrandCount());
 
-        const Curve& oldCurve2 = curves[oldCurveIndex + 1];
+                for (uint32_t strandIndex = firstStrand; strandIndex < lastStrand; ++strandIndex)
+                {
+                    const uint32_t firstPoint = strands.strandOffsets[strandIndex];
+                    const uint32_t pointCount = strands.strandPointCounts[strandIndex];
+
+                    output.AddStrand();
+                    if (pointCount < 2)
+                    {
+                        for (uint32_t i = firstPoint; i < firstPoint + pointCount; ++i)
+                        {
+                            output.AddPoint(strands.Point(i));
+                        }
+                        continue;
+                    }
+
+                    curves.resize(pointCount - 1);
+                    FitStrandCurves(strands, strandIndex, 1.0f, curves.data());
+
+                    points.clear();
+                    points.push_back(strands.Point(firstPoint));
+                    for (const Curve& curve : curves)
+                    {
+                        if (!FlattenCurve(curve, maxDeviation * 0.5f, points))
+                        {
+                            chunkCappedCurves[chunk]++;
+                        }
+                    }
+
+                    SimplifyPolyline(points, maxDeviation * 0.5f, keep, ranges);
+                    for (uint32_t i = 0; i < points.size(); ++i)
+                    {
+                        if (keep[i])
+                        {
+                            output.AddPoint(points[i]);
+                        }
+                    }
+                }
+            }
+        });
 
-        // If curves are not connected, we can't merge them so put them back and continue
-        if (oldCurve1.end != oldCurve2.start)
+    // Chunks are appended in order, so strands keep their indices
+    StrandBuffer newStrands {};
+    for (const StrandBuffer& chunk : chunkStrands)
+    {
+        const uint32_t firstPoint = newStrands.PointCount();
+        newStrands.pointsX.insert(newStrands.pointsX.end(), chunk.pointsX.begin(), chunk.pointsX.end());
+        newStrands.pointsY.insert(newStrands.pointsY.end(), chunk.pointsY.begin(), chunk.pointsY.end());
+        newStrands.pointsZ.insert(newStrands.pointsZ.end(), chunk.pointsZ.begin(), chunk.pointsZ.end());
+        newStrands.strandPointCounts.insert(newStrands.strandPointCounts.end(), chunk.strandPointCounts.begin(), chunk.strandPointCounts.end());
+        for (const uint32_t offset : chunk.strandOffsets)
         {
-            newCurves.push_back(oldCurve1);
-            newCurves.push_back(oldCurve2);
-            continue;
+            newStrands.strandOffsets.push_back(firstPoint + offset);
         }
+    }
 
-        Curve& newCuve = newCurves.emplace_back();
-        newCuve.start = oldCurve1.start;
-        newCuve.end = oldCurve2.end;
+    spdlog::info("[GEOMETRY PROCESSOR] Resampled hair strands from {} to {} segments", strands.SegmentCount(), newStrands.SegmentCount());
 
-        glm::vec3 middlePoint = (oldCurve1.controlPoint2 + oldCurve2.controlPoint1) * 0.5f;
-        newCuve.controlPoint1 = (oldCurve1.controlPoint1 + middlePoint) * 0.5f;
-        newCuve.controlPoint2 = (middlePoint + oldCurve2.controlPoint2) * 0.5f;
+    const uint32_t cappedCurveCount = std::accumulate(chunkCappedCurves.begin(), chunkCappedCurves.end(), uint32_t { 0 });
+    if (cappedCurveCount > 0)
+    {
+        spdlog::warn("[GEOMETRY PROCESSOR] {} hair curves needed more than {} pieces and exceed the maximum strand deviation of {}", cappedCurveCount, 1 << MAX_FLATTEN_DEPTH, maxDeviation);
     }
 
-    return newCurves;
+    return newStrands;
 }
 
-// Generate a vector that is orthogonal to the input vector.
-// This can be used to invent a tangent frame for meshes that don't have real tangents/bitangents
-inline glm::vec3 PerpStark(const glm::vec3& u)
-{
-    glm::vec3 a = abs(u);
-    uint32_t uyx = (a.x - a.y) < 0 ? 1 : 0;
-    uint32_t uzx = (a.x - a.z) < 0 ? 1 : 0;
-    uint32_t uzy = (a.y - a.z) < 0 ? 1 : 0;
-    uint32_t xm = uyx & uzx;
-    uint32_t ym = (1 ^ xm) & uzy;
-    uint32_t zm = 1 ^ (xm | ym); // 1 ^ (xm & ym)
-    glm::vec3 v = glm::normalize(cross(u, glm::vec3(xm, ym, zm)));
-    return v;
-}
+// Fraction of segments kept at every level of detail, for the techniques that support it
+static constexpr std::array<float, 4> LOD_SEGMENT_RATIOS { 1.0f, 0.5f, 0.25f, 0.125f };
+static constexpr uint32_t LOD_SEGMENT_LEVEL_COUNT = LOD_SEGMENT_RATIOS.size();
 
-// Build a local frame from a unit normal vector
-inline void BuildFrame(const glm::vec3& n, glm::vec3& t, glm::vec3& b)
-{
-    t = PerpStark(n);
-    b = glm::cross(n, t);
-}
+// Fraction of strands kept by the levels of detail that follow the segment levels, these prune strands from the coarsest segment level
+static constexpr std::array<float, 2> LOD_STRAND_RATIOS { 0.5f, 0.25f };
+static constexpr uint32_t LOD_LEVEL_COUNT = LOD_SEGMENT_LEVEL_COUNT + LOD_STRAND_RATIOS.size();
 
-Mesh GenerateDisjointOrthogonalTriangleStrips(const std::vector<Line>& lines, std::vector<Mesh::Vertex>& vertexBuffer, std::vector<uint32_t>& indexBuffer, float radius = 0.02f)
+// Importance of every point is the smallest deviation at which Douglas-Peucker still keeps it. A point is never more important
+// than the point that split its range, so the points kept for a smaller deviation always include the ones kept for a larger one.
+std::vector<float> ComputePointImportance(const StrandBuffer& strands, JobSystem& jobSystem)
 {
-    Mesh mesh {};
-    mesh.firstIndex = indexBuffer.size();
-    mesh.firstVertex = vertexBuffer.size();
+    std::vector<float> importance(strands.PointCount(), std::numeric_limits<float>::infinity());
 
-    const uint32_t numVerticesPerSegment = 4 * 3; // 4 triangles (3 vertices each)
-    const uint32_t numIndices = lines.size() * numVerticesPerSegment;
-    const uint32_t numVertices = numIndices;
+    constexpr uint32_t strandsPerJob = 256;
+    jobSystem.ParallelFor(strands.StrandCount(), strandsPerJob, [&](uint32_t begin, uint32_t end)
+        {
+            struct Range
+            {
+                uint32_t first {};
+                uint32_t last {};
+                float importance {};
+            };
+            std::vector<Range> ranges {};
 
-    mesh.indexCount = numIndices;
+            for (uint32_t strandIndex = begin; strandIndex < end; ++strandIndex)
+            {
+                const uint32_t pointCount = strands.strandPointCounts[strandIndex];
+                if (pointCount < 3)
+                {
+                    continue;
+                }
 
-    indexBuffer.resize(indexBuffer.size() + numIndices);
-    vertexBuffer.resize(vertexBuffer.size() + numVertices);
-    uint32_t indexOffset = 0;
+                const uint32_t firstPoint = strands.strandOffsets[strandIndex];
+                ranges.push_back({ firstPoint, firstPoint + pointCount - 1, std::numeric_limits<float>::infinity() });
 
-    for (const Line& line : lines)
-    {
-        // Build the initial frame
-        glm::vec3 fwd, s, t;
-        fwd = glm::normalize(line.end - line.start);
-        BuildFrame(fwd, s, t);
+                while (!ranges.empty())
+                {
+                    const Range range = ranges.back();
+                    ranges.pop_back();
+
+                    float maxDistance = -1.0f;
+                    uint32_t farthest = range.first;
+                    for (uint32_t i = range.first + 1; i < range.last; ++i)
+                    {
+                        const float distance = DistanceToSegment(strands.Point(i), strands.Point(range.first), strands.Point(range.last));
+                        if (distance > maxDistance)
+                        {
+                            maxDistance = distance;
+                            farthest = i;
+                        }
+                    }
+
+                    const float pointImportance = std::min(maxDistance, range.importance);
+                    importance[farthest] = pointImportance;
+
+                    if (farthest - range.first > 1)
+                    {
+                        ranges.push_back({ range.first, farthest, pointImportance });
+                    }
+                    if (range.last - farthest > 1)
+                    {
+                        ranges.push_back({ farthest, range.last, pointImportance });
+                    }
+                }
+            }
+        });
 
-        glm::vec3 v[2] = { s, t };
+    return importance;
+}
 
-        for (uint32_t face = 0; face < 2; ++face)
-        {
-            // Generate indices
-            const uint32_t baseIndex = mesh.firstIndex + indexOffset + face * 6;
+StrandBuffer DecimateStrands(const StrandBuffer& strands, const std::vector<float>& importance, float minImportance)
+{
+    StrandBuffer newStrands {};
 
-            indexBuffer[baseIndex] = baseIndex;
-            indexBuffer[baseIndex + 1] = baseIndex + 1;
-            indexBuffer[baseIndex + 2] = baseIndex + 2;
-            indexBuffer[baseIndex + 3] = baseIndex + 3;
-            indexBuffer[baseIndex + 4] = baseIndex + 4;
-            indexBuffer[baseIndex + 5] = baseIndex + 5;
+    for (uint32_t strandIndex = 0; strandIndex < strands.StrandCount(); ++strandIndex)
+    {
+        const uint32_t firstPoint = strands.strandOffsets[strandIndex];
+        const uint32_t pointCount = strands.strandPointCounts[strandIndex];
 
-            // Generate vertices
-            vertexBuffer[baseIndex] = { line.start + v[face] * radius };
-            vertexBuffer[baseIndex + 1] = { line.end - v[face] * radius };
-            vertexBuffer[baseIndex + 2] = { line.end + v[face] * radius };
-            vertexBuffer[baseIndex + 3] = { line.start + v[face] * radius };
-            vertexBuffer[baseIndex + 4] = { line.start - v[face] * radius };
-            vertexBuffer[baseIndex + 5] = { line.end - v[face] * radius };
+        newStrands.AddStrand();
+        for (uint32_t i = firstPoint; i < firstPoint + pointCount; ++i)
+        {
+            if (importance[i] >= minImportance)
+            {
+                newStrands.AddPoint(strands.Point(i));
+            }
         }
-
-        indexOffset += numVerticesPerSegment;
     }
 
-    return mesh;
+    return newStrands;
 }
 
-LSSMesh GenerateLinearSweptSpheres(const std::vector<Line>& lines, std::vector<glm::vec3>& positionBuffer, std::vector<float>& radiusBuffer, float radius = 0.02f)
+// Decimates the strands to the segment ratio of every level of detail, by keeping their most important points.
+// Strand ends are always kept, so a strand never gets less than a single segment.
+std::vector<StrandBuffer> GenerateStrandLODs(StrandBuffer strands, JobSystem& jobSystem)
 {
-    LSSMesh mesh {};
-    mesh.firstVertex = positionBuffer.size(); // Should be the same for radius buffer, so we only track positions buffer
-
-    uint32_t numVertices = lines.size() * 2;
-    mesh.vertexCount = numVertices;
+    const std::vector<float> importance = ComputePointImportance(strands, jobSystem);
 
-    positionBuffer.resize(positionBuffer.size() + numVertices);
-    radiusBuffer.resize(radiusBuffer.size() + numVertices);
+    std::vector<float> sortedImportance {};
+    sortedImportance.reserve(strands.PointCount());
+    std::copy_if(importance.begin(), importance.end(), std::back_inserter(sortedImportance), [](float value)
+        { return std::isfinite(value); });
+    std::sort(sortedImportance.begin(), sortedImportance.end(), std::greater<float>());
 
-    uint32_t indexOffset = 0;
-    float lssRadius = glm::max(radius, 0.001f);
+    std::vector<StrandBuffer> lods(LOD_SEGMENT_LEVEL_COUNT);
 
-    for (const Line& line : lines)
+    for (uint32_t level = 1; level < LOD_SEGMENT_LEVEL_COUNT; ++level)
     {
-        positionBuffer[indexOffset] = line.start;
-        positionBuffer[indexOffset + 1] = line.end;
-        radiusBuffer[indexOffset] = lssRadius;
-        radiusBuffer[indexOffset + 1] = lssRadius;
-
-        indexOffset += 2;
+        // Every strand keeps one segment between its ends, the remaining budget goes to the most important points
+        const uint32_t targetSegmentCount = std::ceil(strands.SegmentCount() * LOD_SEGMENT_RATIOS[level]);
+        const uint32_t keptPointCount = std::min<uint32_t>(targetSegmentCount - std::min(targetSegmentCount, strands.StrandCount()), sortedImportance.size());
+        const float minImportance = keptPointCount > 0 ? sortedImportance[keptPointCount - 1] : std::numeric_limits<float>::infinity();
+
+        lods[level] = DecimateStrands(strands, importance, minImportance);
+        spdlog::info("[GEOMETRY PROCESSOR] Hair LOD {} keeps {} of {} segments, with a max deviation of {}", level, lods[level].SegmentCount(), strands.SegmentCount(),
+            keptPointCount < sortedImportance.size() ? sortedImportance[keptPointCount] : 0.0f);
     }
 
-    return mesh;
+    lods[0] = std::move(strands);
+    return lods;
 }
 
-Mesh GenerateMeshGeometryCubes(const std::vector<Line>& lines, std::vector<Mesh::Vertex>& vertexBuffer, std::vector<uint32_t>& indexBuffer, float cubeSize = 0.02f)
+// Bijective integer hash (lowbias32), so no two strands end up with the same value
+uint32_t HashStrandIndex(uint32_t x)
 {
-    Mesh mesh {};
-    mesh.firstIndex = indexBuffer.size();
-    mesh.firstVertex = vertexBuffer.size();
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
 
-    for (const Line& line : lines)
-    {
-        const uint32_t firstCubeVertex = vertexBuffer.size();
+// Target number of primitives in a geometry cluster, geometries with fewer primitives aren't split
+static constexpr uint32_t CLUSTER_PRIMITIVE_COUNT = 32768;
+// Upper bound for the grid cells a geometry is split into, every cluster needs its own geometry node
+static constexpr uint32_t MAX_GEOMETRY_CLUSTERS = 16;
 
-        for (const uint32_t index : CUBE_INDICES)
-        {
-            indexBuffer.push_back(index + firstCubeVertex);
-        }
+// Splits primitives into spatially compact clusters by sorting their centroids into the cells of a uniform grid.
+// Writes the order in which the primitives should be stored and returns the clusters as ranges within that order.
+// A centroid can stand for a group of primitives, in which case the total primitive count decides how many clusters are made.
+std::vector<GeometryCluster> ClusterPrimitives(const std::vector<glm::vec3>& centroids, std::vector<uint32_t>& order, JobSystem& jobSystem, std::optional<uint32_t> totalPrimitiveCount = std::nullopt)
+{
+    const uint32_t primitiveCount = centroids.size();
+    const uint32_t targetClusterCount = std::clamp(totalPrimitiveCount.value_or(primitiveCount) / CLUSTER_PRIMITIVE_COUNT, 1u, MAX_GEOMETRY_CLUSTERS);
 
-        for (const glm::vec3& pos : CUBE_VERTICES)
-        {
-            vertexBuffer.push_back({ pos * cubeSize + line.start });
-        }
+    order.resize(primitiveCount);
+    std::iota(order.begin(), order.end(), 0);
 
-        mesh.indexCount += CUBE_INDICES.size();
+    if (targetClusterCount == 1)
+    {
+        return { GeometryCluster { 0, primitiveCount } };
     }
 
-    return mesh;
-}
+    AABB bounds { glm::vec3 { std::numeric_limits<float>::max() }, glm::vec3 { std::numeric_limits<float>::lowest() } };
+    for (const glm::vec3& centroid : centroids)
+    {
+        bounds.min = glm::min(bounds.min, centroid);
+        bounds.max = glm::max(bounds.max, centroid);
+    }
 
-Mesh GenerateMeshGeometryCubes(const std::vector<Curve>& curves, std::vector<Mesh::Vertex>& vertexBuffer, std::vector<uint32_t>& indexBuffer, float cubeSize = 0.02f, uint32_t numSamplesPerCurve = 2)
-{
-    Mesh mesh {};
-    mesh.firstIndex = indexBuffer.size();
-    mesh.firstVertex = vertexBuffer.size();
+    // Cells are roughly cubes, flat or thin geometry gets fewer cells along its short axes
+    const glm::vec3 extent = glm::max(bounds.max - bounds.min, glm::vec3 { std::numeric_limits<float>::epsilon() });
+    const float cellSize = std::cbrt(extent.x * extent.y * extent.z / targetClusterCount);
+    const glm::uvec3 resolution = glm::clamp(glm::uvec3 { glm::round(extent / cellSize) }, glm::uvec3 { 1 }, glm::uvec3 { targetClusterCount });
 
-    for (const Curve& curve : curves)
-    {
-        for (uint32_t sample = 0; sample < numSamplesPerCurve; ++sample)
+    std::vector<uint32_t> cells(primitiveCount);
+    jobSystem.ParallelFor(primitiveCount, EMIT_CHUNK_SIZE, [&](uint32_t begin, uint32_t end)
         {
-            const float t = static_cast<float>(sample) / static_cast<float>(numSamplesPerCurve - 1);
-            const glm::vec3 point = curve.Sample(t);
-            const uint32_t firstCubeVertex = vertexBuffer.size();
-
-            for (const uint32_t index : CUBE_INDICES)
+            for (uint32_t i = begin; i < end; ++i)
             {
-                indexBuffer.push_back(index + firstCubeVertex);
+                const glm::uvec3 cell = glm::min(glm::uvec3 { (centroids[i] - bounds.min) / extent * glm::vec3 { resolution } }, resolution - 1u);
+                cells[i] = cell.x + cell.y * resolution.x + cell.z * resolution.x * resolution.y;
             }
+        });
 
-            for (const glm::vec3& pos : CUBE_VERTICES)
-            {
-                vertexBuffer.push_back({ pos * cubeSize + point });
-            }
+    // Stable, so primitives keep their spatially coherent order within a cell
+    const uint32_t cellCount = resolution.x * resolution.y * resolution.z;
+    RadixSort(cells, order, jobSystem, std::bit_width(cellCount));
 
-            mesh.indexCount += CUBE_INDICES.size();
+    std::vector<GeometryCluster> clusters {};
+    for (uint32_t i = 0; i < primitiveCount; ++i)
+    {
+        if (i == 0 || cells[i] != cells[i - 1])
+        {
+            clusters.push_back({ i, 0 });
         }
+        clusters.back().primitiveCount++;
     }
 
-    return mesh;
+    return clusters;
 }
 
-Mesh GenerateMeshGeometryTubes(const std::vector<Curve>& curves, std::vector<Mesh::Vertex>& vertexBuffer, std::vector<uint32_t>& indexBuffer, float radius = 0.2f, uint32_t numCurveSamples = 2, uint32_t numRadialSamples = 4)
+// Number of strands kept by a pruned level of detail, which keeps the given fraction of the strands
+uint32_t PrunedStrandCount(uint32_t strandCount, float strandRatio)
 {
-    Mesh mesh {};
-    mesh.firstIndex = indexBuffer.size();
-    mesh.firstVertex = vertexBuffer.size();
+    return std::min<uint32_t>(std::ceil(strandCount * strandRatio), strandCount);
+}
+
+// Spreads the lower 10 bits of a value, leaving two zero bits between each of them
+uint32_t ExpandMortonBits(uint32_t value)
+{
+    value = (value * 0x00010001u) & 0xFF0000FFu;
+    value = (value * 0x00000101u) & 0x0F00F00Fu;
+    value = (value * 0x00000011u) & 0xC30C30C3u;
+    value = (value * 0x00000005u) & 0x49249249u;
+    return value;
+}
+
+// 30-bit Morton code of a position within the unit cube
+uint32_t MortonCode(const glm::vec3& normalizedPosition)
+{
+    const glm::uvec3 cell { glm::clamp(normalizedPosition * 1024.0f, 0.0f, 1023.0f) };
+    return (ExpandMortonBits(cell.x) << 2) | (ExpandMortonBits(cell.y) << 1) | ExpandMortonBits(cell.z);
+}
 
-    // For stable frames, pick an up vector as a starting hint
-    glm::vec3 globalUp(0.0f, 1.0f, 0.0f);
+// Copies the strands into a new buffer in the given order, all strands are copied in parallel into their precomputed slots
+template <StrandSource Source>
+StrandBuffer GatherStrands(const Source& strands, const std::vector<uint32_t>& order, JobSystem& jobSystem)
+{
+    StrandBuffer newStrands {};
+    newStrands.strandOffsets.resize(order.size());
+    newStrands.strandPointCounts.resize(order.size());
 
-    for (const Curve& curve : curves)
+    uint32_t pointCount = 0;
+    for (uint32_t i = 0; i < order.size(); ++i)
     {
-        for (uint32_t sample = 0; sample < numCurveSamples; ++sample)
-        {
-            const float t = static_cast<float>(sample) / static_cast<float>(numCurveSamples - 1);
-            const glm::vec3 point = curve.Sample(t);
-            glm::vec3 tangent = glm::normalize(curve.SampleDerivitive(t));
+        newStrands.strandOffsets[i] = pointCount;
+        newStrands.strandPointCounts[i] = strands.Strand(order[i]).count;
+        pointCount += newStrands.strandPointCounts[i];
+    }
 
-            // Build an orthonormal frame
-            glm::vec3 n = glm::normalize(globalUp - tangent * glm::dot(globalUp, tangent));
-            if (glm::length(n) < 1e-4f)
-            {
-                n = glm::normalize(glm::cross(tangent, glm::vec3(1, 0, 0)));
-            }
-            glm::vec3 b = glm::normalize(glm::cross(tangent, n));
+    newStrands.pointsX.resize(pointCount);
+    newStrands.pointsY.resize(pointCount);
+    newStrands.pointsZ.resize(pointCount);
 
-            // Generate circle of vertices
-            for (uint32_t j = 0; j < numRadialSamples; j++)
+    constexpr uint32_t strandsPerJob = 256;
+    jobSystem.ParallelFor(order.size(), strandsPerJob, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
             {
-                float theta = (2.0f * glm::pi<float>() * j) / static_cast<float>(numRadialSamples);
-                glm::vec3 offset = radius * (glm::cos(theta) * n + glm::sin(theta) * b);
-                glm::vec3 vertex = point + offset;
+                const StrandPoints strand = strands.Strand(order[i]);
+                const uint32_t newFirstPoint = newStrands.strandOffsets[i];
 
-                vertexBuffer.push_back({ vertex });
+                std::copy_n(strand.x, strand.count, newStrands.pointsX.begin() + newFirstPoint);
+                std::copy_n(strand.y, strand.count, newStrands.pointsY.begin() + newFirstPoint);
+                std::copy_n(strand.z, strand.count, newStrands.pointsZ.begin() + newFirstPoint);
             }
+        });
+
+    return newStrands;
+}
 
-            // Generate triangle indices
-            uint32_t ringSize = numRadialSamples;
-            const uint32_t firstVertex = vertexBuffer.size();
+// Average of the points of every strand
+template <StrandSource Source>
+std::vector<glm::vec3> StrandCentroids(const Source& strands, JobSystem& jobSystem)
+{
+    std::vector<glm::vec3> centroids(strands.StrandCount());
 
-            for (uint32_t i = 0; i < numCurveSamples; i++)
+    constexpr uint32_t strandsPerJob = 256;
+    jobSystem.ParallelFor(strands.StrandCount(), strandsPerJob, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t strandIndex = begin; strandIndex < end; ++strandIndex)
             {
-                uint32_t ringStart = i * ringSize;
-                uint32_t nextRingStart = (i + 1) * ringSize;
+                const StrandPoints strand = strands.Strand(strandIndex);
+                const uint32_t pointCount = strand.count;
 
-                for (uint32_t j = 0; j < numRadialSamples; j++)
+                glm::vec3 sum { 0.0f };
+                for (uint32_t i = 0; i < pointCount; ++i)
                 {
-                    uint32_t nextJ = (j + 1) % numRadialSamples;
-
-                    indexBuffer.push_back(firstVertex + ringStart + j);
-                    indexBuffer.push_back(firstVertex + nextRingStart + j);
-                    indexBuffer.push_back(firstVertex + nextRingStart + nextJ);
-
-                    indexBuffer.push_back(firstVertex + ringStart + j);
-                    indexBuffer.push_back(firstVertex + nextRingStart + nextJ);
-                    indexBuffer.push_back(firstVertex + ringStart + nextJ);
-
-                    mesh.indexCount += 6;
+                    sum += strand.Point(i);
                 }
+                centroids[strandIndex] = sum / static_cast<float>(std::max(pointCount, 1u));
             }
-        }
-    }
+        });
 
-    return mesh;
+    return centroids;
 }
 
-std::vector<AABB> GenerateAABBs(const std::vector<Curve>& curves, float curveRadius)
+// Orders the strands for the levels of detail and the BVH builder.
+// Strands are first split into tiers by a hash of their index, so the strands kept by every pruned level of detail are a deterministic
+// random subset at the start of the buffer. Within a tier strands are sorted by the Morton code of their centroid, which gives the BVH
+// builder and the hit shaders spatially coherent primitives. Whole strands are moved, so chained representations like LSS keep their segments together.
+StrandBuffer OrderStrands(const StrandBuffer& strands, JobSystem& jobSystem)
 {
-    std::vector<AABB> aabbs(curves.size());
-
-    for (uint32_t i = 0; i < curves.size(); ++i)
-    {
-        const Curve& curve = curves[i];
-        AABB& aabb = aabbs[i];
-
-        aabb.min = glm::min(glm::min(curve.start, curve.end), glm::min(curve.controlPoint1, curve.controlPoint2)) - curveRadius;
-        aabb.max = glm::max(glm::max(curve.start, curve.end), glm::max(curve.controlPoint1, curve.controlPoint2)) + curveRadius;
-    }
+    const uint32_t strandCount = strands.StrandCount();
 
-    return aabbs;
-}
+    std::vector<uint32_t> order(strandCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [](uint32_t a, uint32_t b)
+        { return HashStrandIndex(a) < HashStrandIndex(b); });
 
-glm::vec3 GetVoxelWorldPosition(uint32_t voxelIndex1D, const glm::vec3& voxelGridOrigin, const glm::ivec3& voxelGridResolution, float voxelSize)
-{
-    // Unflatten index
-    glm::vec3 voxelIndex3D {};
-    voxelIndex3D.z = voxelIndex1D / (voxelGridResolution.x * voxelGridResolution.y);
-    uint32_t remainder = voxelIndex1D % (voxelGridResolution.x * voxelGridResolution.y);
-    voxelIndex3D.y = remainder / voxelGridResolution.x;
-    voxelIndex3D.x = remainder % voxelGridResolution.x;
+    const std::vector<glm::vec3> centroids = StrandCentroids(strands, jobSystem);
 
-    // Convert to world space
-    return voxelGridOrigin + voxelIndex3D * voxelSize;
-}
+    AABB bounds { glm::vec3 { std::numeric_limits<float>::max() }, glm::vec3 { std::numeric_limits<float>::lowest() } };
+    for (const glm::vec3& centroid : centroids)
+    {
+        bounds.min = glm::min(bounds.min, centroid);
+        bounds.max = glm::max(bounds.max, centroid);
+    }
+    const glm::vec3 extent = glm::max(bounds.max - bounds.min, glm::vec3 { std::numeric_limits<float>::epsilon() });
 
-std::vector<AABB> GenerateAABBs(const VoxelMesh& voxelMesh, const std::vector<bool>& voxels, float voxelSize)
-{
-    std::vector<AABB> aabbs(voxels.size());
+    std::vector<uint32_t> tierEnds { strandCount };
+    for (const float strandRatio : LOD_STRAND_RATIOS)
+    {
+        tierEnds.push_back(PrunedStrandCount(strandCount, strandRatio));
+    }
+    std::sort(tierEnds.begin(), tierEnds.end());
 
-    for (uint32_t i = 0; i < voxels.size(); ++i)
+    uint32_t tierBegin = 0;
+    std::vector<uint32_t> keys {};
+    std::vector<uint32_t> values {};
+    for (const uint32_t tierEnd : tierEnds)
     {
-        if (!voxels[i])
+        keys.resize(tierEnd - tierBegin);
+        values.assign(order.begin() + tierBegin, order.begin() + tierEnd);
+        for (uint32_t i = 0; i < values.size(); ++i)
         {
-            continue;
+            keys[i] = MortonCode((centroids[values[i]] - bounds.min) / extent);
         }
 
-        glm::vec3 voxelWorldPosition = GetVoxelWorldPosition(i, voxelMesh.boundingBox.min, voxelMesh.voxelGridResolution, voxelSize);
-
-        AABB& aabb = aabbs[i];
-        aabb.min = voxelWorldPosition;
-        aabb.max = voxelWorldPosition + voxelSize;
+        RadixSort(keys, values, jobSystem);
+        std::copy(values.begin(), values.end(), order.begin() + tierBegin);
+        tierBegin = tierEnd;
     }
 
-    return aabbs;
+    return GatherStrands(strands, order, jobSystem);
 }
 
-template <typename T, typename B>
-T NextDivisible(const T& dividend, const B divisor)
+struct StrandPruning
 {
-    return glm::ceil(dividend / divisor) * divisor;
-}
+    uint32_t strandCount {};
+    uint32_t segmentCount {}; // Segments of the kept strands, which are the first segments of the strand buffer
+    float radiusScale {};
+};
 
-glm::vec3 GetVoxelWorldPosition(const glm::vec3& worldPosition, float voxelSize)
+// Precomputes how many of the ordered strands every pruned level of detail keeps.
+// The radius of the kept strands grows by the inverse of the kept fraction, so the hair keeps covering about the same area.
+std::array<StrandPruning, LOD_STRAND_RATIOS.size()> ComputeStrandPruning(const StrandBuffer& strands)
 {
-    return glm::floor(worldPosition / voxelSize);
-}
+    std::array<StrandPruning, LOD_STRAND_RATIOS.size()> prunings {};
 
-glm::ivec3 GetVoxelIndex3D(const glm::vec3& worldPosition, const glm::vec3& voxelGridOrigin, float voxelSize)
-{
-    return glm::floor((worldPosition - voxelGridOrigin) / voxelSize);
+    for (uint32_t i = 0; i < prunings.size(); ++i)
+    {
+        StrandPruning& pruning = prunings[i];
+        pruning.strandCount = PrunedStrandCount(strands.StrandCount(), LOD_STRAND_RATIOS[i]);
+        pruning.segmentCount = pruning.strandCount < strands.StrandCount() ? strands.FirstSegment(pruning.strandCount) : strands.SegmentCount();
+        pruning.radiusScale = pruning.strandCount > 0 ? static_cast<float>(strands.StrandCount()) / pruning.strandCount : 1.0f;
+    }
+
+    return prunings;
 }
 
-uint32_t GetVoxelIndex1D(const glm::ivec3& voxelIndex3D, const glm::ivec3& voxelGridResolution)
+// Generate a vector that is orthogonal to the input vector.
+// This can be used to invent a tangent frame for meshes that don't have real tangents/bitangents
+inline glm::vec3 PerpStark(const glm::vec3& u)
 {
-    return voxelIndex3D.x + voxelIndex3D.y * voxelGridResolution.x + voxelIndex3D.z * (voxelGridResolution.x * voxelGridResolution.y);
+    glm::vec3 a = abs(u);
+    uint32_t uyx = (a.x - a.y) < 0 ? 1 : 0;
+    uint32_t uzx = (a.x - a.z) < 0 ? 1 : 0;
+    uint32_t uzy = (a.y - a.z) < 0 ? 1 : 0;
+    uint32_t xm = uyx & uzx;
+    uint32_t ym = (1 ^ xm) & uzy;
+    uint32_t zm = 1 ^ (xm | ym); // 1 ^ (xm & ym)
+    glm::vec3 v = glm::normalize(cross(u, glm::vec3(xm, ym, zm)));
+    return v;
 }
 
-std::array<uint8_t, 3> GetMajorAxes(const glm::vec3& v)
+// Build a local frame from a unit normal vector
+inline void BuildFrame(const glm::vec3& n, glm::vec3& t, glm::vec3& b)
 {
-    glm::vec3 av = glm::abs(v);
-    std::array<uint8_t, 3> axes = { 0, 1, 2 };
-    std::sort(axes.begin(), axes.end(), [&](uint8_t a, uint8_t b)
-        { return av[a] > av[b]; });
-    return axes;
+    t = PerpStark(n);
+    b = glm::cross(n, t);
 }
 
-void FillVoxel(const glm::ivec3& index3D, VoxelMesh& mesh, std::vector<bool>& voxels)
+// Octahedral mapping of a unit vector, stored as 2 x 8 bit snorm with x in the low byte
+uint16_t EncodeOctahedral(const glm::vec3& direction)
 {
-    uint32_t index1D = GetVoxelIndex1D(index3D, mesh.voxelGridResolution);
-
-    if (index1D >= voxels.size())
+    const glm::vec3 v = direction / (glm::abs(direction.x) + glm::abs(direction.y) + glm::abs(direction.z));
+    glm::vec2 encoded = glm::vec2(v.x, v.y);
+    if (v.z < 0.0f)
     {
-        return; // TODO: Look at this case as this should never happen
+        // Fold the lower hemisphere over the diagonals
+        encoded.x = (1.0f - glm::abs(v.y)) * (v.x >= 0.0f ? 1.0f : -1.0f);
+        encoded.y = (1.0f - glm::abs(v.x)) * (v.y >= 0.0f ? 1.0f : -1.0f);
     }
 
-    voxels[mesh.firstVoxel + index1D] = true;
-    mesh.filledVoxelCount++;
+    const auto toSnorm8 = [](float value)
+    { return static_cast<uint16_t>(static_cast<uint8_t>(static_cast<int8_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 127.0f)))); };
+    return toSnorm8(encoded.x) | (toSnorm8(encoded.y) << 8);
 }
 
-VoxelMesh GenerateVoxelMesh(const std::vector<Line>& lines, const AABB& meshBounds, float hairRadius, float voxelSize, std::vector<bool>& voxels)
+// Matches the dequantization done by the BLAS build transform and the closest hit shader
+Mesh::QuantizedVertex QuantizeVertex(const glm::vec3& position, const glm::vec3& tangent, const AABB& bounds)
 {
-    VoxelMesh voxelMesh {};
-    voxelMesh.firstVoxel = voxels.size();
-    voxelMesh.boundingBox.min = meshBounds.min;
-    voxelMesh.boundingBox.max = meshBounds.max;
+    const glm::vec3 extent = glm::max(bounds.max - bounds.min, glm::vec3(1e-20f));
+    const glm::vec3 quantized = glm::round(glm::clamp((position - bounds.min) / extent, 0.0f, 1.0f) * 65535.0f);
 
-    // Expand grid bounds until we can fit whole voxels inside
-    glm::vec3 voxelGridAreaDistance = voxelMesh.boundingBox.max - voxelMesh.boundingBox.min;
-    voxelGridAreaDistance = NextDivisible(voxelGridAreaDistance, voxelSize);
-    voxelMesh.boundingBox.max = voxelMesh.boundingBox.min + voxelGridAreaDistance;
-
-    // Set grid resolution
-    voxelMesh.voxelGridResolution = voxelGridAreaDistance / voxelSize;
-    const uint32_t numVoxels = voxelMesh.voxelGridResolution.x * voxelMesh.voxelGridResolution.y * voxelMesh.voxelGridResolution.z;
-    voxels.resize(voxels.size() + numVoxels);
-
-    spdlog::info("voxel grid size: {} with grid distance {}, {}, {}", voxels.size(), voxelGridAreaDistance.x, voxelGridAreaDistance.y, voxelGridAreaDistance.z);
-    spdlog::info("voxel grid res {}, {}, {}", voxelMesh.voxelGridResolution.x, voxelMesh.voxelGridResolution.y, voxelMesh.voxelGridResolution.z);
-    spdlog::info("voxel bounds {}, {}, {} to {}, {}, {}", voxelMesh.boundingBox.min.x, voxelMesh.boundingBox.min.y, voxelMesh.boundingBox.min.z, voxelMesh.boundingBox.max.x, voxelMesh.boundingBox.max.y, voxelMesh.boundingBox.max.z);
+    return { static_cast<uint16_t>(quantized.x), static_cast<uint16_t>(quantized.y), static_cast<uint16_t>(quantized.z), EncodeOctahedral(tangent) };
+}
 
-    // Voxelize polylines as capsules
-    // Algorithm taken from 'Real-Time Rendering of Dynamic Line Sets using Voxel Ray Tracing' paper: https://arxiv.org/pdf/2510.09081
-    for (const Line& line : lines)
+// Bounds of all strand points, grown by the radius of the geometry generated around them
+template <StrandSource Source>
+AABB StrandBounds(const Source& strands, float radius)
+{
+    AABB bounds { glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()) };
+    for (uint32_t i = 0; i < strands.PointCount(); ++i)
     {
-        glm::vec3 d = line.end - line.start;
-        std::array<uint8_t, 3> a = GetMajorAxes(d);
+        bounds.min = glm::min(bounds.min, strands.Point(i));
+        bounds.max = glm::max(bounds.max, strands.Point(i));
+    }
 
-        // Make sure the major axis is always positive by swapping points
-        glm::vec3 v0 = d[a[0]] < 0.0f ? line.end : line.start;
-        glm::vec3 v1 = d[a[0]] < 0.0f ? line.start : line.end;
+    return AABB { bounds.min - radius, bounds.max + radius };
+}
 
-        // Step vector from one major axis voxel boundary to the next
-        glm::vec3 s = d / d[a[0]];
+struct MeshBufferOffsets
+{
+    uint32_t firstVertex {};
+    uint32_t firstQuantizedVertex {};
+    uint32_t firstIndex {};
+    uint32_t firstCurve {};
+    uint32_t firstCurveStrand {};
+    uint32_t firstCurvePrimitive {};
+    uint32_t firstAabb {};
+    uint32_t firstVoxelBrickIndex {};
+    uint32_t firstVoxelBrick {};
+    uint32_t firstLssVertex {};
+    uint32_t firstLssRadius {};
+    uint32_t firstLssIndex {};
+};
 
-        // Get extended line segments to capture capsule ends
-        glm::vec3 sr = s * hairRadius;
-        glm::vec3 vr0 = v0 - sr;
-        glm::vec3 vr1 = v1 + sr;
+// Element counts of the model buffers, laid out like the offsets so generators can report the room they need before writing
+using MeshBufferSizes = MeshBufferOffsets;
 
-        // Get projected capsule radius on both minor axes
-        float dn = glm::length(d);
-        float r1 = hairRadius / glm::sqrt(1.0f - glm::pow2(d[a[1]] / dn));
-        float r2 = hairRadius / glm::sqrt(1.0f - glm::pow2(d[a[2]] / dn));
+// Every segment becomes two orthogonal quads
+static constexpr uint32_t DOTS_TRIANGLES_PER_SEGMENT = 2 * 2;
+static constexpr uint32_t DOTS_VERTICES_PER_POINT = 2 * 2; // 2 faces (2 vertices each)
+static constexpr uint32_t DOTS_INDICES_PER_SEGMENT = DOTS_TRIANGLES_PER_SEGMENT * 3;
 
-        // Setup starting point for
-        float tmin = vr0[a[0]];
-        float tmax = vr1[a[0]];
-        float t0 = tmin;
-        glm::vec3 p0 = vr0;
+template <StrandSource Source>
+MeshBufferSizes DOTSBufferSizes(const Source& strands)
+{
+    MeshBufferSizes sizes {};
+    sizes.firstQuantizedVertex = strands.PointCount() * DOTS_VERTICES_PER_POINT;
+    sizes.firstIndex = strands.SegmentCount() * DOTS_INDICES_PER_SEGMENT;
+    return sizes;
+}
 
-        while (t0 < tmax)
-        {
-            // Compute next intersection point
-            float t1 = glm::min(tmax, t0 + voxelSize); // TODO: Check if step is correct (voxelsize should be multiplied by s?)
-            glm::vec3 p1 = vr0 + s * (t1 - tmin);
+// Every point of a strand gets two orthogonal cross-sections of two vertices each, which consecutive segments share through the index buffer.
+// The cross-sections follow a parallel-transported frame, so the strips don't twist along the strand.
+// Writes into slots sized by DOTSBufferSizes, indices are offset by the position of the vertices in the model buffer.
+template <StrandSource Source>
+Mesh GenerateDisjointOrthogonalTriangleStrips(const Source& strands, std::span<Mesh::QuantizedVertex> vertices, std::span<uint32_t> indices, uint32_t baseVertex, JobSystem& jobSystem, float radius = DEFAULT_HAIR_RADIUS)
+{
+    Mesh mesh {};
+    mesh.vertexFormat = Mesh::VertexFormat::eQuantized;
+    mesh.boundingBox = StrandBounds(strands, radius);
+    mesh.indexCount = indices.size();
 
-            // Define box to voxelize
-            glm::vec3 worldMin = glm::min(p0, p1);
-            glm::vec3 worldMax = glm::max(p0, p1);
+    constexpr uint32_t numVerticesPerPoint = DOTS_VERTICES_PER_POINT;
+    constexpr uint32_t numIndicesPerSegment = DOTS_INDICES_PER_SEGMENT;
 
-            worldMin[a[1]] -= r1;
-            worldMin[a[2]] -= r2;
+    ForEachChunk(strands.StrandCount(), STRAND_CHUNK_SIZE, jobSystem, [&](uint32_t, uint32_t begin, uint32_t end)
+        {
+            for (uint32_t strandIndex = begin; strandIndex < end; ++strandIndex)
+            {
+                const StrandPoints strand = strands.Strand(strandIndex);
+                const uint32_t pointCount = strand.count;
+                if (pointCount < 2)
+                {
+                    continue;
+                }
 
-            worldMax[a[1]] += r1;
-            worldMax[a[2]] += r2;
+                // Vertex and index slots of every strand follow from its first point and segment
+                const uint32_t firstVertex = strands.FirstPoint(strandIndex) * numVerticesPerPoint;
+                uint32_t index = strands.FirstSegment(strandIndex) * numIndicesPerSegment;
 
-            glm::ivec3 minIndex = GetVoxelIndex3D(worldMin, voxelMesh.boundingBox.min, voxelSize);
-            glm::ivec3 maxIndex = GetVoxelIndex3D(worldMax, voxelMesh.boundingBox.min, voxelSize);
+                glm::vec3 s {}, t {};
+                for (uint32_t i = 0; i < pointCount; ++i)
+                {
+                    const glm::vec3 point = strand.Point(i);
+                    const glm::vec3 previous = strand.Point(i > 0 ? i - 1 : i);
+                    const glm::vec3 next = strand.Point(i + 1 < pointCount ? i + 1 : i);
+                    const glm::vec3 fwd = glm::normalize(next - previous);
+
+                    // Transport the frame of the previous point onto the plane of this point, and build a new one when that isn't possible
+                    const glm::vec3 transported = s - fwd * glm::dot(s, fwd);
+                    if (i == 0 || glm::dot(transported, transported) < 1e-6f)
+                    {
+                        BuildFrame(fwd, s, t);
+                    }
+                    else
+                    {
+                        s = glm::normalize(transported);
+                        t = glm::cross(fwd, s);
+                    }
+
+                    const uint32_t pointVertex = firstVertex + i * numVerticesPerPoint;
+                    vertices[pointVertex] = QuantizeVertex(point + s * radius, fwd, mesh.boundingBox);
+                    vertices[pointVertex + 1] = QuantizeVertex(point - s * radius, fwd, mesh.boundingBox);
+                    vertices[pointVertex + 2] = QuantizeVertex(point + t * radius, fwd, mesh.boundingBox);
+                    vertices[pointVertex + 3] = QuantizeVertex(point - t * radius, fwd, mesh.boundingBox);
+                }
 
-            // Visit all voxels within box
-            for (int32_t j = minIndex.y; j <= maxIndex.y; ++j)
-            {
-                for (int32_t k = minIndex.z; k <= maxIndex.z; ++k)
+                for (uint32_t i = 0; i < pointCount - 1; ++i)
                 {
-                    glm::ivec3 index = glm::ivec3(minIndex.x, j, k);
-                    FillVoxel(index, voxelMesh, voxels);
+                    for (uint32_t face = 0; face < 2; ++face)
+                    {
+                        const uint32_t start = baseVertex + firstVertex + i * numVerticesPerPoint + face * 2;
+                        const uint32_t end = start + numVerticesPerPoint;
+
+                        indices[index++] = start;
+                        indices[index++] = end + 1;
+                        indices[index++] = end;
+                        indices[index++] = start;
+                        indices[index++] = start + 1;
+                        indices[index++] = end + 1;
+                    }
                 }
             }
+        });
 
-            // Move to next intersection point
-            t0 = t1;
-            p0 = p1;
-        }
-    }
-
-    return voxelMesh;
+    return mesh;
 }
 
-ModelCreation ProcessHairCurves(const ModelCreation& modelCreation)
+// Converts clusters of strands into clusters of the triangles generated for them by the DOTS generator
+std::vector<GeometryCluster> DOTSClusters(const StrandBuffer& strands, std::vector<GeometryCluster> strandClusters)
 {
-    const auto it = std::find_if(modelCreation.sceneGraph->meshes.begin(), modelCreation.sceneGraph->meshes.end(), [](const Mesh& mesh)
-        { return mesh.primitiveType != Mesh::PrimitiveType::eLines; });
-    if (it != modelCreation.sceneGraph->meshes.end())
+    for (GeometryCluster& cluster : strandClusters)
     {
-        spdlog::error("[GEOMETRY PROCESSOR] Model \"{}\" contains multiple different mesh primitive types while trying to generate hair model!", modelCreation.sceneGraph->sceneName);
-        return modelCreation;
+        const uint32_t endStrand = cluster.firstPrimitive + cluster.primitiveCount;
+        const uint32_t firstSegment = strands.FirstSegment(cluster.firstPrimitive);
+        const uint32_t endSegment = endStrand < strands.StrandCount() ? strands.FirstSegment(endStrand) : strands.SegmentCount();
+
+        cluster.firstPrimitive = firstSegment * DOTS_TRIANGLES_PER_SEGMENT;
+        cluster.primitiveCount = (endSegment - firstSegment) * DOTS_TRIANGLES_PER_SEGMENT;
     }
 
-    ModelCreation newModelCreation {};
-    newModelCreation.sceneGraph = modelCreation.sceneGraph;
-    SceneGraph& sceneGraph = *newModelCreation.sceneGraph;
+    return strandClusters;
+}
 
-    for (int meshIndex = 0; meshIndex < sceneGraph.meshes.size(); ++meshIndex)
-    {
-        const Mesh& oldMesh = sceneGraph.meshes[meshIndex];
+template <StrandSource Source>
+MeshBufferSizes LSSBufferSizes(const Source& strands)
+{
+    MeshBufferSizes sizes {};
+    sizes.firstLssVertex = strands.PointCount();
+    sizes.firstLssRadius = strands.PointCount();
+    sizes.firstLssIndex = strands.SegmentCount();
+    return sizes;
+}
 
-        Hair& hair = sceneGraph.hairs.emplace_back();
-        hair.material = oldMesh.material;
-        hair.firstCurve = newModelCreation.curveBuffer.size();
-        hair.firstAabb = newModelCreation.aabbBuffer.size();
+// Every strand point becomes a single vertex, segments refer to their first point through the index buffer.
+// Strands are separated by leaving out the index of their last point, so no segment connects two strands.
+// Writes into slots sized by LSSBufferSizes, indices stay relative to the mesh's first vertex.
+template <StrandSource Source>
+LSSMesh GenerateLinearSweptSpheres(const Source& strands, std::span<glm::vec3> positions, std::span<float> radii, std::span<uint32_t> indices, JobSystem& jobSystem, float radius = DEFAULT_HAIR_RADIUS)
+{
+    LSSMesh mesh {};
+    mesh.vertexCount = positions.size();
+    mesh.indexCount = indices.size();
+    std::fill(radii.begin(), radii.end(), glm::max(radius, 0.001f));
 
-        // Create line segments from hair lines
-        const std::vector<Line> lines = GenerateLines(oldMesh, modelCreation.vertexBuffer, modelCreation.indexBuffer);
+    ForEachChunk(strands.StrandCount(), STRAND_CHUNK_SIZE, jobSystem, [&](uint32_t, uint32_t begin, uint32_t end)
+        {
+            for (uint32_t strandIndex = begin; strandIndex < end; ++strandIndex)
+            {
+                const StrandPoints strand = strands.Strand(strandIndex);
+                const uint32_t firstPoint = strands.FirstPoint(strandIndex);
+
+                for (uint32_t i = 0; i < strand.count; ++i)
+                {
+                    positions[firstPoint + i] = strand.Point(i);
+                }
+
+                const uint32_t firstSegment = strands.FirstSegment(strandIndex);
+                for (uint32_t i = 0; i + 1 < strand.count; ++i)
+                {
+                    indices[firstSegment + i] = firstPoint + i;
+                }
+            }
+        });
+
+    return mesh;
+}
+
+// Rotates a frame along with the curve using the double reflection method, which keeps the twist of the frame minimal.
+// Wang et al. 2008, "Computation of Rotation Minimizing Frames".
+glm::vec3 TransportFrame(const glm::vec3& previousPoint, const glm::vec3& previousTangent, const glm::vec3& previousNormal, const glm::vec3& point, const glm::vec3& tangent)
+{
+    glm::vec3 normal = previousNormal;
+    glm::vec3 reflectedTangent = previousTangent;
+
+    const glm::vec3 v1 = point - previousPoint;
+    const float c1 = glm::dot(v1, v1);
+    if (c1 > 1e-12f)
+    {
+        normal -= (2.0f / c1) * glm::dot(v1, normal) * v1;
+        reflectedTangent -= (2.0f / c1) * glm::dot(v1, reflectedTangent) * v1;
+    }
+
+    const glm::vec3 v2 = tangent - reflectedTangent;
+    const float c2 = glm::dot(v2, v2);
+    if (c2 > 1e-12f)
+    {
+        normal -= (2.0f / c2) * glm::dot(v2, normal) * v2;
+    }
+
+    // Remove the drift that builds up over long strands
+    return glm::normalize(normal - tangent * glm::dot(normal, tangent));
+}
+
+static constexpr uint32_t MIN_TUBE_CURVE_SAMPLES = 2;
+static constexpr uint32_t MIN_TUBE_RADIAL_SAMPLES = 3;
+
+// Every strand has a ring at its root, every curve adds the rings after its first sample
+template <StrandSource Source>
+MeshBufferSizes TubeBufferSizes(const Source& strands, uint32_t numCurveSamples, uint32_t numRadialSamples)
+{
+    numCurveSamples = std::max(numCurveSamples, MIN_TUBE_CURVE_SAMPLES);
+    numRadialSamples = std::max(numRadialSamples, MIN_TUBE_RADIAL_SAMPLES);
+
+    const uint32_t ringsPerCurve = numCurveSamples - 1;
+    const uint32_t ringCount = strands.SegmentCount() * ringsPerCurve + strands.StrandCount();
+
+    MeshBufferSizes sizes {};
+    sizes.firstQuantizedVertex = ringCount * numRadialSamples;
+    sizes.firstIndex = strands.SegmentCount() * ringsPerCurve * numRadialSamples * 6;
+    return sizes;
+}
+
+float SurfaceArea(const AABB& aabb)
+{
+    const glm::vec3 extent = aabb.max - aabb.min;
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+// Box spanned by the control points, which contains the whole curve
+AABB ControlPointBounds(const Curve& curve)
+{
+    return AABB {
+        glm::min(glm::min(curve.start, curve.end), glm::min(curve.controlPoint1, curve.controlPoint2)),
+        glm::max(glm::max(curve.start, curve.end), glm::max(curve.controlPoint1, curve.controlPoint2))
+    };
+}
+
+static constexpr uint32_t MAX_CURVE_SPLITS = 8;
+
+// Cost of traversing an extra bvh node, relative to running the curve intersection shader
+static constexpr float CURVE_SPLIT_TRAVERSAL_COST = 0.25f;
+
+struct CurveSplit
+{
+    float tMin {};
+    float tMax {};
+    AABB aabb {};
+    float surfaceArea {};
+};
+
+CurveSplit BoundCurveSplit(const Curve& curve, float tMin, float tMax, float curveRadius)
+{
+    CurveSplit split {};
+    split.tMin = tMin;
+    split.tMax = tMax;
+
+    const Curve segment = curve.Segment(tMin, tMax);
+    BoundCurves(&segment, 1, curveRadius, &split.aabb);
+    split.surfaceArea = SurfaceArea(split.aabb);
+
+    return split;
+}
+
+// Greedily halves the parameter range with the largest surface area heuristic saving, until no split pays off or maxSplits is reached.
+// Splits are ordered by their parameter range. Deterministic, so counting and filling passes get the same result.
+uint32_t SplitCurve(const Curve& curve, float curveRadius, uint32_t maxSplits, std::array<CurveSplit, MAX_CURVE_SPLITS>& splits)
+{
+    maxSplits = std::clamp(maxSplits, 1u, MAX_CURVE_SPLITS);
+
+    splits[0] = BoundCurveSplit(curve, 0.0f, 1.0f, curveRadius);
+    uint32_t splitCount = 1;
+
+    while (splitCount < maxSplits)
+    {
+        float bestSaving = 0.0f;
+        uint32_t bestIndex = splitCount;
+        CurveSplit bestLeft {};
+        CurveSplit bestRight {};
+
+        for (uint32_t i = 0; i < splitCount; ++i)
+        {
+            const CurveSplit& split = splits[i];
+            const float tMid = 0.5f * (split.tMin + split.tMax);
+            const CurveSplit left = BoundCurveSplit(curve, split.tMin, tMid, curveRadius);
+            const CurveSplit right = BoundCurveSplit(curve, tMid, split.tMax, curveRadius);
+
+            // A hit probability is proportional to surface area, and the split turns one leaf into a node with two leaves
+            const float saving = split.surfaceArea * (1.0f - CURVE_SPLIT_TRAVERSAL_COST) - (left.surfaceArea + right.surfaceArea);
+            if (saving > bestSaving)
+            {
+                bestSaving = saving;
+                bestIndex = i;
+                bestLeft = left;
+                bestRight = right;
+            }
+        }
+
+        if (bestIndex == splitCount)
+        {
+            break;
+        }
+
+        std::move_backward(splits.begin() + bestIndex + 1, splits.begin() + splitCount, splits.begin() + splitCount + 1);
+        splits[bestIndex] = bestLeft;
+        splits[bestIndex + 1] = bestRight;
+        ++splitCount;
+    }
+
+    return splitCount;
+}
+
+// Splits of a curve packed into 32 bits, the split count in the lowest 4 bits followed by 3 bits for the depth of every split.
+// Splits only ever halve parameter ranges, so their ranges follow from the depths and only the final splits have to be bounded again.
+using CurveSplitCode = uint32_t;
+
+static_assert(MAX_CURVE_SPLITS <= 8, "Split counts and depths have to fit a CurveSplitCode");
+
+CurveSplitCode EncodeCurveSplits(const std::array<CurveSplit, MAX_CURVE_SPLITS>& splits, uint32_t splitCount)
+{
+    CurveSplitCode code = splitCount;
+    for (uint32_t i = 0; i < splitCount; ++i)
+    {
+        const uint32_t depth = -std::ilogb(splits[i].tMax - splits[i].tMin);
+        code |= depth << (4 + i * 3);
+    }
+
+    return code;
+}
+
+// Rebuilds the splits found by SplitCurve from their code, the halved ranges are exact so the result is identical
+uint32_t DecodeCurveSplits(const Curve& curve, CurveSplitCode code, float curveRadius, std::array<CurveSplit, MAX_CURVE_SPLITS>& splits)
+{
+    const uint32_t splitCount = code & 0xF;
+
+    float tMin = 0.0f;
+    for (uint32_t i = 0; i < splitCount; ++i)
+    {
+        const int32_t depth = (code >> (4 + i * 3)) & 0x7;
+        const float tMax = tMin + std::ldexp(1.0f, -depth);
+        splits[i] = BoundCurveSplit(curve, tMin, tMax, curveRadius);
+        tMin = tMax;
+    }
+
+    return splitCount;
+}
+
+
+struct CurveQuantizationError
+{
+    float maxError {};
+    float maxBound {};
+};
+
+// Curves of a single strand, fitted once and handed to every fused stage
+struct StrandCurves
+{
+    uint32_t strandIndex {};
+    uint32_t firstCurve {}; // Curves of a strand buffer are stored in strand order, so this is also the strand's first segment
+    std::span<const Curve> curves {};
+    glm::vec3 root {};
+};
+
+// Fits the curves of every strand in [begin, end) once and runs all stages on them while they are still in cache, instead of storing
+// the curves of a whole level and reading them back in a separate pass per stage. Stages are functors that take StrandCurves, so every
+// combination gets its own specialized loop. Strands without points are skipped.
+template <StrandSource Source, typename... Stages>
+void FuseCurveStages(const Source& strands, uint32_t begin, uint32_t end, Stages&... stages)
+{
+    std::vector<Curve> curves {};
+
+    for (uint32_t strandIndex = begin; strandIndex < end; ++strandIndex)
+    {
+        const StrandPoints strand = strands.Strand(strandIndex);
+        if (strand.count == 0)
+        {
+            continue;
+        }
+
+        curves.resize(strand.count - 1);
+        FitStrandCurves(strand, 1.0f, curves.data());
+
+        const StrandCurves strandCurves { strandIndex, strands.FirstSegment(strandIndex), curves, strand.Point(0) };
+        (stages(strandCurves), ...);
+    }
+}
+
+// Counts the curve primitives of the strands, every curve is split into 1 up to maxSplits parts.
+// The splits of every curve are kept as a code, so emitting doesn't have to search for them again.
+struct CountCurveSplits
+{
+    float curveRadius {};
+    uint32_t maxSplits {};
+    std::span<CurveSplitCode> splitCodes {};
+    uint32_t count {};
+    std::array<CurveSplit, MAX_CURVE_SPLITS> splits {};
+
+    void operator()(const StrandCurves& strand)
+    {
+        if (maxSplits <= 1)
+        {
+            count += strand.curves.size();
+            return;
+        }
+
+        for (uint32_t i = 0; i < strand.curves.size(); ++i)
+        {
+            const uint32_t splitCount = SplitCurve(strand.curves[i], curveRadius, maxSplits, splits);
+            splitCodes[strand.firstCurve + i] = EncodeCurveSplits(splits, splitCount);
+            count += splitCount;
+        }
+    }
+};
+
+// Step of the 16 bit offsets the control points of a strand are quantized to, spreading its largest offset over the full range
+float CurveQuantizationScale(const StrandCurves& strand)
+{
+    constexpr float maxOffset = std::numeric_limits<int16_t>::max();
+
+    float largestOffset = 0.0f;
+    for (const Curve& curve : strand.curves)
+    {
+        for (const glm::vec3& point : { curve.start, curve.controlPoint1, curve.controlPoint2, curve.end })
+        {
+            const glm::vec3 offset = glm::abs(point - strand.root);
+            largestOffset = std::max({ largestOffset, offset.x, offset.y, offset.z });
+        }
+    }
+
+    return std::max(largestOffset, std::numeric_limits<float>::min()) / maxOffset;
+}
+
+// Distance a quantized control point of the strand is off by at most, every component being off by at most half a step
+float CurveQuantizationBound(float scale)
+{
+    return scale * std::sqrt(3.0f) * 0.5f;
+}
+
+// Writes the aabb's and matching curve primitives counted by CountCurveSplits, starting at the given output slot.
+// The shaders intersect the quantized curves, which are within the quantization bound of the fitted ones at every parameter,
+// so the aabb's are grown by it to still contain them.
+struct EmitCurveSplits
+{
+    float curveRadius {};
+    uint32_t maxSplits {};
+    std::span<const CurveSplitCode> splitCodes {};
+    std::span<CurvePrimitive> primitives {};
+    std::span<AABB> aabbs {};
+    uint32_t output {};
+    std::array<CurveSplit, MAX_CURVE_SPLITS> splits {};
+
+    void operator()(const StrandCurves& strand)
+    {
+        const float boundRadius = curveRadius + CurveQuantizationBound(CurveQuantizationScale(strand));
+
+        if (maxSplits <= 1)
+        {
+            BoundCurves(strand.curves.data(), strand.curves.size(), boundRadius, aabbs.data() + output);
+            for (uint32_t i = 0; i < strand.curves.size(); ++i, ++output)
+            {
+                primitives[output] = CurvePrimitive { strand.firstCurve + i, strand.strandIndex, 0.0f, 1.0f };
+            }
+            return;
+        }
+
+        for (uint32_t i = 0; i < strand.curves.size(); ++i)
+        {
+            const uint32_t splitCount = DecodeCurveSplits(strand.curves[i], splitCodes[strand.firstCurve + i], boundRadius, splits);
+            for (uint32_t j = 0; j < splitCount; ++j, ++output)
+            {
+                primitives[output] = CurvePrimitive { strand.firstCurve + i, strand.strandIndex, splits[j].tMin, splits[j].tMax };
+                aabbs[output] = splits[j].aabb;
+            }
+        }
+    }
+};
+
+// Stores the control points of every curve as 16 bit offsets from the root of its strand. The scale of a strand spreads its largest
+// offset over the full range, so every component is off by at most half a step and a control point by at most sqrt(3) / 2 steps.
+struct QuantizeStrandCurves
+{
+    std::span<QuantizedCurve> quantizedCurves {};
+    std::span<CurveStrand> curveStrands {};
+    CurveQuantizationError error {};
+
+    void operator()(const StrandCurves& strand)
+    {
+        constexpr float maxOffset = std::numeric_limits<int16_t>::max();
+
+        CurveStrand& curveStrand = curveStrands[strand.strandIndex];
+        curveStrand.root = strand.root;
+        curveStrand.scale = CurveQuantizationScale(strand);
+
+        for (uint32_t curveIndex = 0; curveIndex < strand.curves.size(); ++curveIndex)
+        {
+            const Curve& curve = strand.curves[curveIndex];
+            const std::array<glm::vec3, 4> points { curve.start, curve.controlPoint1, curve.controlPoint2, curve.end };
+            QuantizedCurve& quantizedCurve = quantizedCurves[strand.firstCurve + curveIndex];
+
+            for (uint32_t i = 0; i < points.size(); ++i)
+            {
+                const glm::vec3 offset = glm::clamp(glm::round((points[i] - strand.root) / curveStrand.scale), -maxOffset, maxOffset);
+                for (uint32_t axis = 0; axis < 3; ++axis)
+                {
+                    quantizedCurve.offsets[i * 3 + axis] = static_cast<int16_t>(offset[axis]);
+                }
+
+                error.maxError = std::max(error.maxError, glm::length(strand.root + offset * curveStrand.scale - points[i]));
+            }
+        }
+
+        error.maxBound = std::max(error.maxBound, CurveQuantizationBound(curveStrand.scale));
+    }
+};
+
+// Total surface area of the boxes spanned by the control points, which is what the curve aabb's used to be
+struct MeasureControlPointArea
+{
+    float curveRadius {};
+    float surfaceArea {};
+
+    void operator()(const StrandCurves& strand)
+    {
+        for (const Curve& curve : strand.curves)
+        {
+            const AABB bounds = ControlPointBounds(curve);
+            surfaceArea += SurfaceArea(AABB { bounds.min - curveRadius, bounds.max + curveRadius });
+        }
+    }
+};
+
+// Bounds of the control points of all curves, which contain the curves themselves
+struct BoundControlPoints
+{
+    AABB bounds { glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()) };
+
+    void operator()(const StrandCurves& strand)
+    {
+        for (const Curve& curve : strand.curves)
+        {
+            const AABB curveBounds = ControlPointBounds(curve);
+            bounds.min = glm::min(bounds.min, curveBounds.min);
+            bounds.max = glm::max(bounds.max, curveBounds.max);
+        }
+    }
+};
+
+// Sweeps a ring of vertices along the curves of a strand, consecutive curves share the ring where they meet.
+// Vertex and index slots follow from the strand's first curve, so strands are written in parallel.
+// Writes into slots sized by TubeBufferSizes, indices are offset by the position of the vertices in the model buffer.
+struct EmitTubes
+{
+    std::span<Mesh::QuantizedVertex> vertices {};
+    std::span<uint32_t> indices {};
+    uint32_t baseVertex {};
+    AABB bounds {};
+    float radius {};
+    uint32_t numCurveSamples {};
+    std::span<const glm::vec2> ringDirections {};
+
+    void operator()(const StrandCurves& strand)
+    {
+        if (strand.curves.empty())
+        {
+            return;
+        }
+
+        const uint32_t numRadialSamples = ringDirections.size();
+        const uint32_t ringsPerCurve = numCurveSamples - 1;
+        const uint32_t numIndicesPerRing = numRadialSamples * 6;
+
+        const uint32_t firstRingVertex = (strand.firstCurve * ringsPerCurve + strand.strandIndex) * numRadialSamples;
+        uint32_t index = strand.firstCurve * ringsPerCurve * numIndicesPerRing;
+
+        glm::vec3 previousPoint {}, previousTangent {}, normal {};
+        uint32_t ring = 0;
+
+        for (uint32_t curveIndex = 0; curveIndex < strand.curves.size(); ++curveIndex)
+        {
+            const Curve& curve = strand.curves[curveIndex];
+
+            // The first sample of every curve after the first is the last ring of the previous one
+            for (uint32_t sample = curveIndex == 0 ? 0 : 1; sample < numCurveSamples; ++sample)
+            {
+                const float t = static_cast<float>(sample) / static_cast<float>(numCurveSamples - 1);
+                const glm::vec3 point = curve.Sample(t);
+                const glm::vec3 derivative = curve.SampleDerivitive(t);
+                const glm::vec3 tangent = glm::dot(derivative, derivative) > 1e-12f ? glm::normalize(derivative) : (ring > 0 ? previousTangent : glm::normalize(curve.end - curve.start));
+
+                if (ring == 0)
+                {
+                    glm::vec3 binormal {};
+                    BuildFrame(tangent, normal, binormal);
+                }
+                else
+                {
+                    normal = TransportFrame(previousPoint, previousTangent, normal, point, tangent);
+                }
+                const glm::vec3 binormal = glm::cross(tangent, normal);
+
+                const uint32_t ringVertex = firstRingVertex + ring * numRadialSamples;
+                for (uint32_t j = 0; j < numRadialSamples; ++j)
+                {
+                    const glm::vec3 direction = ringDirections[j].x * normal + ringDirections[j].y * binormal;
+                    vertices[ringVertex + j] = QuantizeVertex(point + direction * radius, tangent, bounds);
+                }
+
+                // Connect the ring to the previous one
+                if (ring > 0)
+                {
+                    const uint32_t currentRingVertex = baseVertex + ringVertex;
+                    const uint32_t previousRingVertex = currentRingVertex - numRadialSamples;
+                    for (uint32_t j = 0; j < numRadialSamples; ++j)
+                    {
+                        const uint32_t nextJ = (j + 1) % numRadialSamples;
+
+                        indices[index++] = previousRingVertex + j;
+                        indices[index++] = currentRingVertex + j;
+                        indices[index++] = currentRingVertex + nextJ;
+
+                        indices[index++] = previousRingVertex + j;
+                        indices[index++] = currentRingVertex + nextJ;
+                        indices[index++] = previousRingVertex + nextJ;
+                    }
+                }
+
+                previousPoint = point;
+                previousTangent = tangent;
+                ++ring;
+            }
+        }
+    }
+};
+
+template <typename T, typename B>
+T NextDivisible(const T& dividend, const B divisor)
+{
+    return glm::ceil(dividend / divisor) * divisor;
+}
+
+glm::ivec3 GetVoxelIndex3D(const glm::vec3& worldPosition, const glm::vec3& voxelGridOrigin, float voxelSize)
+{
+    return glm::floor((worldPosition - voxelGridOrigin) / voxelSize);
+}
+
+// Writes an aabb for every filled voxel, packed in the order the voxels are visited
+void GenerateAABBs(const glm::vec3& voxelGridOrigin, const VoxelBrickMap& voxels, float voxelSize, std::span<AABB> aabbs)
+{
+    uint32_t aabbIndex = 0;
+    voxels.ForEachFilled([&](const glm::ivec3& voxel)
+        {
+            glm::vec3 voxelWorldPosition = voxelGridOrigin + glm::vec3(voxel) * voxelSize;
+
+            AABB& aabb = aabbs[aabbIndex++];
+            aabb.min = voxelWorldPosition;
+            aabb.max = voxelWorldPosition + voxelSize;
+        });
+}
+
+std::array<uint8_t, 3> GetMajorAxes(const glm::vec3& v)
+{
+    glm::vec3 av = glm::abs(v);
+    std::array<uint8_t, 3> axes = { 0, 1, 2 };
+    std::sort(axes.begin(), axes.end(), [&](uint8_t a, uint8_t b)
+        { return av[a] > av[b]; });
+    return axes;
+}
+
+uint32_t VoxelCount(const VoxelMesh& voxelMesh)
+{
+    return voxelMesh.voxelGridResolution.x * voxelMesh.voxelGridResolution.y * voxelMesh.voxelGridResolution.z;
+}
+
+// Fits a grid of whole voxels around the mesh bounds, its size is known before anything is voxelized
+VoxelMesh CreateVoxelGrid(const AABB& meshBounds, float voxelSize)
+{
+    VoxelMesh voxelMesh {};
+    voxelMesh.boundingBox.min = meshBounds.min;
+    voxelMesh.boundingBox.max = meshBounds.max;
+
+    // Expand grid bounds until we can fit whole voxels inside
+    glm::vec3 voxelGridAreaDistance = voxelMesh.boundingBox.max - voxelMesh.boundingBox.min;
+    voxelGridAreaDistance = NextDivisible(voxelGridAreaDistance, voxelSize);
+    voxelMesh.boundingBox.max = voxelMesh.boundingBox.min + voxelGridAreaDistance;
+
+    // Set grid resolution
+    voxelMesh.voxelGridResolution = voxelGridAreaDistance / voxelSize;
+
+    spdlog::info("voxel grid size: {} with grid distance {}, {}, {}", VoxelCount(voxelMesh), voxelGridAreaDistance.x, voxelGridAreaDistance.y, voxelGridAreaDistance.z);
+    spdlog::info("voxel grid res {}, {}, {}", voxelMesh.voxelGridResolution.x, voxelMesh.voxelGridResolution.y, voxelMesh.voxelGridResolution.z);
+    spdlog::info("voxel bounds {}, {}, {} to {}, {}, {}", voxelMesh.boundingBox.min.x, voxelMesh.boundingBox.min.y, voxelMesh.boundingBox.min.z, voxelMesh.boundingBox.max.x, voxelMesh.boundingBox.max.y, voxelMesh.boundingBox.max.z);
+
+    return voxelMesh;
+}
+
+// Fills the voxels of an inclusive box that the capsule overlaps, a word of a row at a time
+template <bool ATOMIC, typename Voxels>
+void FillCapsuleVoxels(const Capsule& capsule, glm::ivec3 minIndex, glm::ivec3 maxIndex, float voxelSize, const VoxelMesh& voxelMesh, Voxels& voxels)
+{
+    minIndex = glm::max(minIndex, glm::ivec3(0));
+    maxIndex = glm::min(maxIndex, voxels.Resolution() - 1);
+
+    for (int32_t z = minIndex.z; z <= maxIndex.z; ++z)
+    {
+        for (int32_t y = minIndex.y; y <= maxIndex.y; ++y)
+        {
+            for (int32_t xFirst = minIndex.x; xFirst <= maxIndex.x;)
+            {
+                // Test the voxels of the box that share a word together
+                const uint32_t word = xFirst / VoxelOccupancyGrid::BITS_PER_WORD;
+                const int32_t xLast = glm::min<int32_t>(maxIndex.x, (word + 1) * VoxelOccupancyGrid::BITS_PER_WORD - 1);
+                const glm::vec3 firstVoxelMin = voxelMesh.boundingBox.min + glm::vec3(xFirst, y, z) * voxelSize;
+
+                const uint64_t bits = CapsuleOverlapRow(capsule, firstVoxelMin, voxelSize, xLast - xFirst + 1) << (xFirst % VoxelOccupancyGrid::BITS_PER_WORD);
+                if (bits != 0)
+                {
+                    if constexpr (ATOMIC)
+                    {
+                        voxels.SetRowWordAtomic(word, y, z, bits);
+                    }
+                    else
+                    {
+                        voxels.SetRowWord(word, y, z, bits);
+                    }
+                }
+
+                xFirst = xLast + 1;
+            }
+        }
+    }
+}
+
+// Calls the function with the capsule of every segment of a range of strands and the inclusive voxel boxes that cover it, one per major axis step
+// Algorithm taken from 'Real-Time Rendering of Dynamic Line Sets using Voxel Ray Tracing' paper: https://arxiv.org/pdf/2510.09081
+template <StrandSource Source, typename BoxFunction>
+void ForEachCapsuleVoxelBox(const Source& strands, uint32_t firstStrand, uint32_t lastStrand, float hairRadius, float voxelSize, const VoxelMesh& voxelMesh, BoxFunction&& function)
+{
+    for (uint32_t strandIndex = firstStrand; strandIndex < lastStrand; ++strandIndex)
+    {
+        const StrandPoints strand = strands.Strand(strandIndex);
+
+        for (uint32_t i = 0; i + 1 < strand.count; ++i)
+        {
+            const glm::vec3 start = strand.Point(i);
+            const glm::vec3 end = strand.Point(i + 1);
+
+            glm::vec3 d = end - start;
+            std::array<uint8_t, 3> a = GetMajorAxes(d);
+
+            // Make sure the major axis is always positive by swapping points
+            glm::vec3 v0 = d[a[0]] < 0.0f ? end : start;
+            glm::vec3 v1 = d[a[0]] < 0.0f ? start : end;
+
+            // Step vector from one major axis voxel boundary to the next
+            glm::vec3 s = d / d[a[0]];
+
+            // Get extended line segments to capture capsule ends
+            glm::vec3 sr = s * hairRadius;
+            glm::vec3 vr0 = v0 - sr;
+            glm::vec3 vr1 = v1 + sr;
+
+            // Get projected capsule radius on both minor axes
+            float dn = glm::length(d);
+            float r1 = hairRadius / glm::sqrt(1.0f - glm::pow2(d[a[1]] / dn));
+            float r2 = hairRadius / glm::sqrt(1.0f - glm::pow2(d[a[2]] / dn));
+
+            // Setup starting point for
+            float tmin = vr0[a[0]];
+            float tmax = vr1[a[0]];
+            float t0 = tmin;
+            glm::vec3 p0 = vr0;
+
+            while (t0 < tmax)
+            {
+                // Compute next intersection point
+                // s has a major axis component of one, so this steps exactly one voxel along the major axis
+                float t1 = glm::min(tmax, t0 + voxelSize);
+                glm::vec3 p1 = vr0 + s * (t1 - tmin);
+
+                // Define box to voxelize
+                glm::vec3 worldMin = glm::min(p0, p1);
+                glm::vec3 worldMax = glm::max(p0, p1);
+
+                worldMin[a[1]] -= r1;
+                worldMin[a[2]] -= r2;
+
+                worldMax[a[1]] += r1;
+                worldMax[a[2]] += r2;
+
+                glm::ivec3 minIndex = GetVoxelIndex3D(worldMin, voxelMesh.boundingBox.min, voxelSize);
+                glm::ivec3 maxIndex = GetVoxelIndex3D(worldMax, voxelMesh.boundingBox.min, voxelSize);
+
+                function(Capsule { start, end, hairRadius }, minIndex, maxIndex);
+
+                // Move to next intersection point
+                t0 = t1;
+                p0 = p1;
+            }
+        }
+    }
+}
+
+// Voxelizes the segments of a range of strands as capsules into a grid created by CreateVoxelGrid.
+// The exact mode only fills the voxels of each box that overlap the capsule, where the paper fills the whole box.
+template <bool ATOMIC, StrandSource Source, typename Voxels>
+void VoxelizeStrandRange(const Source& strands, uint32_t firstStrand, uint32_t lastStrand, float hairRadius, float voxelSize, VoxelizationMode mode, const VoxelMesh& voxelMesh, Voxels& voxels)
+{
+    ForEachCapsuleVoxelBox(strands, firstStrand, lastStrand, hairRadius, voxelSize, voxelMesh, [&](const Capsule& capsule, const glm::ivec3& minIndex, const glm::ivec3& maxIndex)
+        {
+            if (mode == VoxelizationMode::eExact)
+            {
+                FillCapsuleVoxels<ATOMIC>(capsule, minIndex, maxIndex, voxelSize, voxelMesh, voxels);
+            }
+            // Fill all voxels within box, a row along x at a time
+            else if constexpr (ATOMIC)
+            {
+                voxels.SetBoxAtomic(minIndex, maxIndex);
+            }
+            else
+            {
+                voxels.SetBox(minIndex, maxIndex);
+            }
+        });
+}
+
+// Voxelizes all strands into a sparse brick map, with ranges of strands spread over the job system.
+// A first pass marks every brick a box touches, so the bricks can be allocated in storage order before the second pass fills them.
+// Boxes of different strands that share a word are merged with atomic ORs, which makes the result independent of the order the ranges
+// are processed in. The geometry processor tests check this against VoxelizeHairStrandsSerial.
+template <StrandSource Source>
+void VoxelizeStrands(const Source& strands, float hairRadius, float voxelSize, VoxelizationMode mode, const VoxelMesh& voxelMesh, VoxelBrickMap& voxels, JobSystem& jobSystem)
+{
+    VoxelOccupancyGrid touchedBricks { voxels.BrickResolution() };
+    jobSystem.ParallelFor(strands.StrandCount(), STRAND_CHUNK_SIZE, [&](uint32_t begin, uint32_t end)
+        {
+            ForEachCapsuleVoxelBox(strands, begin, end, hairRadius, voxelSize, voxelMesh, [&](const Capsule&, const glm::ivec3& minIndex, const glm::ivec3& maxIndex)
+                { touchedBricks.SetBoxAtomic(VoxelBrickMap::BrickOf(minIndex), VoxelBrickMap::BrickOf(maxIndex)); });
+        });
+    voxels.AllocateBricks(touchedBricks);
+
+    jobSystem.ParallelFor(strands.StrandCount(), STRAND_CHUNK_SIZE, [&](uint32_t begin, uint32_t end)
+        { VoxelizeStrandRange<true>(strands, begin, end, hairRadius, voxelSize, mode, voxelMesh, voxels); });
+
+    // The exact test can leave a touched brick without any voxel
+    voxels.RemoveEmptyBricks();
+}
+
+// Clusters the aabbs of a hair and stores them, together with their curve primitives, in cluster order
+std::vector<GeometryCluster> ClusterCurvePrimitives(std::span<AABB> aabbs, std::span<CurvePrimitive> primitives, JobSystem& jobSystem)
+{
+    std::vector<glm::vec3> centroids(aabbs.size());
+    std::transform(aabbs.begin(), aabbs.end(), centroids.begin(), [](const AABB& aabb)
+        { return (aabb.min + aabb.max) * 0.5f; });
+
+    std::vector<uint32_t> order {};
+    std::vector<GeometryCluster> clusters = ClusterPrimitives(centroids, order, jobSystem);
+    if (clusters.size() == 1)
+    {
+        return clusters;
+    }
+
+    std::vector<AABB> clusteredAabbs(aabbs.size());
+    std::vector<CurvePrimitive> clusteredPrimitives(primitives.size());
+    jobSystem.ParallelFor(order.size(), EMIT_CHUNK_SIZE, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                clusteredAabbs[i] = aabbs[order[i]];
+                clusteredPrimitives[i] = primitives[order[i]];
+            }
+        });
+
+    std::copy(clusteredAabbs.begin(), clusteredAabbs.end(), aabbs.begin());
+    std::copy(clusteredPrimitives.begin(), clusteredPrimitives.end(), primitives.begin());
+    return clusters;
+}
+
+// Clusters whole strands by their centroid, so geometry generated for them can be split into spatially compact geometries
+template <StrandSource Source>
+StrandBuffer ClusterStrands(const Source& strands, uint32_t primitivesPerSegment, std::vector<GeometryCluster>& clusters, JobSystem& jobSystem)
+{
+    std::vector<uint32_t> order {};
+    clusters = ClusterPrimitives(StrandCentroids(strands, jobSystem), order, jobSystem, strands.SegmentCount() * primitivesPerSegment);
+
+    return GatherStrands(strands, order, jobSystem);
+}
+
+// Grows the model buffers once for outputs of known size and returns the slot of every output.
+// An exclusive prefix sum over the output sizes gives every output its slot, which allows writing all of them in parallel.
+std::vector<MeshBufferOffsets> AllocateMeshOutputs(const std::vector<MeshBufferSizes>& outputSizes, ModelCreation& modelCreation)
+{
+    std::vector<MeshBufferOffsets> offsets(outputSizes.size());
+
+    MeshBufferOffsets total {};
+    total.firstVertex = modelCreation.vertexBuffer.size();
+    total.firstQuantizedVertex = modelCreation.quantizedVertexBuffer.size();
+    total.firstIndex = modelCreation.indexBuffer.size();
+    total.firstCurve = modelCreation.curveBuffer.size();
+    total.firstCurveStrand = modelCreation.curveStrandBuffer.size();
+    total.firstCurvePrimitive = modelCreation.curvePrimitiveBuffer.size();
+    total.firstAabb = modelCreation.aabbBuffer.size();
+    total.firstVoxelBrickIndex = modelCreation.voxelBrickIndexBuffer.size();
+    total.firstVoxelBrick = modelCreation.voxelBrickBuffer.size();
+    total.firstLssVertex = modelCreation.lssPositionBuffer.size();
+    total.firstLssRadius = modelCreation.lssRadiusBuffer.size();
+    total.firstLssIndex = modelCreation.lssIndexBuffer.size();
+
+    for (uint32_t i = 0; i < outputSizes.size(); ++i)
+    {
+        const MeshBufferSizes& sizes = outputSizes[i];
+        offsets[i] = total;
+
+        total.firstVertex += sizes.firstVertex;
+        total.firstQuantizedVertex += sizes.firstQuantizedVertex;
+        total.firstIndex += sizes.firstIndex;
+        total.firstCurve += sizes.firstCurve;
+        total.firstCurveStrand += sizes.firstCurveStrand;
+        total.firstCurvePrimitive += sizes.firstCurvePrimitive;
+        total.firstAabb += sizes.firstAabb;
+        total.firstVoxelBrickIndex += sizes.firstVoxelBrickIndex;
+        total.firstVoxelBrick += sizes.firstVoxelBrick;
+        total.firstLssVertex += sizes.firstLssVertex;
+        total.firstLssRadius += sizes.firstLssRadius;
+        total.firstLssIndex += sizes.firstLssIndex;
+    }
+
+    modelCreation.vertexBuffer.resize(total.firstVertex);
+    modelCreation.quantizedVertexBuffer.resize(total.firstQuantizedVertex);
+    modelCreation.indexBuffer.resize(total.firstIndex);
+    modelCreation.curveBuffer.resize(total.firstCurve);
+    modelCreation.curveStrandBuffer.resize(total.firstCurveStrand);
+    modelCreation.curvePrimitiveBuffer.resize(total.firstCurvePrimitive);
+    modelCreation.aabbBuffer.resize(total.firstAabb);
+    modelCreation.voxelBrickIndexBuffer.resize(total.firstVoxelBrickIndex);
+    modelCreation.voxelBrickBuffer.resize(total.firstVoxelBrick);
+    modelCreation.lssPositionBuffer.resize(total.firstLssVertex);
+    modelCreation.lssRadiusBuffer.resize(total.firstLssRadius);
+    modelCreation.lssIndexBuffer.resize(total.firstLssIndex);
+
+    return offsets;
+}
+
+// Sub range of a model buffer that belongs to a single output
+template <typename T>
+std::span<T> OutputSpan(std::vector<T>& buffer, uint32_t offset, uint32_t size)
+{
+    return std::span<T>(buffer).subspan(offset, size);
+}
+
+// Slots of a single output in the model buffers
+struct MeshOutputSlots
+{
+    MeshBufferOffsets offsets {};
+    std::span<Mesh::Vertex> vertices {};
+    std::span<Mesh::QuantizedVertex> quantizedVertices {};
+    std::span<uint32_t> indices {};
+    std::span<QuantizedCurve> curves {};
+    std::span<CurveStrand> curveStrands {};
+    std::span<CurvePrimitive> curvePrimitives {};
+    std::span<AABB> aabbs {};
+    std::span<uint32_t> voxelBrickIndices {};
+    std::span<VoxelBrick> voxelBricks {};
+    std::span<glm::vec3> lssPositions {};
+    std::span<float> lssRadii {};
+    std::span<uint32_t> lssIndices {};
+};
+
+MeshOutputSlots OutputSlots(ModelCreation& modelCreation, const MeshBufferOffsets& offsets, const MeshBufferSizes& sizes)
+{
+    MeshOutputSlots slots {};
+    slots.offsets = offsets;
+    slots.vertices = OutputSpan(modelCreation.vertexBuffer, offsets.firstVertex, sizes.firstVertex);
+    slots.quantizedVertices = OutputSpan(modelCreation.quantizedVertexBuffer, offsets.firstQuantizedVertex, sizes.firstQuantizedVertex);
+    slots.indices = OutputSpan(modelCreation.indexBuffer, offsets.firstIndex, sizes.firstIndex);
+    slots.curves = OutputSpan(modelCreation.curveBuffer, offsets.firstCurve, sizes.firstCurve);
+    slots.curveStrands = OutputSpan(modelCreation.curveStrandBuffer, offsets.firstCurveStrand, sizes.firstCurveStrand);
+    slots.curvePrimitives = OutputSpan(modelCreation.curvePrimitiveBuffer, offsets.firstCurvePrimitive, sizes.firstCurvePrimitive);
+    slots.aabbs = OutputSpan(modelCreation.aabbBuffer, offsets.firstAabb, sizes.firstAabb);
+    slots.voxelBrickIndices = OutputSpan(modelCreation.voxelBrickIndexBuffer, offsets.firstVoxelBrickIndex, sizes.firstVoxelBrickIndex);
+    slots.voxelBricks = OutputSpan(modelCreation.voxelBrickBuffer, offsets.firstVoxelBrick, sizes.firstVoxelBrick);
+    slots.lssPositions = OutputSpan(modelCreation.lssPositionBuffer, offsets.firstLssVertex, sizes.firstLssVertex);
+    slots.lssRadii = OutputSpan(modelCreation.lssRadiusBuffer, offsets.firstLssRadius, sizes.firstLssRadius);
+    slots.lssIndices = OutputSpan(modelCreation.lssIndexBuffer, offsets.firstLssIndex, sizes.firstLssIndex);
+    return slots;
+}
+
+bool ValidateHairModel(const ModelCreation& modelCreation)
+{
+    const auto it = std::find_if(modelCreation.sceneGraph->meshes.begin(), modelCreation.sceneGraph->meshes.end(), [](const Mesh& mesh)
+        { return mesh.primitiveType != Mesh::PrimitiveType::eLines; });
+    if (it != modelCreation.sceneGraph->meshes.end())
+    {
+        spdlog::error("[GEOMETRY PROCESSOR] Model \"{}\" contains multiple different mesh primitive types while trying to generate hair model!", modelCreation.sceneGraph->sceneName);
+        return false;
+    }
+
+    return true;
+}
+
+// Settings are typed into the editor as well, a non-positive radius, voxel size or deviation would break processing (a zero voxel size divides
+// by zero sizing the voxel grid), those are replaced by their defaults
+HairSettings ValidateHairSettings(const HairSettings& settings)
+{
+    HairSettings validSettings = settings;
+    const auto validate = [](float& value, float defaultValue, std::string_view name)
+    {
+        if (!(value > 0.0f))
+        {
+            spdlog::error("[GEOMETRY PROCESSOR] Hair {} of {} is not positive, using the default of {} instead!", name, value, defaultValue);
+            value = defaultValue;
+        }
+    };
+
+    validate(validSettings.radius, DEFAULT_HAIR_RADIUS, "radius");
+    validate(validSettings.voxelSize, DEFAULT_VOXEL_SIZE, "voxel size");
+    validate(validSettings.maxStrandDeviation, DEFAULT_MAX_STRAND_DEVIATION, "maximum strand deviation");
+    return validSettings;
+}
+
+// Hair is generated from the strand buffers alone, so the loaded line vertices and indices are released before processing
+void ReleaseLineGeometry(ModelCreation& modelCreation)
+{
+    modelCreation.vertexBuffer = {};
+    modelCreation.indexBuffer = {};
+}
+
+// FNV-1a over 32-bit words, used to key the cached processing stages. Zero is never produced for the keys in practice and marks a stage as not computed.
+template <typename T>
+    requires(sizeof(T) == sizeof(uint32_t))
+uint64_t HashWords(std::span<const T> values, uint64_t hash = 14695981039346656037ull)
+{
+    for (const T value : values)
+    {
+        hash = (hash ^ std::bit_cast<uint32_t>(value)) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+uint64_t HashStrands(const StrandBuffer& strands)
+{
+    uint64_t hash = HashWords(std::span<const uint32_t>(strands.strandPointCounts));
+    hash = HashWords(std::span<const float>(strands.pointsX), hash);
+    hash = HashWords(std::span<const float>(strands.pointsY), hash);
+    return HashWords(std::span<const float>(strands.pointsZ), hash);
+}
+
+void HairStageCache::StoreSource(const ModelCreation& modelCreation)
+{
+    // Hair is generated from the strands alone, so the line geometry isn't kept
+    _source = {};
+    _source.sceneGraph = modelCreation.sceneGraph->Clone();
+    _source.strandBuffers = modelCreation.strandBuffers;
+
+    _sourceKeys.clear();
+    for (const StrandBuffer& strands : _source.strandBuffers)
+    {
+        _sourceKeys.push_back(HashStrands(strands));
+    }
+}
+
+ModelCreation HairStageCache::Source() const
+{
+    ModelCreation modelCreation {};
+    modelCreation.sceneGraph = _source.sceneGraph->Clone();
+    modelCreation.strandBuffers = _source.strandBuffers;
+    return modelCreation;
+}
+
+const StrandBuffer& HairStageCache::ResampledStrands(uint32_t meshIndex, const StrandBuffer& sourceStrands, float maxStrandDeviation, JobSystem& jobSystem)
+{
+    MeshStages& stages = _meshes[meshIndex];
 
-        // Create curves from lines
-        const std::vector<Curve> curves = GenerateCurves(lines);
-        newModelCreation.curveBuffer.insert(newModelCreation.curveBuffer.end(), curves.begin(), curves.end());
+    // Hashing the source strands again would take about as long as reading them, so only the key stored with the source is used
+    const uint32_t parameters[] = { std::bit_cast<uint32_t>(maxStrandDeviation) };
+    const std::optional<uint64_t> key = HasSource() ? std::optional(HashWords(std::span<const uint32_t>(parameters), _sourceKeys[meshIndex])) : std::nullopt;
+    if (!key.has_value() || key.value() != stages.resampledKey)
+    {
+        stages.resampledStrands = ResampleStrands(sourceStrands, maxStrandDeviation, jobSystem);
+        stages.resampledKey = key.value_or(0);
+    }
+    else
+    {
+        spdlog::info("[GEOMETRY PROCESSOR] Reusing resampled hair strands of mesh {}", meshIndex);
+    }
 
-        // Create aabb's from curves
-        constexpr float hairCurveRadius = 0.02f;
-        const std::vector<AABB> aabbs = GenerateAABBs(curves, hairCurveRadius);
-        newModelCreation.aabbBuffer.insert(newModelCreation.aabbBuffer.end(), aabbs.begin(), aabbs.end());
+    return stages.resampledStrands;
+}
+
+const std::vector<StrandBuffer>& HairStageCache::StrandLODs(uint32_t meshIndex, JobSystem& jobSystem)
+{
+    MeshStages& stages = _meshes[meshIndex];
 
-        // Update hair information
-        hair.curveCount = curves.size();
-        hair.aabbCount = aabbs.size();
+    // The level ratios are constants, but are part of the key so tuning them invalidates the levels as well
+    uint64_t key = HashWords(std::span<const float>(LOD_SEGMENT_RATIOS), stages.resampledKey);
+    key = HashWords(std::span<const float>(LOD_STRAND_RATIOS), key);
+    if (!HasSource() || key != stages.lodKey)
+    {
+        stages.lodStrands = GenerateStrandLODs(OrderStrands(stages.resampledStrands, jobSystem), jobSystem);
+        stages.lodKey = key;
     }
+    else
+    {
+        spdlog::info("[GEOMETRY PROCESSOR] Reusing hair levels of detail of mesh {}", meshIndex);
+    }
+
+    return stages.lodStrands;
+}
+
+void HairStageCache::ReleaseResampledStrands(uint32_t meshIndex)
+{
+    _meshes[meshIndex].resampledKey = 0;
+    _meshes[meshIndex].resampledStrands = {};
+}
+
 
-    // Update scene graph to use hair
+// Hair replaces the line meshes it was generated from in every node, since models with mixed hair and mesh geometry aren't supported for now
+void MoveNodeGeometry(SceneGraph& sceneGraph, std::vector<uint32_t> Node::* geometry)
+{
     sceneGraph.meshes.clear();
 
     for (Node& node : sceneGraph.nodes)
     {
-        node.hairs = node.meshes; // Since we don't support models with mixed hair and mesh geometry for now, we just copy the information
+        node.*geometry = std::move(node.meshes);
         node.meshes.clear();
     }
-
-    return newModelCreation;
 }
 
-ModelCreation ProcessHairDOTS(const ModelCreation& modelCreation)
+// Strands a single output of a hair representation is generated from
+struct HairLevel
 {
-    const auto it = std::find_if(modelCreation.sceneGraph->meshes.begin(), modelCreation.sceneGraph->meshes.end(), [](const Mesh& mesh)
-        { return mesh.primitiveType != Mesh::PrimitiveType::eLines; });
-    if (it != modelCreation.sceneGraph->meshes.end())
+    uint32_t meshIndex {};
+    uint32_t level {};
+    float radiusScale = 1.0f;
+
+    // Levels view the strands of the stage cache, pruned levels only the first strands of the coarsest segment level, until they get their own
+    StrandBuffer strands {};
+    const StrandBuffer* viewedStrands = nullptr;
+    uint32_t viewedStrandCount {};
+
+    [[nodiscard]] bool Pruned() const { return level >= LOD_SEGMENT_LEVEL_COUNT; }
+    [[nodiscard]] StrandPrefix Strands() const { return viewedStrands ? StrandPrefix(*viewedStrands, viewedStrandCount) : StrandPrefix(strands); }
+
+    void ReplaceStrands(StrandBuffer newStrands)
     {
-        spdlog::error("[GEOMETRY PROCESSOR] Model \"{}\" contains multiple different mesh primitive types while trying to generate hair model!", modelCreation.sceneGraph->sceneName);
-        return modelCreation;
+        strands = std::move(newStrands);
+        viewedStrands = nullptr;
     }
+};
 
-    ModelCreation newModelCreation {};
-    newModelCreation.sceneGraph = modelCreation.sceneGraph;
-    SceneGraph& sceneGraph = *newModelCreation.sceneGraph;
+// Representations plan the buffer sizes of all their outputs before emitting them into the slots they got assigned, see ProcessHair.
+// Outputs are planned and emitted in parallel, so both may only touch the state of their own output.
+template <typename T>
+concept HairRepresentation = std::constructible_from<T, SceneGraph&, uint32_t, const HairSettings&>
+    && requires(T representation, uint32_t output, HairLevel& level, const MeshOutputSlots& slots, ModelCreation& modelCreation, JobSystem& jobSystem) {
+           { T::NAME } -> std::convertible_to<std::string_view>;
+           { T::GENERATE_LODS } -> std::convertible_to<bool>;
+           { representation.Plan(output, level, jobSystem) } -> std::same_as<MeshBufferSizes>;
+           representation.Emit(output, level, slots, jobSystem);
+           representation.Finish(modelCreation);
+       };
+
+// Aabb's around (parts of) curves fitted through the strands, intersected by the curve intersection shader
+class CurveHair
+{
+public:
+    static constexpr std::string_view NAME = "curves";
+    static constexpr bool GENERATE_LODS = true;
+
+    // Set to 1 to bound every curve with a single aabb
+    static constexpr uint32_t MAX_SPLITS = 4;
+
+    CurveHair(SceneGraph& sceneGraph, uint32_t outputCount, const HairSettings& settings)
+        : _sceneGraph(sceneGraph)
+        , _settings(settings)
+        , _chunks(outputCount)
+        , _splitCodes(outputCount)
+        , _quantizationErrors(outputCount)
+        , _controlPointSurfaceAreas(outputCount)
+    {
+        _sceneGraph.hairs.resize(outputCount);
+    }
+
+    MeshBufferSizes Plan(uint32_t output, HairLevel& level, JobSystem& jobSystem)
+    {
+        const StrandPrefix strands = level.Strands();
+        const float curveRadius = _settings.radius * level.radiusScale;
+
+        // The amount of aabb's depends on how the curves get split, so the curves are fitted once for counting and once more when emitting.
+        // Fitting is cheap compared to searching for splits, which is only done here.
+        std::vector<CurveSplitCode>& splitCodes = _splitCodes[output];
+        splitCodes.resize(MAX_SPLITS > 1 ? strands.SegmentCount() : 0);
+
+        _chunks[output] = CountChunkOutputs(strands.StrandCount(), STRAND_CHUNK_SIZE, jobSystem, [&](uint32_t begin, uint32_t end)
+            {
+                CountCurveSplits countSplits { curveRadius, MAX_SPLITS, splitCodes };
+                FuseCurveStages(strands, begin, end, countSplits);
+                return countSplits.count; });
+
+        MeshBufferSizes sizes {};
+        sizes.firstCurvePrimitive = _chunks[output].outputCount;
+        sizes.firstAabb = _chunks[output].outputCount;
+
+        // Only segment levels store curves, pruned levels share them with the coarsest segment level
+        if (!level.Pruned())
+        {
+            sizes.firstCurve = strands.SegmentCount();
+            sizes.firstCurveStrand = strands.StrandCount();
+        }
+
+        const Mesh& oldMesh = _sceneGraph.meshes[level.meshIndex];
+        Hair& hair = _sceneGraph.hairs[output];
+        hair.material = oldMesh.material;
+        hair.boundingBox = oldMesh.boundingBox;
+        hair.curveRadius = curveRadius;
+        hair.curveCount = strands.SegmentCount();
+        hair.strandCount = strands.StrandCount();
+        hair.aabbCount = sizes.firstAabb;
 
-    std::vector<Mesh> newMeshes(sceneGraph.meshes.size());
+        return sizes;
+    }
 
-    for (uint32_t meshIndex = 0; meshIndex < sceneGraph.meshes.size(); ++meshIndex)
+    void Emit(uint32_t output, const HairLevel& level, const MeshOutputSlots& slots, JobSystem& jobSystem)
     {
-        const Mesh& oldMesh = sceneGraph.meshes[meshIndex];
+        const StrandPrefix strands = level.Strands();
+        const EmitChunks& chunks = _chunks[output];
+        Hair& hair = _sceneGraph.hairs[output];
+
+        std::vector<CurveQuantizationError> chunkErrors(chunks.firstOutputs.size());
+        std::vector<float> chunkSurfaceAreas(chunks.firstOutputs.size());
+
+        // Curves are fitted, split, bounded and quantized in a single walk over the strands
+        FillChunkOutputs(chunks, jobSystem, [&](uint32_t chunk, uint32_t begin, uint32_t end, uint32_t firstOutput)
+            {
+                EmitCurveSplits emitSplits { hair.curveRadius, MAX_SPLITS, _splitCodes[output], slots.curvePrimitives, slots.aabbs, firstOutput };
+                if (level.Pruned())
+                {
+                    FuseCurveStages(strands, begin, end, emitSplits);
+                    return;
+                }
+
+                QuantizeStrandCurves quantizeCurves { slots.curves, slots.curveStrands };
+                MeasureControlPointArea measureArea { hair.curveRadius };
+                FuseCurveStages(strands, begin, end, emitSplits, quantizeCurves, measureArea);
+
+                chunkErrors[chunk] = quantizeCurves.error;
+                chunkSurfaceAreas[chunk] = measureArea.surfaceArea; });
 
-        // Create line segments from hair lines
-        const std::vector<Line> lines = GenerateLines(oldMesh, modelCreation.vertexBuffer, modelCreation.indexBuffer);
+        hair.clusters = ClusterCurvePrimitives(slots.aabbs, slots.curvePrimitives, jobSystem);
+        hair.firstCurve = slots.offsets.firstCurve;
+        hair.firstStrand = slots.offsets.firstCurveStrand;
+        hair.firstAabb = slots.offsets.firstAabb;
 
-        // Create DOTS mesh from line segments
-        Mesh& newMesh = newMeshes[meshIndex];
-        newMesh = GenerateDisjointOrthogonalTriangleStrips(lines, newModelCreation.vertexBuffer, newModelCreation.indexBuffer, 0.02f);
-        newMesh.material = oldMesh.material;
+        for (const CurveQuantizationError& error : chunkErrors)
+        {
+            _quantizationErrors[output].maxError = std::max(_quantizationErrors[output].maxError, error.maxError);
+            _quantizationErrors[output].maxBound = std::max(_quantizationErrors[output].maxBound, error.maxBound);
+        }
+        _controlPointSurfaceAreas[output] = std::accumulate(chunkSurfaceAreas.begin(), chunkSurfaceAreas.end(), 0.0f);
+
+        _chunks[output] = {};
+        _splitCodes[output] = {};
     }
 
-    // Update geometry information in the model
-    sceneGraph.meshes = newMeshes;
-    return newModelCreation;
-}
+    void Finish(ModelCreation& modelCreation)
+    {
+        const uint32_t meshCount = _sceneGraph.meshes.size();
+        for (uint32_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+        {
+            const Hair& coarsestHair = _sceneGraph.hairs[_sceneGraph.GetLODIndex(meshIndex, LOD_SEGMENT_LEVEL_COUNT - 1, _sceneGraph.hairs.size())];
+            for (uint32_t level = LOD_SEGMENT_LEVEL_COUNT; level < LOD_LEVEL_COUNT; ++level)
+            {
+                Hair& prunedHair = _sceneGraph.hairs[_sceneGraph.GetLODIndex(meshIndex, level, _sceneGraph.hairs.size())];
+                prunedHair.firstCurve = coarsestHair.firstCurve;
+                prunedHair.firstStrand = coarsestHair.firstStrand;
+            }
+        }
+
+        float surfaceArea = 0.0f;
+        for (const AABB& aabb : modelCreation.aabbBuffer)
+        {
+            surfaceArea += SurfaceArea(aabb);
+        }
+
+        const float controlPointSurfaceArea = std::accumulate(_controlPointSurfaceAreas.begin(), _controlPointSurfaceAreas.end(), 0.0f);
+        spdlog::info("[GEOMETRY PROCESSOR] Curve AABB surface area reduced by {:.1f}% ({} to {}), using {} aabb's for {} curves",
+            controlPointSurfaceArea > 0.0f ? (1.0f - surfaceArea / controlPointSurfaceArea) * 100.0f : 0.0f, controlPointSurfaceArea, surfaceArea, modelCreation.aabbBuffer.size(), modelCreation.curveBuffer.size());
+
+        CurveQuantizationError quantizationError {};
+        for (const CurveQuantizationError& error : _quantizationErrors)
+        {
+            quantizationError.maxError = std::max(quantizationError.maxError, error.maxError);
+            quantizationError.maxBound = std::max(quantizationError.maxBound, error.maxBound);
+        }
+        spdlog::info("[GEOMETRY PROCESSOR] Quantized {} curves of {} strands to 16 bit offsets ({} to {} bytes), max control point error {} (bound {})",
+            modelCreation.curveBuffer.size(), modelCreation.curveStrandBuffer.size(), modelCreation.curveBuffer.size() * sizeof(Curve),
+            modelCreation.curveBuffer.size() * sizeof(QuantizedCurve) + modelCreation.curveStrandBuffer.size() * sizeof(CurveStrand), quantizationError.maxError, quantizationError.maxBound);
+
+        MoveNodeGeometry(_sceneGraph, &Node::hairs);
+    }
+
+private:
+    SceneGraph& _sceneGraph;
+    HairSettings _settings;
+    std::vector<EmitChunks> _chunks;
+    std::vector<std::vector<CurveSplitCode>> _splitCodes;
+    std::vector<CurveQuantizationError> _quantizationErrors; // Only segment levels quantize curves
+    std::vector<float> _controlPointSurfaceAreas;
+};
 
-ModelCreation ProcessHairVoxels(const ModelCreation& modelCreation)
+// Disjoint orthogonal triangle strips along every strand, traced as regular triangle geometry
+class DOTSHair
 {
-    const auto it = std::find_if(modelCreation.sceneGraph->meshes.begin(), modelCreation.sceneGraph->meshes.end(), [](const Mesh& mesh)
-        { return mesh.primitiveType != Mesh::PrimitiveType::eLines; });
-    if (it != modelCreation.sceneGraph->meshes.end())
+public:
+    static constexpr std::string_view NAME = "DOTS";
+    static constexpr bool GENERATE_LODS = true;
+
+    DOTSHair(SceneGraph& sceneGraph, uint32_t outputCount, const HairSettings& settings)
+        : _sceneGraph(sceneGraph)
+        , _settings(settings)
+        , _meshes(outputCount)
     {
-        spdlog::error("[GEOMETRY PROCESSOR] Model \"{}\" contains multiple different mesh primitive types while trying to generate hair model!", modelCreation.sceneGraph->sceneName);
-        return modelCreation;
     }
 
-    ModelCreation newModelCreation {};
-    newModelCreation.sceneGraph = modelCreation.sceneGraph;
-    SceneGraph& sceneGraph = *newModelCreation.sceneGraph;
+    MeshBufferSizes Plan(uint32_t output, HairLevel& level, JobSystem& jobSystem)
+    {
+        // Cluster by strand so the strips stay connected, the radius is part of the vertices so pruned levels get their own copy of the strands
+        std::vector<GeometryCluster> clusters {};
+        level.ReplaceStrands(ClusterStrands(level.Strands(), DOTS_TRIANGLES_PER_SEGMENT, clusters, jobSystem));
+
+        Mesh& mesh = _meshes[output];
+        mesh.clusters = DOTSClusters(level.strands, clusters);
+        mesh.material = _sceneGraph.meshes[level.meshIndex].material;
+
+        return DOTSBufferSizes(level.strands);
+    }
+
+    void Emit(uint32_t output, const HairLevel& level, const MeshOutputSlots& slots, JobSystem& jobSystem)
+    {
+        const Mesh strips = GenerateDisjointOrthogonalTriangleStrips(level.Strands(), slots.quantizedVertices, slots.indices, slots.offsets.firstQuantizedVertex, jobSystem, _settings.radius * level.radiusScale);
+
+        Mesh& mesh = _meshes[output];
+        mesh.firstIndex = slots.offsets.firstIndex;
+        mesh.indexCount = strips.indexCount;
+        mesh.firstVertex = slots.offsets.firstQuantizedVertex;
+        mesh.vertexFormat = strips.vertexFormat;
+        mesh.boundingBox = strips.boundingBox;
+    }
+
+    void Finish(ModelCreation&)
+    {
+        _sceneGraph.meshes = std::move(_meshes);
+    }
+
+private:
+    SceneGraph& _sceneGraph;
+    HairSettings _settings;
+    std::vector<Mesh> _meshes;
+};
 
-    for (int meshIndex = 0; meshIndex < sceneGraph.meshes.size(); ++meshIndex)
+// Linear swept spheres through the strand points, pruned levels only store radii and share the rest with the coarsest segment level
+class LSSHair
+{
+public:
+    static constexpr std::string_view NAME = "LSS";
+    static constexpr bool GENERATE_LODS = true;
+
+    LSSHair(SceneGraph& sceneGraph, uint32_t outputCount, const HairSettings& settings)
+        : _sceneGraph(sceneGraph)
+        , _settings(settings)
     {
-        const Mesh& oldMesh = sceneGraph.meshes[meshIndex];
+        _sceneGraph.lssMeshes.resize(outputCount);
+    }
 
-        // Create line segments from hair lines
-        const std::vector<Line> lines = GenerateLines(oldMesh, modelCreation.vertexBuffer, modelCreation.indexBuffer);
+    MeshBufferSizes Plan(uint32_t output, HairLevel& level, JobSystem&)
+    {
+        const StrandPrefix strands = level.Strands();
+        const Mesh& oldMesh = _sceneGraph.meshes[level.meshIndex];
 
-        // Voxelize mesh
-        constexpr float voxelSize = 0.1f;
-        constexpr float hairRadius = 0.02f;
+        LSSMesh& lssMesh = _sceneGraph.lssMeshes[output];
+        lssMesh.material = oldMesh.material;
+        lssMesh.boundingBox = oldMesh.boundingBox;
 
-        VoxelMesh& newMesh = sceneGraph.voxelMeshes.emplace_back();
-        newMesh = GenerateVoxelMesh(lines, oldMesh.boundingBox, hairRadius, voxelSize, newModelCreation.voxelGridBuffer);
-        newMesh.material = oldMesh.material;
-        newMesh.firstAabb = newModelCreation.aabbBuffer.size();
+        if (!level.Pruned())
+        {
+            return LSSBufferSizes(strands);
+        }
 
-        // Generate debug AABBs
-        const std::vector<AABB> aabbs = GenerateAABBs(newMesh, newModelCreation.voxelGridBuffer, voxelSize);
-        newModelCreation.aabbBuffer.insert(newModelCreation.aabbBuffer.end(), aabbs.begin(), aabbs.end());
+        lssMesh.vertexCount = strands.PointCount();
+        lssMesh.indexCount = strands.SegmentCount();
 
-        // Update hair information
-        newMesh.aabbCount = aabbs.size();
+        MeshBufferSizes sizes {};
+        sizes.firstLssRadius = strands.PointCount();
+        return sizes;
     }
 
-    // Update scene graph to use hair
-    sceneGraph.meshes.clear();
+    void Emit(uint32_t output, const HairLevel& level, const MeshOutputSlots& slots, JobSystem& jobSystem)
+    {
+        const float radius = _settings.radius * level.radiusScale;
 
-    for (Node& node : sceneGraph.nodes)
+        LSSMesh& lssMesh = _sceneGraph.lssMeshes[output];
+        lssMesh.firstVertex = slots.offsets.firstLssVertex;
+        lssMesh.firstRadius = slots.offsets.firstLssRadius;
+        lssMesh.firstIndex = slots.offsets.firstLssIndex;
+
+        if (level.Pruned())
+        {
+            std::fill(slots.lssRadii.begin(), slots.lssRadii.end(), glm::max(radius, 0.001f));
+            return;
+        }
+
+        const LSSMesh spheres = GenerateLinearSweptSpheres(level.Strands(), slots.lssPositions, slots.lssRadii, slots.lssIndices, jobSystem, radius);
+        lssMesh.vertexCount = spheres.vertexCount;
+        lssMesh.indexCount = spheres.indexCount;
+    }
+
+    void Finish(ModelCreation&)
     {
-        node.voxelMeshes = node.meshes; // Since we don't support models with mixed voxel meshes and mesh geometry for now, we just copy the information
-        node.meshes.clear();
+        const uint32_t meshCount = _sceneGraph.meshes.size();
+        for (uint32_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+        {
+            const LSSMesh& coarsestMesh = _sceneGraph.lssMeshes[_sceneGraph.GetLODIndex(meshIndex, LOD_SEGMENT_LEVEL_COUNT - 1, _sceneGraph.lssMeshes.size())];
+            for (uint32_t level = LOD_SEGMENT_LEVEL_COUNT; level < LOD_LEVEL_COUNT; ++level)
+            {
+                LSSMesh& prunedMesh = _sceneGraph.lssMeshes[_sceneGraph.GetLODIndex(meshIndex, level, _sceneGraph.lssMeshes.size())];
+                prunedMesh.firstVertex = coarsestMesh.firstVertex;
+                prunedMesh.firstIndex = coarsestMesh.firstIndex;
+            }
+        }
+
+        MoveNodeGeometry(_sceneGraph, &Node::lssMeshes);
     }
 
-    return newModelCreation;
-}
+private:
+    SceneGraph& _sceneGraph;
+    HairSettings _settings;
+};
 
-ModelCreation ProcessHairLSS(const ModelCreation& modelCreation)
+// Sparse voxel grid around every mesh with the strands voxelized as capsules, plus an occupancy pyramid down to a single voxel.
+// Every level gets a debug aabb for each filled voxel, so the renderer can switch to coarser levels by distance.
+// How many bricks and voxels end up filled is only known after voxelizing, so planning voxelizes and emitting copies the result into the slots.
+class VoxelHair
 {
-    const auto it = std::find_if(modelCreation.sceneGraph->meshes.begin(), modelCreation.sceneGraph->meshes.end(), [](const Mesh& mesh)
-        { return mesh.primitiveType != Mesh::PrimitiveType::eLines; });
-    if (it != modelCreation.sceneGraph->meshes.end())
+public:
+    static constexpr std::string_view NAME = "voxels";
+    static constexpr bool GENERATE_LODS = false;
+
+    VoxelHair(SceneGraph& sceneGraph, uint32_t outputCount, const HairSettings& settings)
+        : _sceneGraph(sceneGraph)
+        , _settings(settings)
+        , _pyramids(outputCount)
     {
-        spdlog::error("[GEOMETRY PROCESSOR] Model \"{}\" contains multiple different mesh primitive types while trying to generate hair model!", modelCreation.sceneGraph->sceneName);
-        return modelCreation;
+        _sceneGraph.voxelMeshes.resize(outputCount);
     }
 
-    ModelCreation newModelCreation {};
-    newModelCreation.sceneGraph = modelCreation.sceneGraph;
-    SceneGraph& sceneGraph = *newModelCreation.sceneGraph;
+    MeshBufferSizes Plan(uint32_t output, HairLevel& level, JobSystem& jobSystem)
+    {
+        const Mesh& oldMesh = _sceneGraph.meshes[level.meshIndex];
+
+        VoxelMesh& voxelMesh = _sceneGraph.voxelMeshes[output];
+        voxelMesh = CreateVoxelGrid(oldMesh.boundingBox, _settings.voxelSize);
+        voxelMesh.material = oldMesh.material;
+
+        std::vector<VoxelBrickMap>& pyramid = _pyramids[output];
+        VoxelBrickMap& voxels = pyramid.emplace_back(voxelMesh.voxelGridResolution);
+        VoxelizeStrands(level.Strands(), _settings.radius, _settings.voxelSize, _settings.voxelization, voxelMesh, voxels, jobSystem);
+
+        if (_settings.voxelization == VoxelizationMode::eExact && _settings.reportVoxelReduction)
+        {
+            // Voxelizes the boxes again, to report how many voxels the exact test leaves empty
+            VoxelBrickMap boxVoxels { voxelMesh.voxelGridResolution };
+            VoxelizeStrands(level.Strands(), _settings.radius, _settings.voxelSize, VoxelizationMode::eConservativeBox, voxelMesh, boxVoxels, jobSystem);
+
+            const uint32_t filledCount = voxels.FilledCount();
+            const uint32_t boxFilledCount = boxVoxels.FilledCount();
+            spdlog::info("[GEOMETRY PROCESSOR] Exact voxelization filled {} voxels instead of {} ({:.1f}% fewer)", filledCount, boxFilledCount,
+                boxFilledCount == 0 ? 0.0f : 100.0f * static_cast<float>(boxFilledCount - filledCount) / static_cast<float>(boxFilledCount));
+        }
+
+        // Halve the resolution until a single voxel covers the whole grid
+        for (glm::ivec3 resolution = voxels.Resolution(); resolution.x > 1 || resolution.y > 1 || resolution.z > 1; resolution = pyramid.back().Resolution())
+        {
+            // Downsampled before the pyramid grows, since growing can move the level it reads from
+            VoxelBrickMap coarser = pyramid.back().Downsample(jobSystem);
+            pyramid.emplace_back(std::move(coarser));
+        }
+
+        MeshBufferSizes sizes {};
+        size_t memorySize = 0;
+        for (uint32_t i = 0; i < pyramid.size(); ++i)
+        {
+            VoxelLevel& voxelLevel = voxelMesh.levels.emplace_back();
+            voxelLevel.resolution = pyramid[i].Resolution();
+            voxelLevel.voxelSize = _settings.voxelSize * static_cast<float>(1u << i);
+            voxelLevel.brickCount = pyramid[i].Bricks().size();
+            voxelLevel.filledVoxelCount = pyramid[i].FilledCount();
+            voxelLevel.aabbCount = voxelLevel.filledVoxelCount;
+
+            sizes.firstVoxelBrickIndex += pyramid[i].BrickIndices().size();
+            sizes.firstVoxelBrick += voxelLevel.brickCount;
+            sizes.firstAabb += voxelLevel.aabbCount;
+            memorySize += pyramid[i].MemorySize();
+        }
 
-    sceneGraph.lssMeshes.resize(sceneGraph.meshes.size());
+        spdlog::info("[GEOMETRY PROCESSOR] Sparse voxels take {} KiB in {} bricks over {} levels, a dense grid would take {} KiB for the first level", memorySize / 1024,
+            sizes.firstVoxelBrick, pyramid.size(), VoxelOccupancyGrid::WordCount(voxelMesh.voxelGridResolution) * sizeof(uint64_t) / 1024);
 
-    for (uint32_t meshIndex = 0; meshIndex < sceneGraph.meshes.size(); ++meshIndex)
+        return sizes;
+    }
+
+    void Emit(uint32_t output, const HairLevel&, const MeshOutputSlots& slots, JobSystem&)
     {
-        const Mesh& oldMesh = sceneGraph.meshes[meshIndex];
+        VoxelMesh& voxelMesh = _sceneGraph.voxelMeshes[output];
+        const std::vector<VoxelBrickMap>& pyramid = _pyramids[output];
 
-        // Create line segments from hair lines
-        const std::vector<Line> lines = GenerateLines(oldMesh, modelCreation.vertexBuffer, modelCreation.indexBuffer);
+        // Levels follow each other in every buffer slot
+        MeshBufferOffsets levelOffsets {};
+        for (uint32_t i = 0; i < pyramid.size(); ++i)
+        {
+            const VoxelBrickMap& voxels = pyramid[i];
+            VoxelLevel& voxelLevel = voxelMesh.levels[i];
 
-        // Create LSS mesh from line segments
-        LSSMesh& lssMesh = sceneGraph.lssMeshes[meshIndex];
-        lssMesh = GenerateLinearSweptSpheres(lines, newModelCreation.lssPositionBuffer, newModelCreation.lssRadiusBuffer, 0.02f);
-        lssMesh.material = oldMesh.material;
+            GenerateAABBs(voxelMesh.boundingBox.min, voxels, voxelLevel.voxelSize, slots.aabbs.subspan(levelOffsets.firstAabb, voxelLevel.aabbCount));
+            std::ranges::copy(voxels.BrickIndices(), slots.voxelBrickIndices.begin() + levelOffsets.firstVoxelBrickIndex);
+            std::ranges::copy(voxels.Bricks(), slots.voxelBricks.begin() + levelOffsets.firstVoxelBrick);
+
+            voxelLevel.firstBrickIndex = slots.offsets.firstVoxelBrickIndex + levelOffsets.firstVoxelBrickIndex;
+            voxelLevel.firstBrick = slots.offsets.firstVoxelBrick + levelOffsets.firstVoxelBrick;
+            voxelLevel.firstAabb = slots.offsets.firstAabb + levelOffsets.firstAabb;
+
+            levelOffsets.firstVoxelBrickIndex += voxels.BrickIndices().size();
+            levelOffsets.firstVoxelBrick += voxelLevel.brickCount;
+            levelOffsets.firstAabb += voxelLevel.aabbCount;
+        }
+
+        _pyramids[output] = {};
     }
 
-    // Update scene graph to use lss
-    sceneGraph.meshes.clear();
+    void Finish(ModelCreation&)
+    {
+        MoveNodeGeometry(_sceneGraph, &Node::voxelMeshes);
+    }
 
-    for (Node& node : sceneGraph.nodes)
+private:
+    SceneGraph& _sceneGraph;
+    HairSettings _settings;
+    std::vector<std::vector<VoxelBrickMap>> _pyramids {}; // Per output, from planning until it is emitted
+};
+
+// Debug tubes swept along curves fitted through the strands
+class TubeHair
+{
+public:
+    static constexpr std::string_view NAME = "tubes";
+    static constexpr bool GENERATE_LODS = false;
+
+    static constexpr uint32_t CURVE_SAMPLES = std::max(3u, MIN_TUBE_CURVE_SAMPLES);
+    static constexpr uint32_t RADIAL_SAMPLES = std::max(3u, MIN_TUBE_RADIAL_SAMPLES);
+
+    TubeHair(SceneGraph& sceneGraph, uint32_t outputCount, const HairSettings& settings)
+        : _sceneGraph(sceneGraph)
+        , _settings(settings)
+        , _meshes(outputCount)
     {
-        node.lssMeshes = node.meshes; // Since we don't support models with mixed hair and mesh geometry for now, we just copy the information
-        node.meshes.clear();
+        for (uint32_t j = 0; j < RADIAL_SAMPLES; ++j)
+        {
+            const float theta = (2.0f * glm::pi<float>() * j) / static_cast<float>(RADIAL_SAMPLES);
+            _ringDirections[j] = glm::vec2(glm::cos(theta), glm::sin(theta));
+        }
     }
 
-    return newModelCreation;
-}
+    MeshBufferSizes Plan(uint32_t, HairLevel& level, JobSystem&)
+    {
+        return TubeBufferSizes(level.Strands(), CURVE_SAMPLES, RADIAL_SAMPLES);
+    }
+
+    void Emit(uint32_t output, const HairLevel& level, const MeshOutputSlots& slots, JobSystem& jobSystem)
+    {
+        const StrandPrefix strands = level.Strands();
+
+        // Vertices are quantized against the bounds, so these are found in a pass before the tubes are swept
+        std::vector<AABB> chunkBounds((strands.StrandCount() + STRAND_CHUNK_SIZE - 1) / STRAND_CHUNK_SIZE);
+        ForEachChunk(strands.StrandCount(), STRAND_CHUNK_SIZE, jobSystem, [&](uint32_t chunk, uint32_t begin, uint32_t end)
+            {
+                BoundControlPoints boundControlPoints {};
+                FuseCurveStages(strands, begin, end, boundControlPoints);
+                chunkBounds[chunk] = boundControlPoints.bounds; });
+
+        AABB bounds = BoundControlPoints {}.bounds;
+        for (const AABB& chunk : chunkBounds)
+        {
+            bounds.min = glm::min(bounds.min, chunk.min);
+            bounds.max = glm::max(bounds.max, chunk.max);
+        }
+
+        Mesh& mesh = _meshes[output];
+        mesh.vertexFormat = Mesh::VertexFormat::eQuantized;
+        mesh.boundingBox = AABB { bounds.min - _settings.radius, bounds.max + _settings.radius };
+        mesh.firstIndex = slots.offsets.firstIndex;
+        mesh.indexCount = slots.indices.size();
+        mesh.firstVertex = slots.offsets.firstQuantizedVertex;
+        mesh.material = _sceneGraph.meshes[level.meshIndex].material;
 
-ModelCreation ProcessHairDebugMesh(const ModelCreation& modelCreation)
+        ForEachChunk(strands.StrandCount(), STRAND_CHUNK_SIZE, jobSystem, [&](uint32_t, uint32_t begin, uint32_t end)
+            {
+                EmitTubes emitTubes { slots.quantizedVertices, slots.indices, slots.offsets.firstQuantizedVertex, mesh.boundingBox, _settings.radius, CURVE_SAMPLES, _ringDirections };
+                FuseCurveStages(strands, begin, end, emitTubes); });
+    }
+
+    void Finish(ModelCreation&)
+    {
+        _sceneGraph.meshes = std::move(_meshes);
+    }
+
+private:
+    SceneGraph& _sceneGraph;
+    HairSettings _settings;
+    std::vector<Mesh> _meshes;
+    std::array<glm::vec2, RADIAL_SAMPLES> _ringDirections {};
+};
+
+// Shared pipeline of all hair representations. The strands of every mesh are resampled and, for representations with levels of detail,
+// ordered and reduced into levels. These stages go through the stage cache, which is only kept for this call when none is given.
+// Every output is planned first, so the model buffers are allocated once and all outputs are emitted straight into their slots in parallel.
+template <HairRepresentation Representation>
+ModelCreation ProcessHair(ModelCreation&& modelCreation, JobSystem& jobSystem, const HairSettings& requestedSettings, HairStageCache* stageCache)
 {
-    const auto it = std::find_if(modelCreation.sceneGraph->meshes.begin(), modelCreation.sceneGraph->meshes.end(), [](const Mesh& mesh)
-        { return mesh.primitiveType != Mesh::PrimitiveType::eLines; });
-    if (it != modelCreation.sceneGraph->meshes.end())
+    if (!ValidateHairModel(modelCreation))
     {
-        spdlog::error("[GEOMETRY PROCESSOR] Model \"{}\" contains multiple different mesh primitive types while trying to generate hair model!", modelCreation.sceneGraph->sceneName);
-        return modelCreation;
+        return std::move(modelCreation);
     }
 
+    const HairSettings settings = ValidateHairSettings(requestedSettings);
+
+    ReleaseLineGeometry(modelCreation);
+
     ModelCreation newModelCreation {};
     newModelCreation.sceneGraph = modelCreation.sceneGraph;
     SceneGraph& sceneGraph = *newModelCreation.sceneGraph;
 
-    std::vector<Mesh> newMeshes(sceneGraph.meshes.size());
+    const uint32_t meshCount = sceneGraph.meshes.size();
+    const uint32_t levelCount = Representation::GENERATE_LODS ? LOD_LEVEL_COUNT : 1;
+    const uint32_t outputCount = meshCount * levelCount;
+    sceneGraph.lodLevelCount = levelCount;
 
-    for (int meshIndex = 0; meshIndex < sceneGraph.meshes.size(); ++meshIndex)
-    {
-        const Mesh& oldMesh = sceneGraph.meshes[meshIndex];
+    HairStageCache transientCache {};
+    HairStageCache& cache = stageCache ? *stageCache : transientCache;
+    cache.SetMeshCount(meshCount);
 
-        // Create line segments from hair lines
-        const std::vector<Line> lines = GenerateLines(oldMesh, modelCreation.vertexBuffer, modelCreation.indexBuffer);
+    Representation representation { sceneGraph, outputCount, settings };
+    std::vector<HairLevel> levels(outputCount);
+    std::vector<MeshBufferSizes> outputSizes(outputCount);
 
-        // Create curves from lines
-        const std::vector<Curve> curves = GenerateCurves(lines);
+    Timer timer {};
 
-        // Create mesh from curve segments
-        Mesh& newMesh = newMeshes[meshIndex];
-        newMesh = GenerateMeshGeometryTubes(curves, newModelCreation.vertexBuffer, newModelCreation.indexBuffer, 0.02f, 3, 3);
-        newMesh.material = oldMesh.material;
-    }
+    jobSystem.ParallelFor(meshCount, 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t meshIndex = begin; meshIndex < end; ++meshIndex)
+            {
+                // The loaded strands aren't needed anymore once they are resampled
+                const StrandBuffer& strands = cache.ResampledStrands(meshIndex, modelCreation.strandBuffers[meshIndex], settings.maxStrandDeviation, jobSystem);
+                modelCreation.strandBuffers[meshIndex] = {};
+
+                if constexpr (Representation::GENERATE_LODS)
+                {
+                    const std::vector<StrandBuffer>& lodStrands = cache.StrandLODs(meshIndex, jobSystem);
+                    if (!stageCache)
+                    {
+                        cache.ReleaseResampledStrands(meshIndex);
+                    }
+
+                    for (uint32_t level = 0; level < LOD_SEGMENT_LEVEL_COUNT; ++level)
+                    {
+                        HairLevel& hairLevel = levels[sceneGraph.GetLODIndex(meshIndex, level, outputCount)];
+                        hairLevel.meshIndex = meshIndex;
+                        hairLevel.level = level;
+                        hairLevel.viewedStrands = &lodStrands[level];
+                        hairLevel.viewedStrandCount = lodStrands[level].StrandCount();
+                    }
+
+                    // Pruned levels use the first strands of the coarsest segment level
+                    const StrandBuffer& coarsestStrands = lodStrands[LOD_SEGMENT_LEVEL_COUNT - 1];
+                    const std::array<StrandPruning, LOD_STRAND_RATIOS.size()> prunings = ComputeStrandPruning(coarsestStrands);
+
+                    for (uint32_t i = 0; i < prunings.size(); ++i)
+                    {
+                        HairLevel& hairLevel = levels[sceneGraph.GetLODIndex(meshIndex, LOD_SEGMENT_LEVEL_COUNT + i, outputCount)];
+                        hairLevel.meshIndex = meshIndex;
+                        hairLevel.level = LOD_SEGMENT_LEVEL_COUNT + i;
+                        hairLevel.radiusScale = prunings[i].radiusScale;
+                        hairLevel.viewedStrands = &coarsestStrands;
+                        hairLevel.viewedStrandCount = prunings[i].strandCount;
+                    }
+                }
+                else
+                {
+                    levels[meshIndex].meshIndex = meshIndex;
+                    levels[meshIndex].viewedStrands = &strands;
+                    levels[meshIndex].viewedStrandCount = strands.StrandCount();
+                }
+
+                for (uint32_t level = 0; level < levelCount; ++level)
+                {
+                    const uint32_t output = sceneGraph.GetLODIndex(meshIndex, level, outputCount);
+                    outputSizes[output] = representation.Plan(output, levels[output], jobSystem);
+                }
+            }
+        });
+
+    const DeltaMS planTime = timer.GetElapsed();
+    timer.Reset();
+
+    const std::vector<MeshBufferOffsets> offsets = AllocateMeshOutputs(outputSizes, newModelCreation);
+
+    jobSystem.ParallelFor(outputCount, 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t output = begin; output < end; ++output)
+            {
+                representation.Emit(output, levels[output], OutputSlots(newModelCreation, offsets[output], outputSizes[output]), jobSystem);
+            }
+        });
+
+    levels = {};
+    representation.Finish(newModelCreation);
+
+    spdlog::info("[GEOMETRY PROCESSOR] Generated {} for {} meshes, planning took {:.1f} ms and emitting {:.1f} ms",
+        Representation::NAME, meshCount, planTime.count(), timer.GetElapsed().count());
 
-    // Update geometry information in the model
-    sceneGraph.meshes = newMeshes;
     return newModelCreation;
 }
+
+ModelCreation ProcessHairCurves(ModelCreation&& modelCreation, JobSystem& jobSystem, const HairSettings& settings, HairStageCache* stageCache)
+{
+    return ProcessHair<CurveHair>(std::move(modelCreation), jobSystem, settings, stageCache);
+}
+
+ModelCreation ProcessHairDOTS(ModelCreation&& modelCreation, JobSystem& jobSystem, const HairSettings& settings, HairStageCache* stageCache)
+{
+    return ProcessHair<DOTSHair>(std::move(modelCreation), jobSystem, settings, stageCache);
+}
+
+ModelCreation ProcessHairVoxels(ModelCreation&& modelCreation, JobSystem& jobSystem, const HairSettings& settings, HairStageCache* stageCache)
+{
+    return ProcessHair<VoxelHair>(std::move(modelCreation), jobSystem, settings, stageCache);
+}
+
+ModelCreation ProcessHairLSS(ModelCreation&& modelCreation, JobSystem& jobSystem, const HairSettings& settings, HairStageCache* stageCache)
+{
+    return ProcessHair<LSSHair>(std::move(modelCreation), jobSystem, settings, stageCache);
+}
+
+ModelCreation ProcessHairDebugMesh(ModelCreation&& modelCreation, JobSystem& jobSystem, const HairSettings& settings, HairStageCache* stageCache)
+{
+    return ProcessHair<TubeHair>(std::move(modelCreation), jobSystem, settings, stageCache);
+}
+
+ModelCreation ProcessHair(ModelCreation&& modelCreation, JobSystem& jobSystem, HairTechnique technique, const HairSettings& settings, HairStageCache* stageCache)
+{
+    switch (technique)
+    {
+    case HairTechnique::eDOTS:
+        return ProcessHairDOTS(std::move(modelCreation), jobSystem, settings, stageCache);
+    case HairTechnique::eLSS:
+        return ProcessHairLSS(std::move(modelCreation), jobSystem, settings, stageCache);
+    case HairTechnique::eCurves:
+        return ProcessHairCurves(std::move(modelCreation), jobSystem, settings, stageCache);
+    case HairTechnique::eVoxels:
+        return ProcessHairVoxels(std::move(modelCreation), jobSystem, settings, stageCache);
+    case HairTechnique::eTubes:
+        return ProcessHairDebugMesh(std::move(modelCreation), jobSystem, settings, stageCache);
+    }
+
+    return std::move(modelCreation);
+}
+
+VoxelBrickMap VoxelizeHairStrands(const StrandBuffer& strands, const AABB& meshBounds, const HairSettings& requestedSettings, JobSystem& jobSystem)
+{
+    const HairSettings settings = ValidateHairSettings(requestedSettings);
+    const VoxelMesh voxelMesh = CreateVoxelGrid(meshBounds, settings.voxelSize);
+
+    VoxelBrickMap voxels { voxelMesh.voxelGridResolution };
+    VoxelizeStrands(strands, settings.radius, settings.voxelSize, settings.voxelization, voxelMesh, voxels, jobSystem);
+    return voxels;
+}
+
+VoxelOccupancyGrid VoxelizeHairStrandsSerial(const StrandBuffer& strands, const AABB& meshBounds, const HairSettings& requestedSettings)
+{
+    const HairSettings settings = ValidateHairSettings(requestedSettings);
+    const VoxelMesh voxelMesh = CreateVoxelGrid(meshBounds, settings.voxelSize);
+
+    VoxelOccupancyGrid voxels { voxelMesh.voxelGridResolution };
+    VoxelizeStrandRange<false>(strands, 0, strands.StrandCount(), settings.radius, settings.voxelSize, settings.voxelization, voxelMesh, voxels);
+    return voxels;
+}
@@ -1,65 +1,22 @@
 #include "resources/model/model.hpp"
 #include "single_time_commands.hpp"
 #include "vk_common.hpp"
-#include <spdlog/spdlog.h>
-
-glm::mat4 Node::GetWorldMatrix() const
-{
-    glm::mat4 matrix = localMatrix;
-    const Node* p = parent;
-
-    while (p)
-    {
-        matrix = p->localMatrix * matrix;
-        p = p->parent;
-    }
-
-    return matrix;
-}
-
-glm::vec3 Curve::Sample(float t) const
-{
-    float u = 1.0f - t;
-    float tt = t * t;
-    float uu = u * u;
-    float uuu = uu * u;
-    float ttt = tt * t;
-
-    return uuu * start + 3.0f * uu * t * controlPoint1 + 3.0f * u * tt * controlPoint2 + ttt * end;
-}
-
-glm::vec3 Curve::SampleDerivitive(float t) const
-{
-    float u = 1.0f - t;
-    return 3.0f * u * u * (controlPoint1 - start) + 6.0f * u * t * (controlPoint2 - controlPoint1) + 3.0f * t * t * (end - controlPoint2);
-}
-
-uint32_t Mesh::GetIndicesPerFaceNum() const
-{
-    switch (primitiveType)
-    {
-    case PrimitiveType::eTriangles:
-        return 3;
-    case PrimitiveType::eLines:
-        return 2;
-    default:
-        spdlog::error("[MODEL LOADING] Trying to get number of indices per face using unsupported mesh primitive type");
-    }
-
-    return 0;
-}
 
 Model::Model(const ModelCreation& creation, const std::shared_ptr<VulkanContext>& vulkanContext)
     : sceneGraph(creation.sceneGraph)
     , vertexCount(creation.vertexBuffer.size())
+    , quantizedVertexCount(creation.quantizedVertexBuffer.size())
     , indexCount(creation.indexBuffer.size())
     , curveCount(creation.curveBuffer.size())
+    , curveStrandCount(creation.curveStrandBuffer.size())
+    , curvePrimitiveCount(creation.curvePrimitiveBuffer.size())
     , aabbCount(creation.aabbBuffer.size())
+    , voxelBrickIndexCount(creation.voxelBrickIndexBuffer.size())
+    , voxelBrickCount(creation.voxelBrickBuffer.size())
 {
-    if (vertexCount != 0 && indexCount != 0)
+    if (vertexCount != 0)
     {
         const size_t vertexBufferSize = sizeof(Mesh::Vertex) * vertexCount;
-        const size_t indexBufferSize = sizeof(uint32_t) * indexCount;
 
         // Staging buffers
         BufferCreation vertexStagingBufferCreation {};
@@ -71,6 +28,73 @@ Model::Model(const ModelCreation& creation, const std::shared_ptr<VulkanContext>
         Buffer vertexStagingBuffer(vertexStagingBufferCreation, vulkanContext);
         memcpy(vertexStagingBuffer.mappedPtr, creation.vertexBuffer.data(), vertexBufferSize);
 
+        // GPU buffers
+        vk::BufferUsageFlags bufferUsage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+
+        BufferCreation vertexBufferCreation {};
+        vertexBufferCreation.SetName(sceneGraph->sceneName + " - Vertex Buffer")
+            .SetUsageFlags(vk::BufferUsageFlagBits::eVertexBuffer | bufferUsage)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
+            .SetIsMappable(false)
+            .SetSize(vertexBufferSize);
+        vertexBuffer = std::make_unique<Buffer>(vertexBufferCreation, vulkanContext);
+
+        SingleTimeCommands commands(vulkanContext);
+        commands.Record([&](vk::CommandBuffer commandBuffer)
+            { VkCopyBufferToBuffer(commandBuffer, vertexStagingBuffer.buffer, vertexBuffer->buffer, vertexBufferSize); });
+        commands.SubmitAndWait();
+    }
+
+    if (quantizedVertexCount != 0)
+    {
+        const size_t quantizedVertexBufferSize = sizeof(Mesh::QuantizedVertex) * quantizedVertexCount;
+
+        // Staging buffers
+        BufferCreation quantizedVertexStagingBufferCreation {};
+        quantizedVertexStagingBufferCreation.SetName(sceneGraph->sceneName + " - Quantized Vertex Staging Buffer")
+            .SetUsageFlags(vk::BufferUsageFlagBits::eTransferSrc)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_CPU_ONLY)
+            .SetIsMappable(true)
+            .SetSize(quantizedVertexBufferSize);
+        Buffer quantizedVertexStagingBuffer(quantizedVertexStagingBufferCreation, vulkanContext);
+        memcpy(quantizedVertexStagingBuffer.mappedPtr, creation.quantizedVertexBuffer.data(), quantizedVertexBufferSize);
+
+        // Flipping the sign bit maps unorm q onto snorm q - 32768, the renderer adjusts the dequantization to match
+        signedQuantizedVertices = !vulkanContext->IsUnormVertexBuildSupported();
+        if (signedQuantizedVertices)
+        {
+            auto* quantizedVertices = static_cast<Mesh::QuantizedVertex*>(quantizedVertexStagingBuffer.mappedPtr);
+            for (uint32_t i = 0; i < quantizedVertexCount; ++i)
+            {
+                quantizedVertices[i].x ^= 0x8000;
+                quantizedVertices[i].y ^= 0x8000;
+                quantizedVertices[i].z ^= 0x8000;
+            }
+        }
+
+        // GPU buffers
+        vk::BufferUsageFlags bufferUsage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+
+        BufferCreation quantizedVertexBufferCreation {};
+        quantizedVertexBufferCreation.SetName(sceneGraph->sceneName + " - Quantized Vertex Buffer")
+            .SetUsageFlags(bufferUsage)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
+            .SetIsMappable(false)
+            .SetSize(quantizedVertexBufferSize);
+        quantizedVertexBuffer = std::make_unique<Buffer>(quantizedVertexBufferCreation, vulkanContext);
+
+        SingleTimeCommands commands(vulkanContext);
+        commands.Record([&](vk::CommandBuffer commandBuffer)
+            { VkCopyBufferToBuffer(commandBuffer, quantizedVertexStagingBuffer.buffer, quantizedVertexBuffer->buffer, quantizedVertexBufferSize); });
+        commands.SubmitAndWait();
+    }
+
+    // Indices refer to either of the vertex buffers, depending on the vertex format of the mesh
+    if (indexCount != 0)
+    {
+        const size_t indexBufferSize = sizeof(uint32_t) * indexCount;
+
+        // Staging buffers
         BufferCreation indexStagingBufferCreation {};
         indexStagingBufferCreation.SetName(sceneGraph->sceneName + " - Index Staging Buffer")
             .SetUsageFlags(vk::BufferUsageFlagBits::eTransferSrc)
@@ -83,14 +107,6 @@ Model::Model(const ModelCreation& creation, const std::shared_ptr<VulkanContext>
         // GPU buffers
         vk::BufferUsageFlags bufferUsage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress;
 
-        BufferCreation vertexBufferCreation {};
-        vertexBufferCreation.SetName(sceneGraph->sceneName + " - Vertex Buffer")
-            .SetUsageFlags(vk::BufferUsageFlagBits::eVertexBuffer | bufferUsage)
-            .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
-            .SetIsMappable(false)
-            .SetSize(vertexBufferSize);
-        vertexBuffer = std::make_unique<Buffer>(vertexBufferCreation, vulkanContext);
-
         BufferCreation indexBufferCreation {};
         indexBufferCreation.SetName(sceneGraph->sceneName + " - Index Buffer")
             .SetUsageFlags(vk::BufferUsageFlagBits::eIndexBuffer | bufferUsage)
@@ -101,15 +117,14 @@ Model::Model(const ModelCreation& creation, const std::shared_ptr<VulkanContext>
 
         SingleTimeCommands commands(vulkanContext);
         commands.Record([&](vk::CommandBuffer commandBuffer)
-            {
-                VkCopyBufferToBuffer(commandBuffer, vertexStagingBuffer.buffer, vertexBuffer->buffer, vertexBufferSize);
-                VkCopyBufferToBuffer(commandBuffer, indexStagingBuffer.buffer, indexBuffer->buffer, indexBufferSize); });
+            { VkCopyBufferToBuffer(commandBuffer, indexStagingBuffer.buffer, indexBuffer->buffer, indexBufferSize); });
         commands.SubmitAndWait();
     }
 
-    if (curveCount != 0)
+    if (curveCount != 0 && curveStrandCount != 0)
     {
-        const size_t curveBufferSize = sizeof(Curve) * curveCount;
+        const size_t curveBufferSize = sizeof(QuantizedCurve) * curveCount;
+        const size_t curveStrandBufferSize = sizeof(CurveStrand) * curveStrandCount;
 
         // Staging buffers
         BufferCreation curveStagingBufferCreation {};
@@ -121,6 +136,15 @@ Model::Model(const ModelCreation& creation, const std::shared_ptr<VulkanContext>
         Buffer curveStagingBuffer(curveStagingBufferCreation, vulkanContext);
         memcpy(curveStagingBuffer.mappedPtr, creation.curveBuffer.data(), curveBufferSize);
 
+        BufferCreation curveStrandStagingBufferCreation {};
+        curveStrandStagingBufferCreation.SetName(sceneGraph->sceneName + " - Curve Strand Staging Buffer")
+            .SetUsageFlags(vk::BufferUsageFlagBits::eTransferSrc)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_CPU_ONLY)
+            .SetIsMappable(true)
+            .SetSize(curveStrandBufferSize);
+        Buffer curveStrandStagingBuffer(curveStrandStagingBufferCreation, vulkanContext);
+        memcpy(curveStrandStagingBuffer.mappedPtr, creation.curveStrandBuffer.data(), curveStrandBufferSize);
+
         // GPU buffers
         vk::BufferUsageFlags bufferUsage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress;
 
@@ -132,9 +156,48 @@ Model::Model(const ModelCreation& creation, const std::shared_ptr<VulkanContext>
             .SetSize(curveBufferSize);
         curveBuffer = std::make_unique<Buffer>(curveBufferCreation, vulkanContext);
 
+        BufferCreation curveStrandBufferCreation {};
+        curveStrandBufferCreation.SetName(sceneGraph->sceneName + " - Curve Strand Buffer")
+            .SetUsageFlags(bufferUsage)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
+            .SetIsMappable(false)
+            .SetSize(curveStrandBufferSize);
+        curveStrandBuffer = std::make_unique<Buffer>(curveStrandBufferCreation, vulkanContext);
+
+        SingleTimeCommands commands(vulkanContext);
+        commands.Record([&](vk::CommandBuffer commandBuffer)
+            {
+                VkCopyBufferToBuffer(commandBuffer, curveStagingBuffer.buffer, curveBuffer->buffer, curveBufferSize);
+                VkCopyBufferToBuffer(commandBuffer, curveStrandStagingBuffer.buffer, curveStrandBuffer->buffer, curveStrandBufferSize); });
+        commands.SubmitAndWait();
+    }
+
+    if (curvePrimitiveCount != 0)
+    {
+        const size_t curvePrimitiveBufferSize = sizeof(CurvePrimitive) * curvePrimitiveCount;
+
+        BufferCreation curvePrimitiveStagingBufferCreation {};
+        curvePrimitiveStagingBufferCreation.SetName(sceneGraph->sceneName + " - Curve Primitive Staging Buffer")
+            .SetUsageFlags(vk::BufferUsageFlagBits::eTransferSrc)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_CPU_ONLY)
+            .SetIsMappable(true)
+            .SetSize(curvePrimitiveBufferSize);
+        Buffer curvePrimitiveStagingBuffer(curvePrimitiveStagingBufferCreation, vulkanContext);
+        memcpy(curvePrimitiveStagingBuffer.mappedPtr, creation.curvePrimitiveBuffer.data(), curvePrimitiveBufferSize);
+
+        vk::BufferUsageFlags bufferUsage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+
+        BufferCreation curvePrimitiveBufferCreation {};
+        curvePrimitiveBufferCreation.SetName(sceneGraph->sceneName + " - Curve Primitive Buffer")
+            .SetUsageFlags(bufferUsage)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
+            .SetIsMappable(false)
+            .SetSize(curvePrimitiveBufferSize);
+        curvePrimitiveBuffer = std::make_unique<Buffer>(curvePrimitiveBufferCreation, vulkanContext);
+
         SingleTimeCommands commands(vulkanContext);
         commands.Record([&](vk::CommandBuffer commandBuffer)
-            { VkCopyBufferToBuffer(commandBuffer, curveStagingBuffer.buffer, curveBuffer->buffer, curveBufferSize); });
+            { VkCopyBufferToBuffer(commandBuffer, curvePrimitiveStagingBuffer.buffer, curvePrimitiveBuffer->buffer, curvePrimitiveBufferSize); });
         commands.SubmitAndWait();
     }
 
@@ -167,13 +230,67 @@ Model::Model(const ModelCreation& creation, const std::shared_ptr<VulkanContext>
         commands.SubmitAndWait();
     }
 
+    // Sparse voxel occupancy of the voxel meshes, read through the device addresses of their geometry nodes
+    if (voxelBrickIndexCount != 0 && voxelBrickCount != 0)
+    {
+        const size_t voxelBrickIndexBufferSize = sizeof(uint32_t) * voxelBrickIndexCount;
+        const size_t voxelBrickBufferSize = sizeof(VoxelBrick) * voxelBrickCount;
+
+        // Staging buffers
+        BufferCreation voxelBrickIndexStagingBufferCreation {};
+        voxelBrickIndexStagingBufferCreation.SetName(sceneGraph->sceneName + " - Voxel Brick Index Staging Buffer")
+            .SetUsageFlags(vk::BufferUsageFlagBits::eTransferSrc)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_CPU_ONLY)
+            .SetIsMappable(true)
+            .SetSize(voxelBrickIndexBufferSize);
+        Buffer voxelBrickIndexStagingBuffer(voxelBrickIndexStagingBufferCreation, vulkanContext);
+        memcpy(voxelBrickIndexStagingBuffer.mappedPtr, creation.voxelBrickIndexBuffer.data(), voxelBrickIndexBufferSize);
+
+        BufferCreation voxelBrickStagingBufferCreation {};
+        voxelBrickStagingBufferCreation.SetName(sceneGraph->sceneName + " - Voxel Brick Staging Buffer")
+            .SetUsageFlags(vk::BufferUsageFlagBits::eTransferSrc)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_CPU_ONLY)
+            .SetIsMappable(true)
+            .SetSize(voxelBrickBufferSize);
+        Buffer voxelBrickStagingBuffer(voxelBrickStagingBufferCreation, vulkanContext);
+        memcpy(voxelBrickStagingBuffer.mappedPtr, creation.voxelBrickBuffer.data(), voxelBrickBufferSize);
+
+        // GPU buffers
+        vk::BufferUsageFlags bufferUsage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+
+        BufferCreation voxelBrickIndexBufferCreation {};
+        voxelBrickIndexBufferCreation.SetName(sceneGraph->sceneName + " - Voxel Brick Index Buffer")
+            .SetUsageFlags(bufferUsage)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
+            .SetIsMappable(false)
+            .SetSize(voxelBrickIndexBufferSize);
+        voxelBrickIndexBuffer = std::make_unique<Buffer>(voxelBrickIndexBufferCreation, vulkanContext);
+
+        BufferCreation voxelBrickBufferCreation {};
+        voxelBrickBufferCreation.SetName(sceneGraph->sceneName + " - Voxel Brick Buffer")
+            .SetUsageFlags(bufferUsage)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
+            .SetIsMappable(false)
+            .SetSize(voxelBrickBufferSize);
+        voxelBrickBuffer = std::make_unique<Buffer>(voxelBrickBufferCreation, vulkanContext);
+
+        SingleTimeCommands commands(vulkanContext);
+        commands.Record([&](vk::CommandBuffer commandBuffer)
+            {
+                VkCopyBufferToBuffer(commandBuffer, voxelBrickIndexStagingBuffer.buffer, voxelBrickIndexBuffer->buffer, voxelBrickIndexBufferSize);
+                VkCopyBufferToBuffer(commandBuffer, voxelBrickStagingBuffer.buffer, voxelBrickBuffer->buffer, voxelBrickBufferSize); });
+        commands.SubmitAndWait();
+    }
+
     lssPositionCount = creation.lssPositionBuffer.size();
     lssRadiusCount = creation.lssRadiusBuffer.size();
+    lssIndexCount = creation.lssIndexBuffer.size();
 
-    if (lssPositionCount != 0 && lssRadiusCount != 0)
+    if (lssPositionCount != 0 && lssRadiusCount != 0 && lssIndexCount != 0)
     {
         const size_t positionBufferSize = sizeof(glm::vec3) * lssPositionCount;
         const size_t radiusBufferSize = sizeof(float) * lssRadiusCount;
+        const size_t indexBufferSize = sizeof(uint32_t) * lssIndexCount;
 
         // Staging buffers
         BufferCreation positionStagingBufferCreation {};
@@ -194,6 +311,15 @@ Model::Model(const ModelCreation& creation, const std::shared_ptr<VulkanContext>
         Buffer radiusStagingBuffer(radiusStagingBufferCreation, vulkanContext);
         memcpy(radiusStagingBuffer.mappedPtr, creation.lssRadiusBuffer.data(), radiusBufferSize);
 
+        BufferCreation indexStagingBufferCreation {};
+        indexStagingBufferCreation.SetName(sceneGraph->sceneName + " - LSS Index Staging Buffer")
+            .SetUsageFlags(vk::BufferUsageFlagBits::eTransferSrc)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_CPU_ONLY)
+            .SetIsMappable(true)
+            .SetSize(indexBufferSize);
+        Buffer indexStagingBuffer(indexStagingBufferCreation, vulkanContext);
+        memcpy(indexStagingBuffer.mappedPtr, creation.lssIndexBuffer.data(), indexBufferSize);
+
         // GPU buffers
         vk::BufferUsageFlags bufferUsage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress;
 
@@ -213,11 +339,20 @@ Model::Model(const ModelCreation& creation, const std::shared_ptr<VulkanContext>
             .SetSize(radiusBufferSize);
         lssRadiusBuffer = std::make_unique<Buffer>(radiusBufferCreation, vulkanContext);
 
+        BufferCreation indexBufferCreation {};
+        indexBufferCreation.SetName(sceneGraph->sceneName + " - LSS Index Buffer")
+            .SetUsageFlags(bufferUsage)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
+            .SetIsMappable(false)
+            .SetSize(indexBufferSize);
+        lssIndexBuffer = std::make_unique<Buffer>(indexBufferCreation, vulkanContext);
+
         SingleTimeCommands commands(vulkanContext);
         commands.Record([&](vk::CommandBuffer commandBuffer)
             {
                 VkCopyBufferToBuffer(commandBuffer, positionStagingBuffer.buffer, lssPositionBuffer->buffer, positionBufferSize);
-                VkCopyBufferToBuffer(commandBuffer, radiusStagingBuffer.buffer, lssRadiusBuffer->buffer, radiusBufferSize); });
+                VkCopyBufferToBuffer(commandBuffer, radiusStagingBuffer.buffer, lssRadiusBuffer->buffer, radiusBufferSize);
+                VkCopyBufferToBuffer(commandBuffer, indexStagingBuffer.buffer, lssIndexBuffer->buffer, indexBufferSize); });
         commands.SubmitAndWait();
     }
 }
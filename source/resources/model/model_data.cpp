@@ -0,0 +1,111 @@
+#include "resources/model/model.hpp"
+#include <spdlog/spdlog.h>
+
+glm::mat4 Node::GetWorldMatrix() const
+{
+    glm::mat4 matrix = localMatrix;
+    const Node* p = parent;
+
+    while (p)
+    {
+        matrix = p->localMatrix * matrix;
+        p = p->parent;
+    }
+
+    return matrix;
+}
+
+std::shared_ptr<SceneGraph> SceneGraph::Clone() const
+{
+    std::shared_ptr<SceneGraph> clone = std::make_shared<SceneGraph>();
+    clone->sceneName = sceneName;
+    clone->nodes = nodes;
+    clone->meshes = meshes;
+    clone->hairs = hairs;
+    clone->voxelMeshes = voxelMeshes;
+    clone->lssMeshes = lssMeshes;
+    clone->textures = textures;
+    clone->materials = materials;
+    clone->lodLevelCount = lodLevelCount;
+
+    // Parents are stored in the same vector as their children, so they keep their index
+    for (Node& node : clone->nodes)
+    {
+        if (node.parent)
+        {
+            node.parent = &clone->nodes[node.parent - nodes.data()];
+        }
+    }
+
+    return clone;
+}
+
+void StrandBuffer::AddStrand()
+{
+    strandOffsets.push_back(PointCount());
+    strandPointCounts.push_back(0);
+}
+
+void StrandBuffer::AddPoint(const glm::vec3& point)
+{
+    pointsX.push_back(point.x);
+    pointsY.push_back(point.y);
+    pointsZ.push_back(point.z);
+    strandPointCounts.back()++;
+}
+
+uint32_t StrandBuffer::SegmentCount() const
+{
+    uint32_t segmentCount = 0;
+    for (const uint32_t pointCount : strandPointCounts)
+    {
+        segmentCount += pointCount - 1;
+    }
+
+    return segmentCount;
+}
+
+glm::vec3 Curve::Sample(float t) const
+{
+    float u = 1.0f - t;
+    float tt = t * t;
+    float uu = u * u;
+    float uuu = uu * u;
+    float ttt = tt * t;
+
+    return uuu * start + 3.0f * uu * t * controlPoint1 + 3.0f * u * tt * controlPoint2 + ttt * end;
+}
+
+glm::vec3 Curve::SampleDerivitive(float t) const
+{
+    float u = 1.0f - t;
+    return 3.0f * u * u * (controlPoint1 - start) + 6.0f * u * t * (controlPoint2 - controlPoint1) + 3.0f * t * t * (end - controlPoint2);
+}
+
+Curve Curve::Segment(float tMin, float tMax) const
+{
+    // Control points of a sub curve follow from its end points and the derivatives scaled to the new parameter range
+    const float scale = (tMax - tMin) / 3.0f;
+
+    Curve segment {};
+    segment.start = Sample(tMin);
+    segment.end = Sample(tMax);
+    segment.controlPoint1 = segment.start + SampleDerivitive(tMin) * scale;
+    segment.controlPoint2 = segment.end - SampleDerivitive(tMax) * scale;
+    return segment;
+}
+
+uint32_t Mesh::GetIndicesPerFaceNum() const
+{
+    switch (primitiveType)
+    {
+    case PrimitiveType::eTriangles:
+        return 3;
+    case PrimitiveType::eLines:
+        return 2;
+    default:
+        spdlog::error("[MODEL LOADING] Trying to get number of indices per face using unsupported mesh primitive type");
+    }
+
+    return 0;
+}
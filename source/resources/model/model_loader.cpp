@@ -205,6 +205,49 @@ Mesh ProcessMesh(const aiScene* aiScene, const aiMesh* aiMesh, const std::vector
     return mesh;
 }
 
+StrandBuffer ProcessStrands(const aiMesh* aiMesh)
+{
+    StrandBuffer strands {};
+
+    if (GetPrimitiveType(aiMesh) != Mesh::PrimitiveType::eLines)
+    {
+        return strands;
+    }
+
+    strands.pointsX.reserve(aiMesh->mNumFaces + 1);
+    strands.pointsY.reserve(aiMesh->mNumFaces + 1);
+    strands.pointsZ.reserve(aiMesh->mNumFaces + 1);
+
+    const auto aiVectorToGlm = [](const aiVector3D& from)
+    { return glm::vec3(from.x, from.y, from.z); };
+
+    // Consecutive line faces that share a vertex index belong to the same strand
+    uint32_t previousEndIndex = std::numeric_limits<uint32_t>::max();
+
+    for (uint32_t i = 0; i < aiMesh->mNumFaces; ++i)
+    {
+        const aiFace& face = aiMesh->mFaces[i];
+        if (face.mNumIndices != 2)
+        {
+            continue;
+        }
+
+        const uint32_t startIndex = face.mIndices[0];
+        const uint32_t endIndex = face.mIndices[1];
+
+        if (startIndex != previousEndIndex)
+        {
+            strands.AddStrand();
+            strands.AddPoint(aiVectorToGlm(aiMesh->mVertices[startIndex]));
+        }
+
+        strands.AddPoint(aiVectorToGlm(aiMesh->mVertices[endIndex]));
+        previousEndIndex = endIndex;
+    }
+
+    return strands;
+}
+
 void ProcessNode(const aiNode* aiNode, const Node* parent, std::vector<Node>& nodes)
 {
     static const auto aiMatrixToGlm = [](const aiMatrix4x4& from)
@@ -265,14 +308,46 @@ std::vector<Node> ProcessNodes(const aiScene* aiScene)
     return nodes;
 }
 
-ModelLoader::ModelLoader(const std::shared_ptr<BindlessResources>& bindlessResources, const std::shared_ptr<VulkanContext>& vulkanContext)
+ModelLoader::ModelLoader(const std::shared_ptr<BindlessResources>& bindlessResources, const std::shared_ptr<VulkanContext>& vulkanContext, const std::shared_ptr<JobSystem>& jobSystem)
     : _vulkanContext(vulkanContext)
     , _bindlessResources(bindlessResources)
+    , _jobSystem(jobSystem)
 {
 }
 
-std::shared_ptr<Model> ModelLoader::LoadFromFile(std::string_view path)
+std::shared_ptr<Model> ModelLoader::LoadFromFile(std::string_view path, const HairSettings& hairSettings)
 {
+    return LoadModelFile(path, hairSettings, DefaultHairTechnique());
+}
+
+std::shared_ptr<Model> ModelLoader::ReprocessHair(std::string_view path, const HairSettings& hairSettings, HairTechnique hairTechnique)
+{
+    if (!_hairMaterials.contains(std::string(path)))
+    {
+        return nullptr;
+    }
+
+    return LoadModelFile(path, hairSettings, hairTechnique);
+}
+
+void ModelLoader::SetRetainHairSources(bool retainHairSources)
+{
+    _retainHairSources = retainHairSources;
+    if (!_retainHairSources)
+    {
+        _hairStageCaches.clear();
+    }
+}
+
+std::shared_ptr<Model> ModelLoader::LoadModelFile(std::string_view path, const HairSettings& hairSettings, HairTechnique hairTechnique)
+{
+    const auto hairStageCache = _hairStageCaches.find(std::string(path));
+    if (hairStageCache != _hairStageCaches.end() && hairStageCache->second.HasSource())
+    {
+        spdlog::info("[FILE] Reusing loaded hair of model file {}", path);
+        return ProcessModel(hairStageCache->second.Source(), path, hairSettings, hairTechnique);
+    }
+
     spdlog::info("[FILE] Loading model file {}", path);
 
     const aiScene* aiScene = _importer.ReadFile({ path.begin(), path.end() }, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals | aiProcess_GenBoundingBoxes);
@@ -286,24 +361,42 @@ std::shared_ptr<Model> ModelLoader::LoadFromFile(std::string_view path)
     _imageCache.clear(); // Clear image cache for a new load
     std::string_view directory = path.substr(0, path.find_last_of('/'));
 
-    ModelCreation modelCreation = LoadModel(aiScene, directory);
-    return ProcessModel(modelCreation);
+    const auto hairMaterials = _hairMaterials.find(std::string(path));
+    ModelCreation modelCreation = LoadModel(aiScene, directory, hairMaterials != _hairMaterials.end() ? &hairMaterials->second : nullptr);
+    _importer.FreeScene(); // Everything is copied out of the scene, release it before processing
+
+    return ProcessModel(std::move(modelCreation), path, hairSettings, hairTechnique);
+}
+
+HairTechnique ModelLoader::DefaultHairTechnique() const
+{
+    return _vulkanContext->IsExtensionSupported(VK_NV_RAY_TRACING_LINEAR_SWEPT_SPHERES_EXTENSION_NAME) ? HairTechnique::eLSS : HairTechnique::eDOTS;
 }
 
-ModelCreation ModelLoader::LoadModel(const aiScene* aiScene, const std::string_view directory)
+ModelCreation ModelLoader::LoadModel(const aiScene* aiScene, const std::string_view directory, const LoadedMaterials* loadedMaterials)
 {
     ModelCreation modelCreation {};
     modelCreation.sceneGraph = std::make_shared<SceneGraph>();
     SceneGraph& sceneGraph = *modelCreation.sceneGraph;
 
-    for (uint32_t i = 0; i < aiScene->mNumMaterials; ++i)
+    // Materials in use by the current scene can't be changed while frames are in flight, so they are only created by the first load
+    if (loadedMaterials && loadedMaterials->materials.size() == aiScene->mNumMaterials)
     {
-        sceneGraph.materials.push_back(ProcessMaterial(aiScene->mMaterials[i], directory, _bindlessResources, sceneGraph.textures, _imageCache));
+        sceneGraph.materials = loadedMaterials->materials;
+        sceneGraph.textures = loadedMaterials->textures;
+    }
+    else
+    {
+        for (uint32_t i = 0; i < aiScene->mNumMaterials; ++i)
+        {
+            sceneGraph.materials.push_back(ProcessMaterial(aiScene->mMaterials[i], directory, _bindlessResources, sceneGraph.textures, _imageCache));
+        }
     }
 
     for (uint32_t i = 0; i < aiScene->mNumMeshes; ++i)
     {
         sceneGraph.meshes.push_back(ProcessMesh(aiScene, aiScene->mMeshes[i], sceneGraph.materials, modelCreation.vertexBuffer, modelCreation.indexBuffer));
+        modelCreation.strandBuffers.push_back(ProcessStrands(aiScene->mMeshes[i]));
     }
 
     sceneGraph.sceneName = aiScene->mName.C_Str();
@@ -311,7 +404,7 @@ ModelCreation ModelLoader::LoadModel(const aiScene* aiScene, const std::string_v
     return modelCreation;
 }
 
-std::shared_ptr<Model> ModelLoader::ProcessModel(const ModelCreation& modelCreation)
+std::shared_ptr<Model> ModelLoader::ProcessModel(ModelCreation&& modelCreation, std::string_view path, const HairSettings& hairSettings, HairTechnique hairTechnique)
 {
     // We don't support pre-processing models with multiple different mesh types
     Mesh::PrimitiveType firstPrimitiveType = modelCreation.sceneGraph->meshes[0].primitiveType;
@@ -330,7 +423,20 @@ std::shared_ptr<Model> ModelLoader::ProcessModel(const ModelCreation& modelCreat
         return std::make_unique<Model>(modelCreation, _vulkanContext);
     }
 
+    _hairMaterials.try_emplace(std::string(path), LoadedMaterials { modelCreation.sceneGraph->materials, modelCreation.sceneGraph->textures });
+
+    // Keep the loaded hair when asked to, so it can be processed again with other settings without reading the file
+    HairStageCache* hairStageCache = nullptr;
+    if (_retainHairSources)
+    {
+        hairStageCache = &_hairStageCaches[std::string(path)];
+        if (!hairStageCache->HasSource())
+        {
+            hairStageCache->StoreSource(modelCreation);
+        }
+    }
+
     // Create mesh from hair strands
-    ModelCreation newModelCreation = _vulkanContext->IsExtensionSupported(VK_NV_RAY_TRACING_LINEAR_SWEPT_SPHERES_EXTENSION_NAME) ? ProcessHairLSS(modelCreation) : ProcessHairDOTS(modelCreation);
+    ModelCreation newModelCreation = ProcessHair(std::move(modelCreation), *_jobSystem, hairTechnique, hairSettings, hairStageCache);
     return std::make_unique<Model>(newModelCreation, _vulkanContext);
 }
@@ -0,0 +1,241 @@
+#include "resources/model/voxel_brick_map.hpp"
+#include "resources/model/voxel_occupancy_grid.hpp"
+#include "job_system.hpp"
+#include <algorithm>
+#include <numeric>
+
+// A word of a row covers exactly 8 bricks along x, with a byte per brick
+static_assert(VoxelOccupancyGrid::BITS_PER_WORD == VoxelBrick::SIZE * VoxelBrick::SIZE);
+
+// Number of bricks reduced by a single job when downsampling
+static constexpr uint32_t DOWNSAMPLE_CHUNK_SIZE = 64;
+
+// ORs every 2x2x2 voxels of a brick into one of the 4x4x4 voxels in an octant of the brick above it, a slice word at a time
+void DownsampleBrick(const VoxelBrick& brick, const glm::ivec3& octantOrigin, VoxelBrick& target)
+{
+    for (int32_t z = 0; z < VoxelBrick::SIZE / 2; ++z)
+    {
+        uint64_t slice = brick.words[z * 2] | brick.words[z * 2 + 1];
+
+        // Merge every odd row into the even row before it and every odd voxel into the even voxel before it
+        slice |= slice >> VoxelBrick::SIZE;
+        slice |= slice >> 1;
+        slice &= 0x0055005500550055;
+
+        // Pack the even voxels of every even row into its low 4 bits
+        slice = (slice | slice >> 1) & 0x0033003300330033;
+        slice = (slice | slice >> 2) & 0x000F000F000F000F;
+
+        uint64_t targetSlice = 0;
+        for (int32_t y = 0; y < VoxelBrick::SIZE / 2; ++y)
+        {
+            targetSlice |= ((slice >> (y * VoxelBrick::SIZE * 2)) & 0xF) << ((octantOrigin.y + y) * VoxelBrick::SIZE + octantOrigin.x);
+        }
+        target.words[octantOrigin.z + z] |= targetSlice;
+    }
+}
+
+VoxelBrickMap::VoxelBrickMap(const glm::ivec3& resolution)
+    : _resolution(resolution)
+    , _brickResolution((resolution + VoxelBrick::SIZE - 1) / VoxelBrick::SIZE)
+    , _brickIndices(_brickResolution.x * _brickResolution.y * _brickResolution.z, EMPTY_BRICK)
+{
+}
+
+void VoxelBrickMap::AllocateBricks(const VoxelOccupancyGrid& brickOccupancy)
+{
+    brickOccupancy.ForEachFilled([&](const glm::ivec3& brick)
+        {
+            uint32_t& brickIndex = _brickIndices[BrickIndex(brick)];
+            if (brickIndex == EMPTY_BRICK)
+            {
+                brickIndex = _bricks.size();
+                _bricks.emplace_back();
+            }
+        });
+}
+
+void VoxelBrickMap::RemoveEmptyBricks()
+{
+    uint32_t keptCount = 0;
+    for (uint32_t& brickIndex : _brickIndices)
+    {
+        if (brickIndex == EMPTY_BRICK)
+        {
+            continue;
+        }
+
+        if (_bricks[brickIndex].IsEmpty())
+        {
+            brickIndex = EMPTY_BRICK;
+            continue;
+        }
+
+        // Bricks are allocated in storage order, so kept bricks only ever move towards the front
+        _bricks[keptCount] = _bricks[brickIndex];
+        brickIndex = keptCount++;
+    }
+
+    _bricks.resize(keptCount);
+}
+
+bool VoxelBrickMap::Test(const glm::ivec3& voxel) const
+{
+    if (voxel.x < 0 || voxel.y < 0 || voxel.z < 0 || voxel.x >= _resolution.x || voxel.y >= _resolution.y || voxel.z >= _resolution.z)
+    {
+        return false;
+    }
+
+    const uint32_t brickIndex = _brickIndices[BrickIndex(BrickOf(voxel))];
+    if (brickIndex == EMPTY_BRICK)
+    {
+        return false;
+    }
+
+    const uint32_t bit = (voxel.y % VoxelBrick::SIZE) * VoxelBrick::SIZE + voxel.x % VoxelBrick::SIZE;
+    return (_bricks[brickIndex].words[voxel.z % VoxelBrick::SIZE] >> bit) & 1;
+}
+
+void VoxelBrickMap::SetRowWord(uint32_t wordInRow, int32_t y, int32_t z, uint64_t bits)
+{
+    SetRowWordBits<false>(wordInRow, y, z, bits);
+}
+
+void VoxelBrickMap::SetRowWordAtomic(uint32_t wordInRow, int32_t y, int32_t z, uint64_t bits)
+{
+    SetRowWordBits<true>(wordInRow, y, z, bits);
+}
+
+void VoxelBrickMap::SetBox(const glm::ivec3& min, const glm::ivec3& max)
+{
+    SetBoxWords<false>(min, max);
+}
+
+void VoxelBrickMap::SetBoxAtomic(const glm::ivec3& min, const glm::ivec3& max)
+{
+    SetBoxWords<true>(min, max);
+}
+
+template <bool ATOMIC>
+void VoxelBrickMap::SetRowWordBits(uint32_t wordInRow, int32_t y, int32_t z, uint64_t bits)
+{
+    if (bits == 0 || y < 0 || y >= _resolution.y || z < 0 || z >= _resolution.z)
+    {
+        return;
+    }
+
+    // Every byte of the word is the row of the next brick along x
+    const glm::ivec3 firstBrick = BrickOf(glm::ivec3(wordInRow * VoxelOccupancyGrid::BITS_PER_WORD, y, z));
+    const uint32_t rowShift = (y % VoxelBrick::SIZE) * VoxelBrick::SIZE;
+    const int32_t slice = z % VoxelBrick::SIZE;
+
+    for (int32_t i = 0; i < VoxelBrick::SIZE && firstBrick.x + i < _brickResolution.x; ++i)
+    {
+        const uint64_t rowBits = (bits >> (i * VoxelBrick::SIZE)) & 0xFF;
+        if (rowBits == 0)
+        {
+            continue;
+        }
+
+        const uint32_t brickIndex = _brickIndices[BrickIndex(firstBrick + glm::ivec3(i, 0, 0))];
+        if (brickIndex != EMPTY_BRICK)
+        {
+            VoxelOccupancyGrid::OrWord<ATOMIC>(_bricks[brickIndex].words[slice], rowBits << rowShift);
+        }
+    }
+}
+
+template <bool ATOMIC>
+void VoxelBrickMap::SetBoxWords(const glm::ivec3& min, const glm::ivec3& max)
+{
+    const int32_t xMin = std::max(min.x, 0);
+    const int32_t xMax = std::min(max.x, _resolution.x - 1);
+    if (xMin > xMax)
+    {
+        return;
+    }
+
+    // Same row words as the dense grid, which are then split over the bricks they cover
+    const uint32_t firstWord = xMin / VoxelOccupancyGrid::BITS_PER_WORD;
+    const uint32_t lastWord = xMax / VoxelOccupancyGrid::BITS_PER_WORD;
+
+    for (int32_t z = std::max(min.z, 0); z <= std::min(max.z, _resolution.z - 1); ++z)
+    {
+        for (int32_t y = std::max(min.y, 0); y <= std::min(max.y, _resolution.y - 1); ++y)
+        {
+            for (uint32_t word = firstWord; word <= lastWord; ++word)
+            {
+                const uint32_t firstBit = word == firstWord ? xMin % VoxelOccupancyGrid::BITS_PER_WORD : 0;
+                const uint32_t lastBit = word == lastWord ? xMax % VoxelOccupancyGrid::BITS_PER_WORD : VoxelOccupancyGrid::BITS_PER_WORD - 1;
+                SetRowWordBits<ATOMIC>(word, y, z, VoxelOccupancyGrid::BitRange(firstBit, lastBit));
+            }
+        }
+    }
+}
+
+uint32_t VoxelBrickMap::FilledCount() const
+{
+    return std::accumulate(_bricks.begin(), _bricks.end(), uint32_t { 0 }, [](uint32_t count, const VoxelBrick& brick)
+        {
+            for (const uint64_t word : brick.words)
+            {
+                count += std::popcount(word);
+            }
+            return count;
+        });
+}
+
+VoxelOccupancyGrid VoxelBrickMap::ToDense() const
+{
+    VoxelOccupancyGrid dense { _resolution };
+    ForEachFilled([&](const glm::ivec3& voxel)
+        { dense.Set(voxel); });
+    return dense;
+}
+
+VoxelBrickMap VoxelBrickMap::Downsample(JobSystem& jobSystem) const
+{
+    VoxelBrickMap coarse { (_resolution + 1) / 2 };
+
+    // Every 2x2x2 bricks reduce into a single brick of the coarser level
+    VoxelOccupancyGrid coarseBricks { coarse._brickResolution };
+    for (uint32_t brickIndex = 0; brickIndex < _brickIndices.size(); ++brickIndex)
+    {
+        if (_brickIndices[brickIndex] != EMPTY_BRICK)
+        {
+            const uint32_t brickRow = brickIndex / _brickResolution.x;
+            coarseBricks.Set(glm::ivec3(brickIndex % _brickResolution.x, brickRow % _brickResolution.y, brickRow / _brickResolution.y) / 2);
+        }
+    }
+    coarse.AllocateBricks(coarseBricks);
+
+    // Bricks are allocated in the order they are visited, so brick i of the coarser level is the i-th one visited here
+    std::vector<glm::ivec3> targets {};
+    targets.reserve(coarse._bricks.size());
+    coarseBricks.ForEachFilled([&](const glm::ivec3& brick)
+        { targets.emplace_back(brick); });
+
+    jobSystem.ParallelFor(targets.size(), DOWNSAMPLE_CHUNK_SIZE, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                for (int32_t octant = 0; octant < 8; ++octant)
+                {
+                    const glm::ivec3 offset { octant & 1, (octant >> 1) & 1, octant >> 2 };
+                    const glm::ivec3 brick = targets[i] * 2 + offset;
+                    if (brick.x >= _brickResolution.x || brick.y >= _brickResolution.y || brick.z >= _brickResolution.z)
+                    {
+                        continue;
+                    }
+
+                    const uint32_t brickIndex = _brickIndices[BrickIndex(brick)];
+                    if (brickIndex != EMPTY_BRICK)
+                    {
+                        DownsampleBrick(_bricks[brickIndex], offset * (VoxelBrick::SIZE / 2), coarse._bricks[i]);
+                    }
+                }
+            }
+        });
+
+    return coarse;
+}
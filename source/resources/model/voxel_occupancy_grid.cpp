@@ -0,0 +1,147 @@
+#include "resources/model/voxel_occupancy_grid.hpp"
+#include <algorithm>
+#include <numeric>
+
+static_assert(alignof(uint64_t) >= std::atomic_ref<uint64_t>::required_alignment, "Occupancy words have to be usable as atomics");
+
+VoxelOccupancyGrid::VoxelOccupancyGrid(const glm::ivec3& resolution)
+    : _resolution(resolution)
+    , _wordsPerRow(WordsPerRow(resolution.x))
+    , _words(WordCount(resolution), 0)
+{
+}
+
+bool VoxelOccupancyGrid::Test(const glm::ivec3& voxel) const
+{
+    return TestRow(voxel.x, voxel.x, voxel.y, voxel.z);
+}
+
+void VoxelOccupancyGrid::Set(const glm::ivec3& voxel)
+{
+    SetRow(voxel.x, voxel.x, voxel.y, voxel.z);
+}
+
+void VoxelOccupancyGrid::SetRow(int32_t xMin, int32_t xMax, int32_t y, int32_t z)
+{
+    xMin = std::max(xMin, 0);
+    xMax = std::min(xMax, _resolution.x - 1);
+    if (xMin > xMax || !IsInside(y, z))
+    {
+        return;
+    }
+
+    uint64_t* row = _words.data() + RowWord(y, z);
+    const uint32_t firstWord = xMin / BITS_PER_WORD;
+    const uint32_t lastWord = xMax / BITS_PER_WORD;
+    const uint32_t firstBit = xMin % BITS_PER_WORD;
+    const uint32_t lastBit = xMax % BITS_PER_WORD;
+
+    if (firstWord == lastWord)
+    {
+        row[firstWord] |= BitRange(firstBit, lastBit);
+        return;
+    }
+
+    row[firstWord] |= BitRange(firstBit, BITS_PER_WORD - 1);
+    std::fill(row + firstWord + 1, row + lastWord, ~uint64_t { 0 });
+    row[lastWord] |= BitRange(0, lastBit);
+}
+
+void VoxelOccupancyGrid::SetBox(const glm::ivec3& min, const glm::ivec3& max)
+{
+    SetBoxWords<false>(min, max);
+}
+
+void VoxelOccupancyGrid::SetBoxAtomic(const glm::ivec3& min, const glm::ivec3& max)
+{
+    SetBoxWords<true>(min, max);
+}
+
+void VoxelOccupancyGrid::SetRowWord(uint32_t wordInRow, int32_t y, int32_t z, uint64_t bits)
+{
+    _words[RowWord(y, z) + wordInRow] |= bits;
+}
+
+void VoxelOccupancyGrid::SetRowWordAtomic(uint32_t wordInRow, int32_t y, int32_t z, uint64_t bits)
+{
+    OrWord<true>(_words[RowWord(y, z) + wordInRow], bits);
+}
+
+template <bool ATOMIC>
+void VoxelOccupancyGrid::SetBoxWords(const glm::ivec3& min, const glm::ivec3& max)
+{
+    const int32_t xMin = std::max(min.x, 0);
+    const int32_t xMax = std::min(max.x, _resolution.x - 1);
+    if (xMin > xMax)
+    {
+        return;
+    }
+
+    // Every row of the box covers the same words, only the first and last one are partially filled
+    const uint32_t firstWord = xMin / BITS_PER_WORD;
+    const uint32_t lastWord = xMax / BITS_PER_WORD;
+    const uint64_t firstMask = BitRange(xMin % BITS_PER_WORD, firstWord == lastWord ? xMax % BITS_PER_WORD : BITS_PER_WORD - 1);
+    const uint64_t lastMask = BitRange(0, xMax % BITS_PER_WORD);
+
+    for (int32_t z = std::max(min.z, 0); z <= std::min(max.z, _resolution.z - 1); ++z)
+    {
+        for (int32_t y = std::max(min.y, 0); y <= std::min(max.y, _resolution.y - 1); ++y)
+        {
+            uint64_t* row = _words.data() + RowWord(y, z);
+            OrWord<ATOMIC>(row[firstWord], firstMask);
+            if (firstWord == lastWord)
+            {
+                continue;
+            }
+
+            for (uint32_t word = firstWord + 1; word < lastWord; ++word)
+            {
+                OrWord<ATOMIC>(row[word], ~uint64_t { 0 });
+            }
+            OrWord<ATOMIC>(row[lastWord], lastMask);
+        }
+    }
+}
+
+bool VoxelOccupancyGrid::TestRow(int32_t xMin, int32_t xMax, int32_t y, int32_t z) const
+{
+    xMin = std::max(xMin, 0);
+    xMax = std::min(xMax, _resolution.x - 1);
+    if (xMin > xMax || !IsInside(y, z))
+    {
+        return false;
+    }
+
+    const uint64_t* row = _words.data() + RowWord(y, z);
+    const uint32_t firstWord = xMin / BITS_PER_WORD;
+    const uint32_t lastWord = xMax / BITS_PER_WORD;
+    const uint32_t firstBit = xMin % BITS_PER_WORD;
+    const uint32_t lastBit = xMax % BITS_PER_WORD;
+
+    if (firstWord == lastWord)
+    {
+        return (row[firstWord] & BitRange(firstBit, lastBit)) != 0;
+    }
+
+    return (row[firstWord] & BitRange(firstBit, BITS_PER_WORD - 1)) != 0
+        || std::any_of(row + firstWord + 1, row + lastWord, [](uint64_t word)
+            { return word != 0; })
+        || (row[lastWord] & BitRange(0, lastBit)) != 0;
+}
+
+void VoxelOccupancyGrid::Union(const VoxelOccupancyGrid& other)
+{
+    std::transform(_words.begin(), _words.end(), other._words.begin(), _words.begin(), [](uint64_t a, uint64_t b)
+        { return a | b; });
+}
+
+void VoxelOccupancyGrid::Clear()
+{
+    std::fill(_words.begin(), _words.end(), 0);
+}
+
+uint32_t VoxelOccupancyGrid::FilledCount() const
+{
+    return std::accumulate(_words.begin(), _words.end(), uint32_t { 0 }, [](uint32_t count, uint64_t word)
+        { return count + std::popcount(word); });
+}
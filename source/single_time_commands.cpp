@@ -48,6 +48,9 @@ void SingleTimeCommands::SubmitAndWait()
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &_commandBuffer;
 
-    VkCheckResult(_vulkanContext->GraphicsQueue().submit(1, &submitInfo, _fence), "Failed submitting one time buffer to queue!");
+    {
+        std::lock_guard lock { _vulkanContext->QueueMutex() };
+        VkCheckResult(_vulkanContext->GraphicsQueue().submit(1, &submitInfo, _fence), "Failed submitting one time buffer to queue!");
+    }
     VkCheckResult(_vulkanContext->Device().waitForFences(1, &_fence, vk::True, std::numeric_limits<uint64_t>::max()), "Failed waiting for fence!");
 }
@@ -5,61 +5,161 @@
 #include "vk_common.hpp"
 #include "vulkan_context.hpp"
 
-TopLevelAccelerationStructure::TopLevelAccelerationStructure(const std::vector<BottomLevelAccelerationStructure>& blases, const std::shared_ptr<BindlessResources>& resources, const std::shared_ptr<VulkanContext>& vulkanContext)
-    : _vulkanContext(vulkanContext)
+#include <spdlog/spdlog.h>
+
+TopLevelAccelerationStructure::TopLevelAccelerationStructure(const std::vector<std::shared_ptr<const BottomLevelAccelerationStructure>>& blases, const std::vector<uint32_t>& instances, const std::shared_ptr<BindlessResources>& resources, const std::shared_ptr<VulkanContext>& vulkanContext)
+    : _instanceCount(instances.size())
+    , _vulkanContext(vulkanContext)
 {
-    InitializeStructure(blases, resources);
+    // Every BLAS gets its own instance data, so changing which BLAS an instance uses only requires a TLAS rebuild
+    std::vector<BLASInstanceCreation> blasInstanceCreations(blases.size());
+    for (uint32_t blasIndex = 0; blasIndex < blases.size(); ++blasIndex)
+    {
+        blasInstanceCreations[blasIndex].firstGeometryIndex = blases[blasIndex]->FirstGeometryIndex();
+    }
+    _firstBLASInstanceIndex = resources->BLASInstances().CreateRange(blasInstanceCreations).handle;
+
+    WriteInstances(blases, instances);
+    InitializeStructures();
 }
 
 TopLevelAccelerationStructure::~TopLevelAccelerationStructure()
 {
-    _vulkanContext->Device().destroyAccelerationStructureKHR(_vkStructure, nullptr, _vulkanContext->Dldi());
+    for (const FrameStructure& frame : _frames)
+    {
+        _vulkanContext->Device().destroyAccelerationStructureKHR(frame.structure, nullptr, _vulkanContext->Dldi());
+    }
+}
+
+void TopLevelAccelerationStructure::UpdateInstances(const std::vector<std::shared_ptr<const BottomLevelAccelerationStructure>>& blases, const std::vector<uint32_t>& instances)
+{
+    if (instances.size() != _instanceCount)
+    {
+        spdlog::error("[TLAS] Instance count can't change when updating instances, expected {} but got {}", _instanceCount, instances.size());
+        return;
+    }
+
+    WriteInstances(blases, instances);
+    for (FrameStructure& frame : _frames)
+    {
+        frame.outdated = true;
+    }
 }
 
-void TopLevelAccelerationStructure::InitializeStructure(const std::vector<BottomLevelAccelerationStructure>& blases, const std::shared_ptr<BindlessResources>& resources)
+void TopLevelAccelerationStructure::RecordPendingBuild(vk::CommandBuffer commandBuffer, uint32_t frameIndex)
 {
-    uint32_t geometryCount = 0;
-    std::vector<vk::AccelerationStructureInstanceKHR> accelerationStructureInstances {};
-    for (const auto& blas : blases)
+    FrameStructure& frame = _frames.at(frameIndex);
+    if (!frame.outdated)
     {
+        return;
+    }
+
+    RecordBuild(commandBuffer, frame);
+    frame.outdated = false;
+
+    vk::MemoryBarrier2 barrier {};
+    barrier.srcStageMask = vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR;
+    barrier.srcAccessMask = vk::AccessFlagBits2::eAccelerationStructureWriteKHR;
+    barrier.dstStageMask = vk::PipelineStageFlagBits2::eRayTracingShaderKHR;
+    barrier.dstAccessMask = vk::AccessFlagBits2::eAccelerationStructureReadKHR;
+
+    vk::DependencyInfo dependencyInfo {};
+    dependencyInfo.setMemoryBarrierCount(1)
+        .setPMemoryBarriers(&barrier);
+
+    commandBuffer.pipelineBarrier2(dependencyInfo);
+}
+
+void TopLevelAccelerationStructure::InitializeStructures()
+{
+    for (FrameStructure& frame : _frames)
+    {
+        BufferCreation instancesBufferCreation {};
+        instancesBufferCreation.SetName("TLAS Instances Buffer")
+            .SetUsageFlags(vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
+            .SetIsMappable(true)
+            .SetSize(_instanceCount * sizeof(vk::AccelerationStructureInstanceKHR));
+        frame.instancesBuffer = std::make_unique<Buffer>(instancesBufferCreation, _vulkanContext);
+
+        const vk::AccelerationStructureGeometryKHR accelerationStructureGeometry = InstancesGeometry(frame);
+
+        vk::AccelerationStructureBuildGeometryInfoKHR buildGeometryInfo {};
+        buildGeometryInfo.type = vk::AccelerationStructureTypeKHR::eTopLevel;
+        buildGeometryInfo.flags = vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace;
+        buildGeometryInfo.mode = vk::BuildAccelerationStructureModeKHR::eBuild;
+        buildGeometryInfo.geometryCount = 1;
+        buildGeometryInfo.pGeometries = &accelerationStructureGeometry;
+
+        vk::AccelerationStructureBuildSizesInfoKHR buildSizesInfo = _vulkanContext->Device().getAccelerationStructureBuildSizesKHR(
+            vk::AccelerationStructureBuildTypeKHR::eDevice, buildGeometryInfo, _instanceCount, _vulkanContext->Dldi());
+
+        BufferCreation structureBufferCreation {};
+        structureBufferCreation.SetName("TLAS Structure Buffer")
+            .SetUsageFlags(vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
+            .SetIsMappable(false)
+            .SetSize(buildSizesInfo.accelerationStructureSize);
+        frame.structureBuffer = std::make_unique<Buffer>(structureBufferCreation, _vulkanContext);
+
+        vk::AccelerationStructureCreateInfoKHR createInfo {};
+        createInfo.buffer = frame.structureBuffer->buffer;
+        createInfo.offset = 0;
+        createInfo.size = buildSizesInfo.accelerationStructureSize;
+        createInfo.type = vk::AccelerationStructureTypeKHR::eTopLevel;
+        frame.structure = _vulkanContext->Device().createAccelerationStructureKHR(createInfo, nullptr, _vulkanContext->Dldi());
+
+        // Kept around for rebuilding the structure when instances are updated
+        BufferCreation scratchBufferCreation {};
+        scratchBufferCreation.SetName("TLAS Scratch Buffer")
+            .SetUsageFlags(vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress)
+            .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
+            .SetIsMappable(false)
+            .SetSize(buildSizesInfo.buildScratchSize);
+        frame.scratchBuffer = std::make_unique<Buffer>(scratchBufferCreation, _vulkanContext);
+    }
+
+    // Structures of all frames are built at once, they don't share any buffers
+    SingleTimeCommands singleTimeCommands { _vulkanContext };
+    singleTimeCommands.Record([&](vk::CommandBuffer commandBuffer)
+        {
+            for (FrameStructure& frame : _frames)
+            {
+                RecordBuild(commandBuffer, frame);
+            }
+        });
+    singleTimeCommands.SubmitAndWait();
+}
+
+void TopLevelAccelerationStructure::WriteInstances(const std::vector<std::shared_ptr<const BottomLevelAccelerationStructure>>& blases, const std::vector<uint32_t>& instances)
+{
+    _instances.clear();
+    _instances.reserve(instances.size());
+
+    for (const uint32_t blasIndex : instances)
+    {
+        const BottomLevelAccelerationStructure& blas = *blases[blasIndex];
         vk::TransformMatrixKHR transform = VkGLMToTransformMatrixKHR(blas.Transform());
 
-        vk::AccelerationStructureInstanceKHR& accelerationStructureInstance = accelerationStructureInstances.emplace_back();
+        vk::AccelerationStructureInstanceKHR& accelerationStructureInstance = _instances.emplace_back();
         accelerationStructureInstance.flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR; // vk::GeometryInstanceFlagBitsKHR::eTriangleFacingCullDisable
         accelerationStructureInstance.transform = transform;
-        accelerationStructureInstance.instanceCustomIndex = accelerationStructureInstances.size() - 1;
+        accelerationStructureInstance.instanceCustomIndex = _firstBLASInstanceIndex + blasIndex; // Index of the BLAS instance data
         accelerationStructureInstance.mask = 0xFF;
         accelerationStructureInstance.instanceShaderBindingTableRecordOffset = static_cast<uint32_t>(blas.Type());
 
         vk::AccelerationStructureDeviceAddressInfoKHR blasDeviceAddress {};
         blasDeviceAddress.accelerationStructure = blas.Structure();
         accelerationStructureInstance.accelerationStructureReference = _vulkanContext->Device().getAccelerationStructureAddressKHR(blasDeviceAddress, _vulkanContext->Dldi());
-
-        BLASInstanceCreation blasInstanceCreation {};
-        blasInstanceCreation.firstGeometryIndex = geometryCount;
-        resources->BLASInstances().Create(blasInstanceCreation);
-
-        geometryCount++;
     }
+}
 
-    BufferCreation instancesBufferCreation {};
-    instancesBufferCreation.SetName("TLAS Instances Buffer")
-        .SetUsageFlags(vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress)
-        .SetMemoryUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
-        .SetIsMappable(true)
-        .SetSize(accelerationStructureInstances.size() * sizeof(vk::AccelerationStructureInstanceKHR));
-    _instancesBuffer = std::make_unique<Buffer>(instancesBufferCreation, _vulkanContext);
-    memcpy(_instancesBuffer->mappedPtr, accelerationStructureInstances.data(), accelerationStructureInstances.size() * sizeof(vk::AccelerationStructureInstanceKHR));
+void TopLevelAccelerationStructure::RecordBuild(vk::CommandBuffer commandBuffer, FrameStructure& frame)
+{
+    // The instances are copied when recording, the buffer of the frame isn't read by any work still running
+    memcpy(frame.instancesBuffer->mappedPtr, _instances.data(), _instances.size() * sizeof(vk::AccelerationStructureInstanceKHR));
 
-    vk::DeviceOrHostAddressConstKHR instanceDataDeviceAddress {};
-    instanceDataDeviceAddress.deviceAddress = _vulkanContext->GetBufferDeviceAddress(_instancesBuffer->buffer);
-
-    vk::AccelerationStructureGeometryKHR accelerationStructureGeometry {};
-    accelerationStructureGeometry.flags = vk::GeometryFlagBitsKHR::eOpaque;
-    accelerationStructureGeometry.geometryType = vk::GeometryTypeKHR::eInstances;
-    accelerationStructureGeometry.geometry.instances = vk::AccelerationStructureGeometryInstancesDataKHR {};
-    accelerationStructureGeometry.geometry.instances.arrayOfPointers = false;
-    accelerationStructureGeometry.geometry.instances.data = instanceDataDeviceAddress;
+    const vk::AccelerationStructureGeometryKHR accelerationStructureGeometry = InstancesGeometry(frame);
 
     vk::AccelerationStructureBuildGeometryInfoKHR buildGeometryInfo {};
     buildGeometryInfo.type = vk::AccelerationStructureTypeKHR::eTopLevel;
@@ -67,47 +167,30 @@ void TopLevelAccelerationStructure::InitializeStructure(const std::vector<Bottom
     buildGeometryInfo.mode = vk::BuildAccelerationStructureModeKHR::eBuild;
     buildGeometryInfo.geometryCount = 1;
     buildGeometryInfo.pGeometries = &accelerationStructureGeometry;
-
-    const uint32_t primitiveCount = accelerationStructureInstances.size();
-    vk::AccelerationStructureBuildSizesInfoKHR buildSizesInfo = _vulkanContext->Device().getAccelerationStructureBuildSizesKHR(
-        vk::AccelerationStructureBuildTypeKHR::eDevice, buildGeometryInfo, primitiveCount, _vulkanContext->Dldi());
-
-    BufferCreation structureBufferCreation {};
-    structureBufferCreation.SetName("TLAS Structure Buffer")
-        .SetUsageFlags(vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress)
-        .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
-        .SetIsMappable(false)
-        .SetSize(buildSizesInfo.accelerationStructureSize);
-    _structureBuffer = std::make_unique<Buffer>(structureBufferCreation, _vulkanContext);
-
-    vk::AccelerationStructureCreateInfoKHR createInfo {};
-    createInfo.buffer = _structureBuffer->buffer;
-    createInfo.offset = 0;
-    createInfo.size = buildSizesInfo.accelerationStructureSize;
-    createInfo.type = vk::AccelerationStructureTypeKHR::eTopLevel;
-    _vkStructure = _vulkanContext->Device().createAccelerationStructureKHR(createInfo, nullptr, _vulkanContext->Dldi());
-
-    BufferCreation scratchBufferCreation {};
-    scratchBufferCreation.SetName("TLAS Scratch Buffer")
-        .SetUsageFlags(vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress)
-        .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
-        .SetIsMappable(false)
-        .SetSize(buildSizesInfo.buildScratchSize);
-    _scratchBuffer = std::make_unique<Buffer>(scratchBufferCreation, _vulkanContext);
-
-    // Fill remaining data
-    buildGeometryInfo.dstAccelerationStructure = _vkStructure;
-    buildGeometryInfo.scratchData.deviceAddress = _vulkanContext->GetBufferDeviceAddress(_scratchBuffer->buffer);
+    buildGeometryInfo.dstAccelerationStructure = frame.structure;
+    buildGeometryInfo.scratchData.deviceAddress = _vulkanContext->GetBufferDeviceAddress(frame.scratchBuffer->buffer);
 
     vk::AccelerationStructureBuildRangeInfoKHR buildRangeInfo {};
-    buildRangeInfo.primitiveCount = primitiveCount;
+    buildRangeInfo.primitiveCount = _instanceCount;
     buildRangeInfo.primitiveOffset = 0;
     buildRangeInfo.firstVertex = 0;
     buildRangeInfo.transformOffset = 0;
     std::vector<vk::AccelerationStructureBuildRangeInfoKHR*> pBuildRangeInfos = { &buildRangeInfo };
 
-    SingleTimeCommands singleTimeCommands { _vulkanContext };
-    singleTimeCommands.Record([&](vk::CommandBuffer commandBuffer)
-        { commandBuffer.buildAccelerationStructuresKHR(1, &buildGeometryInfo, pBuildRangeInfos.data(), _vulkanContext->Dldi()); });
-    singleTimeCommands.SubmitAndWait();
+    commandBuffer.buildAccelerationStructuresKHR(1, &buildGeometryInfo, pBuildRangeInfos.data(), _vulkanContext->Dldi());
+}
+
+vk::AccelerationStructureGeometryKHR TopLevelAccelerationStructure::InstancesGeometry(const FrameStructure& frame) const
+{
+    vk::DeviceOrHostAddressConstKHR instanceDataDeviceAddress {};
+    instanceDataDeviceAddress.deviceAddress = _vulkanContext->GetBufferDeviceAddress(frame.instancesBuffer->buffer);
+
+    vk::AccelerationStructureGeometryKHR accelerationStructureGeometry {};
+    accelerationStructureGeometry.flags = vk::GeometryFlagBitsKHR::eOpaque;
+    accelerationStructureGeometry.geometryType = vk::GeometryTypeKHR::eInstances;
+    accelerationStructureGeometry.geometry.instances = vk::AccelerationStructureGeometryInstancesDataKHR {};
+    accelerationStructureGeometry.geometry.instances.arrayOfPointers = false;
+    accelerationStructureGeometry.geometry.instances.data = instanceDataDeviceAddress;
+
+    return accelerationStructureGeometry;
 }
@@ -117,6 +117,11 @@ VulkanContext::~VulkanContext()
 {
     _device.destroy(_descriptorPool);
 
+    for (const auto& [threadId, commandPool] : _threadCommandPools)
+    {
+        _device.destroy(commandPool);
+    }
+
     if (_validationLayersEnabled)
     {
         _instance.destroyDebugUtilsMessengerEXT(_debugMessenger, nullptr, _dldi);
@@ -128,6 +133,35 @@ VulkanContext::~VulkanContext()
     _instance.destroy();
 }
 
+vk::CommandPool VulkanContext::CommandPool() const
+{
+    const std::thread::id threadId = std::this_thread::get_id();
+    if (threadId == _mainThreadId)
+    {
+        return _commandPool;
+    }
+
+    std::lock_guard lock { _threadCommandPoolsMutex };
+    auto it = _threadCommandPools.find(threadId);
+    if (it == _threadCommandPools.end())
+    {
+        it = _threadCommandPools.emplace(threadId, CreateCommandPool()).first;
+    }
+
+    return it->second;
+}
+
+void VulkanContext::ReleaseThreadCommandPool()
+{
+    std::lock_guard lock { _threadCommandPoolsMutex };
+    auto it = _threadCommandPools.find(std::this_thread::get_id());
+    if (it != _threadCommandPools.end())
+    {
+        _device.destroy(it->second);
+        _threadCommandPools.erase(it);
+    }
+}
+
 vk::PhysicalDeviceRayTracingPipelinePropertiesKHR VulkanContext::RayTracingPipelineProperties() const
 {
     vk::PhysicalDeviceRayTracingPipelinePropertiesKHR rayTracingPipelineProperties {};
@@ -224,6 +258,11 @@ void VulkanContext::InitializePhysicalDevice()
     }
 
     _physicalDevice = candidates.rbegin()->second;
+
+    // Quantized hair vertices are unorm, which isn't one of the mandatory acceleration structure vertex formats
+    const vk::FormatProperties unormFormatProperties = _physicalDevice.getFormatProperties(vk::Format::eR16G16B16A16Unorm);
+    _unormVertexBuildSupported = static_cast<bool>(unormFormatProperties.bufferFeatures & vk::FormatFeatureFlagBits::eAccelerationStructureVertexBufferKHR);
+    spdlog::info("[VULKAN] Unorm acceleration structure vertices supported: {}", _unormVertexBuildSupported);
 }
 
 void VulkanContext::InitializeDevice()
@@ -265,6 +304,7 @@ void VulkanContext::InitializeDevice()
 
     auto& indexingFeatures = structureChain.get<vk::PhysicalDeviceDescriptorIndexingFeatures>();
     indexingFeatures.descriptorBindingPartiallyBound = true;
+    indexingFeatures.descriptorBindingUpdateUnusedWhilePending = true;
 
     auto& synchronization2Features = structureChain.get<vk::PhysicalDeviceSynchronization2Features>();
     synchronization2Features.synchronization2 = true;
@@ -289,12 +329,20 @@ void VulkanContext::InitializeDevice()
 }
 
 void VulkanContext::InitializeCommandPool()
+{
+    _mainThreadId = std::this_thread::get_id();
+    _commandPool = CreateCommandPool();
+}
+
+vk::CommandPool VulkanContext::CreateCommandPool() const
 {
     vk::CommandPoolCreateInfo commandPoolCreateInfo {};
     commandPoolCreateInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
     commandPoolCreateInfo.queueFamilyIndex = _queueFamilyIndices.graphicsFamily.value();
 
-    VkCheckResult(_device.createCommandPool(&commandPoolCreateInfo, nullptr, &_commandPool), "Failed creating command pool!");
+    vk::CommandPool commandPool {};
+    VkCheckResult(_device.createCommandPool(&commandPoolCreateInfo, nullptr, &commandPool), "Failed creating command pool!");
+    return commandPool;
 }
 
 void VulkanContext::InitializeVMA()
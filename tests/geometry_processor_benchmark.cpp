@@ -0,0 +1,63 @@
+#include "resources/model/geometry_processor.hpp"
+#include "hair_fixture.hpp"
+#include "job_system.hpp"
+#include "timer.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <spdlog/spdlog.h>
+#include <string_view>
+#include <vector>
+
+// Times ProcessHair for every hair technique on the generated hair of the tests, scaled up to a full groom.
+// Every run processes a freshly generated model, only the processing itself is timed.
+// Usage: GeometryProcessorBenchmark [runs], defaults to 5 runs per technique and thread count.
+
+static constexpr uint32_t MESH_COUNT = 4;
+static constexpr uint32_t STRANDS_PER_MESH = 25000;
+static constexpr uint32_t POINTS_PER_STRAND = 32;
+
+static constexpr std::array<std::pair<HairTechnique, std::string_view>, 5> TECHNIQUES { {
+    { HairTechnique::eDOTS, "DOTS" },
+    { HairTechnique::eLSS, "LSS" },
+    { HairTechnique::eCurves, "Curves" },
+    { HairTechnique::eVoxels, "Voxels" },
+    { HairTechnique::eTubes, "Tubes" },
+} };
+
+void BenchmarkTechnique(HairTechnique technique, std::string_view name, JobSystem& jobSystem, uint32_t runCount)
+{
+    // Processing logs every stage, only the timings are of interest here
+    spdlog::set_level(spdlog::level::warn);
+
+    std::vector<float> times {};
+    for (uint32_t run = 0; run < runCount; ++run)
+    {
+        ModelCreation model = CreateHairModel(MESH_COUNT, STRANDS_PER_MESH, POINTS_PER_STRAND);
+
+        const Timer timer {};
+        const ModelCreation processed = ProcessHair(std::move(model), jobSystem, technique, HairSettings {});
+        times.push_back(timer.GetElapsed().count());
+    }
+
+    spdlog::set_level(spdlog::level::info);
+
+    std::sort(times.begin(), times.end());
+    spdlog::info("[BENCHMARK] {} on {} threads: min {:.1f} ms, median {:.1f} ms over {} runs", name, jobSystem.ThreadCount(), times.front(), times[times.size() / 2], runCount);
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t runCount = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 5;
+
+    JobSystem serialJobSystem { 0 };
+    JobSystem jobSystem {};
+
+    for (const auto& [technique, name] : TECHNIQUES)
+    {
+        BenchmarkTechnique(technique, name, serialJobSystem, runCount);
+        BenchmarkTechnique(technique, name, jobSystem, runCount);
+    }
+
+    return 0;
+}
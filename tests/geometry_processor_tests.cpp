@@ -0,0 +1,226 @@
+#include "resources/model/geometry_processor.hpp"
+#include "resources/model/model.hpp"
+#include "resources/model/voxel_brick_map.hpp"
+#include "resources/model/voxel_occupancy_grid.hpp"
+#include "hair_fixture.hpp"
+#include "job_system.hpp"
+#include <algorithm>
+#include <set>
+#include <spdlog/spdlog.h>
+#include <tuple>
+#include <vector>
+
+// Checks the CPU side of hair processing, no Vulkan device is created.
+// Every check logs its failure and the process returns the number of failed checks, so CTest reports them.
+
+static uint32_t failedChecks = 0;
+
+#define CHECK(condition)                                                                          \
+    do                                                                                            \
+    {                                                                                             \
+        if (!(condition))                                                                         \
+        {                                                                                         \
+            spdlog::error("[TESTS] Check failed at {}:{}: {}", __FILE__, __LINE__, #condition); \
+            failedChecks++;                                                                       \
+        }                                                                                         \
+    } while (false)
+
+using Points = std::vector<glm::vec3>;
+
+std::vector<Points> SplitStrands(const StrandBuffer& strands)
+{
+    std::vector<Points> split(strands.StrandCount());
+    for (uint32_t strandIndex = 0; strandIndex < strands.StrandCount(); ++strandIndex)
+    {
+        const StrandPoints strand = strands.Strand(strandIndex);
+        for (uint32_t i = 0; i < strand.count; ++i)
+        {
+            split[strandIndex].push_back(strand.Point(i));
+        }
+    }
+
+    return split;
+}
+
+bool PointsLess(const Points& a, const Points& b)
+{
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), [](const glm::vec3& pointA, const glm::vec3& pointB)
+        { return std::tie(pointA.x, pointA.y, pointA.z) < std::tie(pointB.x, pointB.y, pointB.z); });
+}
+
+// Every strand point of the full detail level is stored once and every segment refers to its first point,
+// so the strands can be recovered by breaking them after every point without an index
+void TestLinearSweptSpheres(JobSystem& jobSystem)
+{
+    constexpr uint32_t strandCount = 40;
+    const HairSettings settings {};
+    ModelCreation source = CreateHairModel(1, strandCount, 24, { { 0, 1 }, { 7, 1 }, { 13, 2 }, { strandCount - 1, 1 } });
+
+    HairStageCache resampling {};
+    resampling.SetMeshCount(1);
+    std::vector<Points> expectedStrands = SplitStrands(resampling.ResampledStrands(0, source.strandBuffers[0], settings.maxStrandDeviation, jobSystem));
+
+    const ModelCreation lss = ProcessHair(std::move(source), jobSystem, HairTechnique::eLSS, settings);
+    const SceneGraph& sceneGraph = *lss.sceneGraph;
+    CHECK(sceneGraph.lssMeshes.size() == sceneGraph.lodLevelCount);
+
+    // Positions and indices are only stored by the segment levels, pruned levels view those of the coarsest segment level.
+    // Every level stores its own radii.
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    uint32_t radiusCount = 0;
+    for (const LSSMesh& lssMesh : sceneGraph.lssMeshes)
+    {
+        radiusCount += lssMesh.vertexCount;
+        if (lssMesh.firstVertex + lssMesh.vertexCount > vertexCount)
+        {
+            vertexCount += lssMesh.vertexCount;
+            indexCount += lssMesh.indexCount;
+        }
+    }
+    CHECK(lss.lssPositionBuffer.size() == vertexCount);
+    CHECK(lss.lssIndexBuffer.size() == indexCount);
+    CHECK(lss.lssRadiusBuffer.size() == radiusCount);
+
+    const LSSMesh& fullDetail = sceneGraph.lssMeshes[0];
+    CHECK(fullDetail.indexCount == fullDetail.vertexCount - strandCount);
+
+    std::set<uint32_t> segmentStarts {};
+    for (uint32_t i = 0; i < fullDetail.indexCount; ++i)
+    {
+        const uint32_t index = lss.lssIndexBuffer[fullDetail.firstIndex + i];
+        CHECK(index + 1 < fullDetail.vertexCount);
+        CHECK(i == 0 || index > lss.lssIndexBuffer[fullDetail.firstIndex + i - 1]);
+        segmentStarts.insert(index);
+    }
+
+    std::vector<Points> strands(1);
+    for (uint32_t i = 0; i < fullDetail.vertexCount; ++i)
+    {
+        strands.back().push_back(lss.lssPositionBuffer[fullDetail.firstVertex + i]);
+        if (!segmentStarts.contains(i) && i + 1 < fullDetail.vertexCount)
+        {
+            strands.emplace_back();
+        }
+    }
+
+    // Strands are reordered for the levels of detail, but keep their points
+    std::sort(strands.begin(), strands.end(), PointsLess);
+    std::sort(expectedStrands.begin(), expectedStrands.end(), PointsLess);
+    CHECK(strands == expectedStrands);
+    CHECK(std::count_if(strands.begin(), strands.end(), [](const Points& strand)
+              { return strand.size() == 1; })
+        == 3);
+}
+
+// Voxelizing with atomic ORs from many threads into the sparse brick map has to set the same voxels as the serial reference,
+// which fills a dense grid without atomics
+void TestVoxelization(JobSystem& jobSystem, VoxelizationMode mode)
+{
+    HairSettings settings {};
+    settings.radius = 0.01f;
+    settings.voxelSize = 0.02f;
+    settings.voxelization = mode;
+
+    const ModelCreation model = CreateHairModel(1, 300, 32);
+    const StrandBuffer& strands = model.strandBuffers[0];
+    const AABB& bounds = model.sceneGraph->meshes[0].boundingBox;
+
+    const VoxelBrickMap parallel = VoxelizeHairStrands(strands, bounds, settings, jobSystem);
+    const VoxelOccupancyGrid serial = VoxelizeHairStrandsSerial(strands, bounds, settings);
+
+    CHECK(parallel.Resolution() == serial.Resolution());
+    CHECK(serial.FilledCount() > 0);
+    CHECK(parallel.FilledCount() == serial.FilledCount());
+    CHECK(std::ranges::equal(parallel.ToDense().Words(), serial.Words()));
+}
+
+// Voxel meshes of a model, with the voxels of every level decoded from the brick buffers
+std::vector<std::vector<std::set<std::tuple<int32_t, int32_t, int32_t>>>> DecodeVoxelLevels(const ModelCreation& voxels)
+{
+    std::vector<std::vector<std::set<std::tuple<int32_t, int32_t, int32_t>>>> meshes {};
+    for (const VoxelMesh& voxelMesh : voxels.sceneGraph->voxelMeshes)
+    {
+        auto& levels = meshes.emplace_back();
+        for (const VoxelLevel& voxelLevel : voxelMesh.levels)
+        {
+            auto& filled = levels.emplace_back();
+            const glm::ivec3 brickResolution = (voxelLevel.resolution + VoxelBrick::SIZE - 1) / VoxelBrick::SIZE;
+            const uint32_t brickIndexCount = brickResolution.x * brickResolution.y * brickResolution.z;
+            for (uint32_t brickIndex = 0; brickIndex < brickIndexCount; ++brickIndex)
+            {
+                const uint32_t brick = voxels.voxelBrickIndexBuffer[voxelLevel.firstBrickIndex + brickIndex];
+                if (brick == VoxelBrickMap::EMPTY_BRICK)
+                {
+                    continue;
+                }
+
+                const uint32_t brickRow = brickIndex / brickResolution.x;
+                const glm::ivec3 brickOrigin = glm::ivec3(brickIndex % brickResolution.x, brickRow % brickResolution.y, brickRow / brickResolution.y) * VoxelBrick::SIZE;
+                const VoxelBrick& voxelBrick = voxels.voxelBrickBuffer[voxelLevel.firstBrick + brick];
+                for (int32_t z = 0; z < VoxelBrick::SIZE; ++z)
+                {
+                    for (int32_t bit = 0; bit < VoxelBrick::SIZE * VoxelBrick::SIZE; ++bit)
+                    {
+                        if (voxelBrick.words[z] & (uint64_t { 1 } << bit))
+                        {
+                            filled.emplace(brickOrigin.x + bit % VoxelBrick::SIZE, brickOrigin.y + bit / VoxelBrick::SIZE, brickOrigin.z + z);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return meshes;
+}
+
+// Every level of the occupancy pyramid has to be the first level reduced to its resolution, down to a single voxel
+void TestVoxelPyramid(JobSystem& jobSystem)
+{
+    HairSettings settings {};
+    settings.radius = 0.01f;
+    settings.voxelSize = 0.02f;
+
+    const ModelCreation voxels = ProcessHair(CreateHairModel(2, 300, 32), jobSystem, HairTechnique::eVoxels, settings);
+    const auto meshes = DecodeVoxelLevels(voxels);
+    CHECK(meshes.size() == 2);
+
+    for (uint32_t meshIndex = 0; meshIndex < meshes.size(); ++meshIndex)
+    {
+        const VoxelMesh& voxelMesh = voxels.sceneGraph->voxelMeshes[meshIndex];
+        const auto& levels = meshes[meshIndex];
+        CHECK(!levels.empty() && !levels[0].empty());
+        CHECK(levels.back().size() == 1);
+
+        for (uint32_t level = 0; level < levels.size(); ++level)
+        {
+            std::set<std::tuple<int32_t, int32_t, int32_t>> reduced {};
+            for (const auto& [x, y, z] : levels[0])
+            {
+                reduced.emplace(x >> level, y >> level, z >> level);
+            }
+
+            CHECK(levels[level] == reduced);
+            CHECK(voxelMesh.levels[level].filledVoxelCount == levels[level].size());
+            CHECK(voxelMesh.levels[level].aabbCount == levels[level].size());
+        }
+    }
+}
+
+int main()
+{
+    JobSystem jobSystem { 7 };
+
+    TestLinearSweptSpheres(jobSystem);
+    TestVoxelization(jobSystem, VoxelizationMode::eExact);
+    TestVoxelization(jobSystem, VoxelizationMode::eConservativeBox);
+    TestVoxelPyramid(jobSystem);
+
+    if (failedChecks > 0)
+    {
+        spdlog::error("[TESTS] {} checks failed", failedChecks);
+    }
+
+    return failedChecks;
+}
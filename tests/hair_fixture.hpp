@@ -0,0 +1,49 @@
+#pragma once
+#include "resources/model/model.hpp"
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Helical strands growing from a ring, every mesh gets its own ring. The strands listed in shortStrands get the given point count instead.
+inline ModelCreation CreateHairModel(uint32_t meshCount, uint32_t strandCount, uint32_t pointsPerStrand, const std::vector<std::pair<uint32_t, uint32_t>>& shortStrands = {})
+{
+    ModelCreation modelCreation {};
+    modelCreation.sceneGraph = std::make_shared<SceneGraph>();
+    modelCreation.sceneGraph->sceneName = "Test Hair";
+
+    for (uint32_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+    {
+        Mesh& mesh = modelCreation.sceneGraph->meshes.emplace_back();
+        mesh.primitiveType = Mesh::PrimitiveType::eLines;
+        mesh.boundingBox = { glm::vec3 { std::numeric_limits<float>::max() }, glm::vec3 { std::numeric_limits<float>::lowest() } };
+
+        StrandBuffer& strands = modelCreation.strandBuffers.emplace_back();
+        for (uint32_t strandIndex = 0; strandIndex < strandCount; ++strandIndex)
+        {
+            uint32_t pointCount = pointsPerStrand;
+            for (const auto& [shortStrand, shortPointCount] : shortStrands)
+            {
+                pointCount = shortStrand == strandIndex ? shortPointCount : pointCount;
+            }
+
+            const float angle = 6.2831853f * static_cast<float>(strandIndex) / static_cast<float>(strandCount);
+            const glm::vec3 root { std::cos(angle) * 0.5f + static_cast<float>(meshIndex), 0.0f, std::sin(angle) * 0.5f };
+
+            strands.AddStrand();
+            for (uint32_t i = 0; i < pointCount; ++i)
+            {
+                const float t = static_cast<float>(i) * 0.1f;
+                const glm::vec3 point = root + glm::vec3 { std::cos(angle + t) * 0.05f * t, -t * 0.3f, std::sin(angle + t) * 0.05f * t };
+                strands.AddPoint(point);
+                mesh.boundingBox.min = glm::min(mesh.boundingBox.min, point);
+                mesh.boundingBox.max = glm::max(mesh.boundingBox.max, point);
+            }
+        }
+
+        Node& node = modelCreation.sceneGraph->nodes.emplace_back();
+        node.meshes.push_back(meshIndex);
+    }
+
+    return modelCreation;
+}